@@ -10,10 +10,48 @@ namespace Sine::Env {
     }
 
     void GenericGraphic::render(RenderingContext &p) {
-        p.mixImage<ColorUtils::ColorMix::MERGE>(*this, xmin, ymin);
+        renderRegion(p, xmin, ymin, xmin + width, ymin + height);
+    }
 
-        if (show_border) {
+    void GenericGraphic::renderRegion(RenderingContext &p, int x1, int y1, int x2, int y2) {
+        // The border stays on the canvas once drawn, so it only needs drawing again after a change
+        if (show_border && isDirty()) {
             drawLine(0, 0, width, height);
         }
+
+        x1 = std::max({x1, xmin, 0});
+        y1 = std::max({y1, ymin, 0});
+        x2 = std::min({x2, xmin + width, p.getWidth()});
+        y2 = std::min({y2, ymin + height, p.getHeight()});
+
+        if (x1 < x2 && y1 < y2) {
+            auto merge = ColorUtils::Functors::MERGE; // As mixImage<ColorMix::MERGE> mixes
+
+            p.markDirty(x1, y1, x2, y2);
+
+            for (int j = y1; j < y2; j++) {
+                for (int i = x1; i < x2; i++) {
+                    merge(p.getPixelUnsafe(i, j), getPixelUnsafe(i - xmin, j - ymin));
+                }
+            }
+        }
+
+        // Only now, after the border, is everything drawn
+        clearDirty();
+    }
+
+    void GenericGraphic::getBounds(int &x1, int &y1, int &x2, int &y2) const {
+        x1 = xmin;
+        y1 = ymin;
+        x2 = xmin + width;
+        y2 = ymin + height;
+    }
+
+    bool GenericGraphic::clipsToRegion() const {
+        return true;
+    }
+
+    bool GenericGraphic::needsRender() const {
+        return isDirty();
     }
 }
\ No newline at end of file
@@ -34,6 +34,30 @@ namespace Sine::Env {
          * @param ctx Context to render to.
          */
         void render(RenderingContext &ctx) override;
+
+        /**
+         * Mixes in the part of the Graphic inside a rectangle of the context.
+         * @param ctx Context to render to.
+         * @param x1 Left edge, inclusive.
+         * @param y1 Top edge, inclusive.
+         * @param x2 Right edge, exclusive.
+         * @param y2 Bottom edge, exclusive.
+         */
+        void renderRegion(RenderingContext &ctx, int x1, int y1, int x2, int y2) override;
+
+        /**
+         * The Graphic clips its mix to the rectangle given to renderRegion.
+         * @return True.
+         */
+        bool clipsToRegion() const override;
+
+        void getBounds(int &x1, int &y1, int &x2, int &y2) const override;
+
+        /**
+         * The Graphic needs rendering whenever its canvas is dirty.
+         * @return Whether the canvas changed since the last render.
+         */
+        bool needsRender() const override;
     };
 }
 
@@ -5,6 +5,8 @@
 #ifndef VISUALIZATION_GRAPHIC_H
 #define VISUALIZATION_GRAPHIC_H
 
+#include <limits>
+
 namespace Sine::Env {
     class RenderingContext;
 
@@ -18,6 +20,50 @@ namespace Sine::Env {
          * @param ctx Context to render to.
          */
         virtual void render(RenderingContext &ctx) = 0;
+
+        /**
+         * Whether the graphic changed since it was last rendered. Graphics which cannot tell always need rendering.
+         * @return Whether render should be called.
+         */
+        virtual bool needsRender() const {
+            return true;
+        }
+
+        /**
+         * Whether renderRegion draws only inside the rectangle it is given. The context calls renderRegion for every
+         * dirty rectangle such a graphic overlaps, and render once for any other graphic overlapping the region.
+         * @return Whether the graphic clips to a region.
+         */
+        virtual bool clipsToRegion() const {
+            return false;
+        }
+
+        /**
+         * Renders the part of a graphic inside the rectangle [x1, x2) x [y1, y2) of the context. Graphics which cannot
+         * clip render in full, and should leave clipsToRegion false.
+         * @param ctx Context to render to.
+         * @param x1 Left edge, inclusive.
+         * @param y1 Top edge, inclusive.
+         * @param x2 Right edge, exclusive.
+         * @param y2 Bottom edge, exclusive.
+         */
+        virtual void renderRegion(RenderingContext &ctx, [[maybe_unused]] int x1, [[maybe_unused]] int y1,
+                                  [[maybe_unused]] int x2, [[maybe_unused]] int y2) {
+            render(ctx);
+        }
+
+        /**
+         * Rectangle [x1, x2) x [y1, y2) of the context the graphic draws to. Graphics which cannot tell cover
+         * everything.
+         * @param x1 Left edge, inclusive.
+         * @param y1 Top edge, inclusive.
+         * @param x2 Right edge, exclusive.
+         * @param y2 Bottom edge, exclusive.
+         */
+        virtual void getBounds(int &x1, int &y1, int &x2, int &y2) const {
+            x1 = y1 = std::numeric_limits<int>::min();
+            x2 = y2 = std::numeric_limits<int>::max();
+        }
     };
 }
 
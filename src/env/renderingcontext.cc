@@ -3,6 +3,7 @@
 //
 
 #include "renderingcontext.h"
+#include <array>
 
 namespace Sine::Env {
     using namespace Sine;
@@ -32,8 +33,38 @@ namespace Sine::Env {
     }
 
     void RenderingContext::render() {
+        // The region to redraw: whatever changed on the context itself, plus wherever a graphic changed
         for (auto &g: graphics) {
-            g.second->render(*this);
+            if (g.second->needsRender()) {
+                int x1, y1, x2, y2;
+                g.second->getBounds(x1, y1, x2, y2);
+                markDirty(x1, y1, x2, y2);
+            }
+        }
+
+        std::vector<std::array<int, 4>> region;
+
+        forEachDirtyRect([&](int x1, int y1, int x2, int y2) {
+            region.push_back({x1, y1, x2, y2});
+        });
+
+        // Every graphic overlapping the region is drawn again, in order, so overlaps keep their stacking and blending
+        for (auto &g: graphics) {
+            int x1, y1, x2, y2;
+            g.second->getBounds(x1, y1, x2, y2);
+
+            bool clips = g.second->clipsToRegion();
+
+            for (const auto &r : region) {
+                if (x1 < r[2] && y1 < r[3] && x2 > r[0] && y2 > r[1]) {
+                    if (!clips) { // Drawn in full, so once is enough
+                        g.second->render(*this);
+                        break;
+                    }
+
+                    g.second->renderRegion(*this, r[0], r[1], r[2], r[3]);
+                }
+            }
         }
     }
 
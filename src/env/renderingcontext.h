@@ -59,7 +59,10 @@ namespace Sine::Env {
         explicit RenderingContext(const Canvas &p);
 
         /**
-         * Function called to render the context.
+         * Function called to render the context. Only the dirty region is redrawn: the tiles changed on the context
+         * since the last clearDirty(), plus the bounds of every graphic which needs rendering. Every graphic
+         * overlapping that region is rendered again in order, clipped to it. The region stays dirty, so callers can
+         * consume it and call clearDirty().
          */
         void render();
 
@@ -7,6 +7,8 @@
 
 
 #include "line.h"
+#include <algorithm>
+#include <limits>
 
 namespace Sine::Graphics::Algorithms {
     /**
@@ -219,5 +221,32 @@ namespace Sine::Graphics::Algorithms {
         }
         drawQuadraticBezierSegmentAntialiased(x0, y0, x1, y1, x2, y2, f);
     }
+
+    /**
+     * Bounding box of the pixels plotted by drawQuadraticBezier, or by drawQuadraticBezierAntialiased if antialiased
+     * is set. The rasterizers round their way through the curve and can stray several pixels outside the convex hull
+     * of the control points, so the box is found by running them rather than from the hull.
+     * @return Inclusive box x1, y1, x2, y2; x1 > x2 if nothing is plotted.
+     */
+    inline std::tuple<int, int, int, int> quadraticBezierExtent(float x0, float y0, float x1, float y1, float x2,
+                                                                float y2, bool antialiased) {
+        int b_x1 = std::numeric_limits<int>::max(), b_y1 = std::numeric_limits<int>::max();
+        int b_x2 = std::numeric_limits<int>::min(), b_y2 = std::numeric_limits<int>::min();
+
+        auto grow = [&](int x, int y) {
+            b_x1 = std::min(b_x1, x);
+            b_y1 = std::min(b_y1, y);
+            b_x2 = std::max(b_x2, x);
+            b_y2 = std::max(b_y2, y);
+        };
+
+        if (antialiased) {
+            drawQuadraticBezierAntialiased(x0, y0, x1, y1, x2, y2, [&](int x, int y, float) { grow(x, y); });
+        } else {
+            drawQuadraticBezier(x0, y0, x1, y1, x2, y2, grow);
+        }
+
+        return std::make_tuple(b_x1, b_y1, b_x2, b_y2);
+    }
 }
 #endif //VISUALIZATION_BEZIER_H
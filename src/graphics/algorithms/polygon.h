@@ -0,0 +1,81 @@
+#ifndef VISUALIZATION_ALGORITHMS_POLYGON_H
+#define VISUALIZATION_ALGORITHMS_POLYGON_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Sine::Graphics::Algorithms {
+    /**
+     * Fill a polygon with the even-odd rule, sampling at pixel centers and skipping pixels outside a rectangle.
+     * @tparam Func Type of functor to yield points to.
+     * @param points Vertices of the polygon as (x, y), implicitly closed.
+     * @param r_x1 Left edge of the rectangle, inclusive.
+     * @param r_y1 Top edge of the rectangle, inclusive.
+     * @param r_x2 Right edge of the rectangle, exclusive.
+     * @param r_y2 Bottom edge of the rectangle, exclusive.
+     * @param f Functor called as f(x, y) for every filled pixel.
+     */
+    template<typename Func>
+    inline void drawMaskedFilledPolygon(const std::vector<std::pair<float, float>> &points, int r_x1, int r_y1,
+                                        int r_x2, int r_y2, Func f) {
+        size_t count = points.size();
+        if (count < 3) return;
+
+        float minY = points[0].second, maxY = points[0].second;
+
+        for (const auto &p : points) {
+            minY = std::min(minY, p.second);
+            maxY = std::max(maxY, p.second);
+        }
+
+        if (!(minY < r_y2 && maxY >= r_y1)) return; // Also rejects NaN
+
+        int y_start = std::max(static_cast<int>(std::floor(minY)), r_y1);
+        int y_end = std::min(static_cast<int>(std::ceil(maxY)), r_y2 - 1);
+
+        std::vector<float> crossings;
+
+        for (int y = y_start; y <= y_end; y++) {
+            float sample_y = y + 0.5f; // Sample at pixel center
+            crossings.clear();
+
+            for (size_t i = 0, j = count - 1; i < count; j = i++) {
+                float y1 = points[i].second, y2 = points[j].second;
+
+                // Half-open test so vertices shared by two edges are only counted once
+                if ((y1 <= sample_y) != (y2 <= sample_y)) {
+                    float x1 = points[i].first, x2 = points[j].first;
+                    crossings.push_back(x1 + (sample_y - y1) * (x2 - x1) / (y2 - y1));
+                }
+            }
+
+            std::sort(crossings.begin(), crossings.end());
+
+            for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+                float x_start = std::max(std::ceil(crossings[k] - 0.5f), static_cast<float>(r_x1));
+                float x_end = std::min(std::ceil(crossings[k + 1] - 0.5f), static_cast<float>(r_x2));
+
+                for (int x = x_start; x < x_end; x++) {
+                    f(x, y);
+                }
+            }
+        }
+    }
+
+    /**
+     * Fill a polygon with the even-odd rule, sampling at pixel centers.
+     * @tparam Func Type of functor to yield points to.
+     * @param points Vertices of the polygon as (x, y), implicitly closed.
+     * @param f Functor called as f(x, y) for every filled pixel.
+     */
+    template<typename Func>
+    inline void drawFilledPolygon(const std::vector<std::pair<float, float>> &points, Func f) {
+        drawMaskedFilledPolygon(points, std::numeric_limits<int>::min() / 2, std::numeric_limits<int>::min() / 2,
+                                std::numeric_limits<int>::max() / 2, std::numeric_limits<int>::max() / 2, f);
+    }
+}
+
+#endif //VISUALIZATION_ALGORITHMS_POLYGON_H
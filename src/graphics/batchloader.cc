@@ -0,0 +1,249 @@
+#include "batchloader.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Sine::Graphics {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        double secondsSince(Clock::time_point start) {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        /**
+         * Asks the kernel to start reading a file into the page cache.
+         */
+        void prefetch(const std::string &path) {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            close(fd);
+        }
+
+        std::vector<uint8_t> readFile(const std::string &path) {
+            int fd = open(path.c_str(), O_RDONLY);
+
+            if (fd < 0) {
+                throw std::runtime_error("Image does not exist or is inaccessible.");
+            }
+
+            struct stat info{};
+            std::vector<uint8_t> ret;
+
+            if (fstat(fd, &info) == 0 && info.st_size > 0) ret.reserve(info.st_size);
+
+            uint8_t buffer[1 << 16];
+            ssize_t n;
+
+            while ((n = read(fd, buffer, sizeof(buffer))) != 0) {
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+
+                    close(fd);
+                    throw std::runtime_error("Could not read image.");
+                }
+
+                ret.insert(ret.end(), buffer, buffer + n);
+            }
+
+            close(fd);
+
+            return ret;
+        }
+    }
+
+    template<class P>
+    BatchLoader<P>::BatchLoader(std::vector<std::string> _paths, Order _order, unsigned int threads, size_t _budget,
+                                unsigned int _readahead)
+            : paths(std::move(_paths)), order(_order), budget(_budget), readahead(_readahead) {
+        threads = std::max(threads, 1U);
+
+        reader = std::thread(&BatchLoader::readFiles, this);
+        decoders.reserve(threads);
+
+        for (unsigned int i = 0; i < threads; i++) {
+            decoders.emplace_back(&BatchLoader::decodeFiles, this);
+        }
+    }
+
+    template<class P>
+    BatchLoader<P>::~BatchLoader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        roomAvailable.notify_all();
+        fileAvailable.notify_all();
+
+        reader.join();
+
+        for (auto &decoder : decoders) {
+            decoder.join();
+        }
+    }
+
+    template<class P>
+    size_t BatchLoader<P>::pixelBytes(const Result &result) {
+        return result.image ? result.image->getArea() * sizeof(typename P::PixelType) : 0;
+    }
+
+    template<class P>
+    void BatchLoader<P>::readFiles() {
+        size_t prefetched = 0;
+
+        for (size_t i = 0; i < paths.size(); i++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                // Always allow one file, or a file larger than the budget would never be read
+                roomAvailable.wait(lock, [&]() { return stopping || bytesHeld < budget || bytesHeld == 0; });
+
+                if (stopping) return;
+            }
+
+            for (; prefetched < std::min(paths.size(), i + 1 + readahead); prefetched++) {
+                if (prefetched > i) prefetch(paths[prefetched]);
+            }
+
+            File file{i, {}, 0, nullptr};
+            Clock::time_point start = Clock::now();
+
+            try {
+                file.bytes = readFile(paths[i]);
+            } catch (...) {
+                file.error = std::current_exception();
+            }
+
+            file.readSeconds = secondsSince(start);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                bytesHeld += file.bytes.size();
+                files.push_back(std::move(file));
+            }
+
+            fileAvailable.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            readingDone = true;
+        }
+
+        fileAvailable.notify_all();
+    }
+
+    template<class P>
+    void BatchLoader<P>::decodeFiles() {
+        while (true) {
+            File file;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                fileAvailable.wait(lock, [&]() { return stopping || !files.empty() || readingDone; });
+
+                if (stopping || files.empty()) return;
+
+                file = std::move(files.front());
+                files.pop_front();
+            }
+
+            Result result;
+            result.index = file.index;
+            result.path = paths[file.index];
+            result.fileBytes = file.bytes.size();
+            result.readSeconds = file.readSeconds;
+            result.error = file.error;
+
+            if (!result.error) {
+                Clock::time_point start = Clock::now();
+
+                try {
+                    result.image.emplace(ImageLoader<P>::loadFromMemory(file.bytes));
+                } catch (...) {
+                    result.error = std::current_exception();
+                }
+
+                result.decodeSeconds = secondsSince(start);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                // The file's bytes are freed as the pixels are kept
+                bytesHeld += pixelBytes(result);
+                bytesHeld -= file.bytes.size();
+                results.emplace(result.index, std::move(result));
+            }
+
+            file.bytes = std::vector<uint8_t>();
+
+            resultAvailable.notify_all();
+            roomAvailable.notify_one();
+        }
+    }
+
+    template<class P>
+    std::optional<typename BatchLoader<P>::Result> BatchLoader<P>::next() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (delivered == paths.size()) return std::nullopt;
+
+        auto ready = [&]() {
+            return order == Order::IN_ORDER ? results.find(delivered) : results.begin();
+        };
+
+        resultAvailable.wait(lock, [&]() { return ready() != results.end(); });
+
+        auto it = ready();
+        Result ret = std::move(it->second);
+        results.erase(it);
+
+        delivered++;
+        bytesHeld -= pixelBytes(ret);
+
+        lock.unlock();
+        roomAvailable.notify_one();
+
+        return ret;
+    }
+
+    template<class P>
+    size_t BatchLoader<P>::size() const {
+        return paths.size();
+    }
+
+    template<class P>
+    std::vector<typename BatchLoader<P>::Result> BatchLoader<P>::loadAll(std::vector<std::string> paths,
+                                                                          unsigned int threads) {
+        BatchLoader loader(std::move(paths), Order::IN_ORDER, threads);
+        std::vector<Result> ret;
+        ret.reserve(loader.size());
+
+        while (auto result = loader.next()) {
+            ret.push_back(std::move(*result));
+        }
+
+        return ret;
+    }
+
+    // Explicit template instantiation
+    template
+    class BatchLoader<Bitmap>;
+
+    template
+    class BatchLoader<Graymap>;
+
+    template
+    class BatchLoader<RGBMap>;
+
+    template
+    class BatchLoader<RGBAMap>;
+}
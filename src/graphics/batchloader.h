@@ -0,0 +1,140 @@
+#ifndef VISUALIZATION_BATCHLOADER_H
+#define VISUALIZATION_BATCHLOADER_H
+
+#include "imageloader.h"
+#include "parallel.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Sine::Graphics {
+    /**
+     * Loads a list of image files on background threads.
+     *
+     * One thread reads whole files into memory in list order, hinting the kernel to fetch the next few files ahead of
+     * it, while a pool of threads decodes what has been read with ImageLoader::loadFromMemory. Reading pauses while
+     * the bytes read but not decoded plus the pixels decoded but not yet taken exceed a memory budget, so a slow
+     * consumer never holds more than about that much. Results are taken with next(), in list order or as they
+     * complete.
+     * @tparam P Pixmap type.
+     */
+    template<class P>
+    class BatchLoader {
+    public:
+        /**
+         * Order in which next() returns results.
+         */
+        enum class Order {
+            IN_ORDER, ///< Order of the list of paths
+            AS_COMPLETED ///< Whichever file finished first
+        };
+
+        /**
+         * Outcome of loading one file.
+         */
+        struct Result {
+            size_t index = 0; ///< Position in the list of paths
+            std::string path;
+            std::optional<P> image; ///< Empty if loading failed
+            std::exception_ptr error; ///< Why loading failed, or nullptr
+            size_t fileBytes = 0;
+            double readSeconds = 0;
+            double decodeSeconds = 0;
+
+            /**
+             * Whether the image loaded.
+             * @return Whether image holds the image.
+             */
+            bool ok() const {
+                return image.has_value();
+            }
+        };
+
+        static constexpr size_t DEFAULT_BUDGET = 256 << 20;
+
+    private:
+        struct File {
+            size_t index;
+            std::vector<uint8_t> bytes;
+            double readSeconds;
+            std::exception_ptr error;
+        };
+
+        std::vector<std::string> paths;
+        Order order;
+        size_t budget;
+        unsigned int readahead;
+
+        std::mutex mutex;
+        std::condition_variable roomAvailable; ///< Reader waits for the budget
+        std::condition_variable fileAvailable; ///< Decoders wait for files
+        std::condition_variable resultAvailable; ///< next() waits for results
+
+        std::deque<File> files; ///< Read and waiting to be decoded
+        std::map<size_t, Result> results; ///< Decoded and waiting to be taken, by index
+        size_t bytesHeld = 0; ///< Bytes counted against the budget
+        size_t delivered = 0;
+        bool readingDone = false;
+        bool stopping = false;
+
+        std::thread reader;
+        std::vector<std::thread> decoders;
+
+        void readFiles();
+
+        void decodeFiles();
+
+        static size_t pixelBytes(const Result &result);
+
+    public:
+        /**
+         * Constructor, which starts loading at once.
+         * @param paths Paths of the files.
+         * @param order Order of the results.
+         * @param threads Number of decoding threads.
+         * @param budget Bytes of files and pixels held before reading pauses; at least one file is always read.
+         * @param readahead Number of files past the one being read to ask the kernel to prefetch.
+         */
+        explicit BatchLoader(std::vector<std::string> paths, Order order = Order::IN_ORDER,
+                             unsigned int threads = Parallel::threadCount(), size_t budget = DEFAULT_BUDGET,
+                             unsigned int readahead = 8);
+
+        BatchLoader(const BatchLoader &) = delete;
+
+        BatchLoader &operator=(const BatchLoader &) = delete;
+
+        /**
+         * Destructor, which abandons files not yet loaded.
+         */
+        ~BatchLoader();
+
+        /**
+         * Waits for the next result.
+         * @return The result, or nothing once every file's result was returned.
+         */
+        std::optional<Result> next();
+
+        /**
+         * Getter for size.
+         * @return Number of files.
+         */
+        size_t size() const;
+
+        /**
+         * Loads every file in parallel.
+         * @param paths Paths of the files.
+         * @param threads Number of decoding threads.
+         * @return Results in the order of paths.
+         */
+        static std::vector<Result> loadAll(std::vector<std::string> paths,
+                                           unsigned int threads = Parallel::threadCount());
+    };
+}
+
+#endif //VISUALIZATION_BATCHLOADER_H
@@ -4,10 +4,14 @@
 
 #include <graphics/algorithms/circle.h>
 #include <graphics/algorithms/thickener.h>
+#include <graphics/algorithms/polygon.h>
 #include "canvas.h"
 #include "graphics/algorithms/line.h"
 #include "graphics/algorithms/bezier.h"
 #include "filters/gaussian_blur.h"
+#include "parallel.h"
+#include "resampler.h"
+#include "simd/kernels.h"
 
 namespace Sine::Graphics {
     Canvas::Canvas(int width, int height) : Pixmap<RGBA>(width, height) {
@@ -48,6 +52,7 @@ namespace Sine::Graphics {
 
     void Canvas::fill(Color color) {
         std::fill_n(pixels, area, color.rgba());
+        markAllDirty();
     }
 
     void Canvas::clear() {
@@ -56,7 +61,7 @@ namespace Sine::Graphics {
 
     Canvas &Canvas::operator=(const Canvas &c) {
         if (c.getArea() != area) {
-            delete[] pixels;
+            releasePixels();
             pixels = new RGBA[c.getArea()];
             area = c.getArea();
         }
@@ -68,6 +73,8 @@ namespace Sine::Graphics {
         width = c.getWidth();
         height = c.getHeight();
 
+        resizeDirtyTiles();
+
         return *this;
     };
 
@@ -75,17 +82,101 @@ namespace Sine::Graphics {
      * Use Pixmap<RGBA> assignment, copy, move operators
      */
     Canvas &Canvas::operator=(Canvas &&c) noexcept {
-        delete[] pixels;
-
-        pixels = c.pixels;
-        c.pixels = nullptr;
+        Pixmap<RGBA>::operator=(std::move(c));
 
-        width = c.getWidth();
-        height = c.getHeight();
+        // Take over the mask of c, which already has the right size, so nothing is allocated
+        dirtyTilesX = c.dirtyTilesX;
+        dirtyTilesY = c.dirtyTilesY;
+        dirtyTiles.swap(c.dirtyTiles);
+        markAllDirty();
 
         return *this;
     };
 
+    std::vector<uint64_t> Canvas::allDirtyTiles(int count) {
+        std::vector<uint64_t> mask((count + 63) / 64, ~uint64_t(0));
+
+        if (count % 64 != 0) { // Keep bits past the last tile clear so counting stays exact
+            mask.back() = (uint64_t(1) << (count % 64)) - 1;
+        }
+
+        return mask;
+    }
+
+    void Canvas::resizeDirtyTiles() {
+        dirtyTilesX = (width + DirtyTileSize - 1) / DirtyTileSize;
+        dirtyTilesY = (height + DirtyTileSize - 1) / DirtyTileSize;
+
+        dirtyTiles = allDirtyTiles(dirtyTilesX * dirtyTilesY);
+    }
+
+    void Canvas::markDirty(int x1, int y1, int x2, int y2) {
+        x1 = std::max(x1, 0);
+        y1 = std::max(y1, 0);
+        x2 = std::min(x2, width);
+        y2 = std::min(y2, height);
+
+        if (x1 >= x2 || y1 >= y2) return;
+
+        for (int t_y = y1 / DirtyTileSize; t_y <= (y2 - 1) / DirtyTileSize; t_y++) {
+            for (int t_x = x1 / DirtyTileSize; t_x <= (x2 - 1) / DirtyTileSize; t_x++) {
+                int index = t_y * dirtyTilesX + t_x;
+                dirtyTiles[index >> 6] |= uint64_t(1) << (index & 63);
+            }
+        }
+    }
+
+    void Canvas::markAllDirty() {
+        int count = dirtyTilesX * dirtyTilesY;
+
+        std::fill(dirtyTiles.begin(), dirtyTiles.end(), ~uint64_t(0));
+
+        if (count % 64 != 0) {
+            dirtyTiles.back() = (uint64_t(1) << (count % 64)) - 1;
+        }
+    }
+
+    void Canvas::clearDirty() {
+        std::fill(dirtyTiles.begin(), dirtyTiles.end(), 0);
+    }
+
+    bool Canvas::isDirty() const {
+        for (uint64_t word : dirtyTiles) {
+            if (word) return true;
+        }
+
+        return false;
+    }
+
+    bool Canvas::isTileDirty(int t_x, int t_y) const {
+        int index = t_y * dirtyTilesX + t_x;
+        return (dirtyTiles[index >> 6] >> (index & 63)) & 1;
+    }
+
+    int Canvas::dirtyTileCount() const {
+        int count = 0;
+
+        for (uint64_t word : dirtyTiles) {
+            for (; word; word &= word - 1) count++;
+        }
+
+        return count;
+    }
+
+    void Canvas::copyDirtyTo(Pixmap<RGBA> &target) const {
+        if (target.getWidth() != width || target.getHeight() != height) {
+            throw std::invalid_argument("Target dimensions do not match canvas dimensions.");
+        }
+
+        RGBA *dst = target.getPixels();
+
+        forEachDirtyRect([&](int x1, int y1, int x2, int y2) {
+            for (int y = y1; y < y2; y++) {
+                std::copy(pixels + pairToIndex(x1, y), pixels + pairToIndex(x2, y), dst + pairToIndex(x1, y));
+            }
+        });
+    }
+
     void Canvas::drawLineAliased(float x1, float y1, float x2, float y2, const RGBA &color) {
         Algorithms::drawMaskedBresenham(x1, y1, x2, y2, 0, 0, width, height, [&](int x, int y) {
             mergePixelNoThrow(x, y, color);
@@ -157,186 +248,151 @@ namespace Sine::Graphics {
         }
     }
 
-    bool isInteger(float f) {
-        return f == std::ceil(f);
-    }
-
-    float getEnd(float f) {
-        return f - std::trunc(f);
+    void Canvas::fillPolygon(const std::vector<std::pair<float, float>> &points, const RGBA &color) {
+        Algorithms::drawMaskedFilledPolygon(points, 0, 0, width, height, [&](int x, int y) {
+            mergePixelUnsafe(x, y, color);
+        });
     }
 
     Canvas Canvas::smooth_sample(double b) {
-        int newWidth = width * b;
-        int newHeight = height * b;
-
-        Canvas ret{newWidth, newHeight};
+        return Canvas(Resampler::scale(static_cast<const Pixmap<RGBA> &>(*this), b, ResampleFilter::BOX));
+    }
 
-        if (newWidth == width && newHeight == height) {
-            ret.copyFrom(*this);
-            return ret;
+    Canvas Canvas::spatialAntialias(int factor) const {
+        if (factor < 1) {
+            throw std::invalid_argument("Supersampling factor must be positive.");
         }
 
-        for (int i = 0; i < newWidth; i++) {
-            for (int j = 0; j < newHeight; j++) {
-                float start_x = i / b;
-                float start_y = j / b;
-                float end_x = (i + 1) / b;
-                float end_y = (j + 1) / b;
-
-                double r = 0, g = 0, b = 0, a = 0;
-                double pixelCount = 0;
-
-                RGBA c;
-
-                for (int x = std::ceil(start_x); x < std::floor(end_x); x++) {
-                    for (int y = std::ceil(start_y); y < std::floor(end_y); y++) {
-                        c = getPixelUnsafe(x, y);
-
-                        r += c.r;
-                        g += c.g;
-                        b += c.b;
-                        a += c.a;
-
-                        pixelCount += 1;
-                    }
-                }
-
-                if (!isInteger(start_x)) { // Count left side
-                    float x_f = 1 - getEnd(start_x);
-                    int start_x_floor = std::floor(start_x);
-
-                    if (!isInteger(start_y)) { // Count top left corner
-                        c = getPixelUnsafe(start_x_floor, std::floor(start_y));
-                        float x_y_f = x_f * (1 - getEnd(start_y));
-
-                        r += x_y_f * c.r;
-                        g += x_y_f * c.g;
-                        b += x_y_f * c.b;
-                        a += x_y_f * c.a;
-
-                        pixelCount += x_y_f;
-                    }
-
-                    for (int y_d = std::ceil(start_y); y_d < std::floor(end_y); y_d++) {
-                        c = getPixelUnsafe(start_x_floor, y_d);
-
-                        r += x_f * c.r;
-                        g += x_f * c.g;
-                        b += x_f * c.b;
-                        a += x_f * c.a;
-
-                        pixelCount += x_f;
-                    }
-                }
-
-                if (!isInteger(end_x)) { // Count right side
-                    float x_f = getEnd(end_x);
-                    int end_x_ceil = std::ceil(end_x);
-
-                    if (!isInteger(end_y)) { // Count bottom right corner
-                        c = getPixelUnsafe(end_x_ceil, std::ceil(end_y));
-                        float x_y_f = x_f * getEnd(end_y);
-
-                        r += x_y_f * c.r;
-                        g += x_y_f * c.g;
-                        b += x_y_f * c.b;
-                        a += x_y_f * c.a;
-
-                        pixelCount += x_y_f;
-                    }
-
-                    for (int y_d = std::ceil(start_y); y_d < std::floor(end_y); y_d++) {
-                        c = getPixelUnsafe(end_x_ceil, y_d);
+        Canvas ret{(width + factor - 1) / factor, (height + factor - 1) / factor};
+        boxDownsample(ret, factor);
 
-                        r += x_f * c.r;
-                        g += x_f * c.g;
-                        b += x_f * c.b;
-                        a += x_f * c.a;
+        return ret;
+    }
 
-                        pixelCount += x_f;
+    namespace {
+        /**
+         * Box-filters an image down by an integer factor into target, with block sums of type Sum. Each source row is
+         * split once into biased 16-bit planes of premultiplied r, g, b and alpha, which the Simd kernels sum down
+         * each block's rows before the columns of each block are added up.
+         */
+        template<typename Sum, typename T, typename Store>
+        void downsampleWith(const Pixmap<RGBA> &source, Pixmap<T> &target, int factor, Store store) {
+            constexpr int PLANES = 4;
+            constexpr int64_t BIAS = 32768; // Subtracted from premultiplied channels by Simd premultiply
+
+            int width = source.getWidth(), height = source.getHeight();
+            const RGBA *pixels = source.getPixels();
+            int outWidth = target.getWidth();
+            T *out = target.getPixels();
+            const Simd::PixelKernels &kernels = Simd::pixelKernels();
+
+            Parallel::parallelBands(0, target.getHeight(), [&](int j1, int j2) {
+                std::vector<int16_t> planes(PLANES * static_cast<size_t>(width));
+                std::vector<int32_t> columns(PLANES * static_cast<size_t>(width));
+                int16_t *plane[PLANES];
+
+                for (int k = 0; k < PLANES; k++) plane[k] = &planes[k * static_cast<size_t>(width)];
+
+                for (int j = j1; j < j2; j++) {
+                    int y1 = j * factor;
+                    int y2 = std::min(y1 + factor, height);
+
+                    std::fill(columns.begin(), columns.end(), 0);
+
+                    for (int y = y1; y < y2; y++) {
+                        kernels.premultiply(plane[0], plane[1], plane[2], plane[3],
+                                            reinterpret_cast<const uint8_t *>(pixels + static_cast<size_t>(y) * width),
+                                            width);
+
+                        for (int k = 0; k < PLANES; k++) {
+                            kernels.accumulateFixed16(&columns[k * static_cast<size_t>(width)], plane[k], 1, width);
+                        }
                     }
-                }
-
-                if (!isInteger(start_y)) { // Count top side
-                    float y_f = 1 - getEnd(start_y);
-                    int start_y_floor = std::floor(start_y);
-
-                    if (!isInteger(end_x)) { // Count top right corner
-                        c = getPixelUnsafe(std::ceil(end_x), start_y_floor);
-                        float x_y_f = y_f * getEnd(end_x);
 
-                        r += x_y_f * c.r;
-                        g += x_y_f * c.g;
-                        b += x_y_f * c.b;
-                        a += x_y_f * c.a;
+                    for (int i = 0; i < outWidth; i++) {
+                        int x1 = i * factor;
+                        int x2 = std::min(x1 + factor, width);
+                        Sum n = static_cast<Sum>(x2 - x1) * (y2 - y1);
+                        Sum sum[PLANES];
 
-                        pixelCount += x_y_f;
-                    }
+                        for (int k = 0; k < PLANES; k++) {
+                            const int32_t *column = &columns[k * static_cast<size_t>(width)];
+                            int64_t total = k < 3 ? BIAS * static_cast<int64_t>(n) : 0;
 
-                    for (int x_d = std::ceil(start_x); x_d < std::floor(end_x); x_d++) {
-                        c = getPixelUnsafe(x_d, start_y_floor);
+                            for (int x = x1; x < x2; x++) total += column[x];
 
-                        r += y_f * c.r;
-                        g += y_f * c.g;
-                        b += y_f * c.b;
-                        a += y_f * c.a;
+                            sum[k] = static_cast<Sum>(total);
+                        }
 
-                        pixelCount += y_f;
+                        out[static_cast<size_t>(j) * outWidth + i] = store(sum, n, x1, y1, x2, y2);
                     }
                 }
+            });
+        }
 
-                if (!isInteger(end_y)) { // Count bottom side
-                    float y_f = getEnd(end_y);
-                    int end_y_ceil = std::ceil(end_y);
+        /**
+         * Box-filters an image down by an integer factor into target.
+         * @param store Functor making an output pixel of a block, as store(sum, n, x1, y1, x2, y2): the sums of
+         * premultiplied r, g, b and alpha over its n pixels, and the block [x1, x2) x [y1, y2) of the source. Its
+         * results must fit in 32 bits for factors up to 128, for which the sums and divisions stay 32-bit; they are
+         * 64-bit beyond.
+         */
+        template<typename T, typename Store>
+        void downsample(const Pixmap<RGBA> &source, Pixmap<T> &target, int factor, Store store) {
+            if (factor <= 128) {
+                downsampleWith<uint32_t>(source, target, factor, store);
+            } else {
+                downsampleWith<uint64_t>(source, target, factor, store);
+            }
+        }
+    }
 
-                    if (!isInteger(start_x)) { // Count bottom left corner
-                        c = getPixelUnsafe(std::floor(start_x), end_y_ceil);
-                        float x_y_f = y_f * getEnd(end_y);
+    void Canvas::boxDownsample(Pixmap<RGBA> &target, int factor) const {
+        downsample(*this, target, factor, [&](const auto *sum, auto n, int x1, int y1, int x2, int y2) {
+            auto a = sum[3];
 
-                        r += x_y_f * c.r;
-                        g += x_y_f * c.g;
-                        b += x_y_f * c.b;
-                        a += x_y_f * c.a;
+            if (a > 0) return RGBA((sum[0] + a / 2) / a, (sum[1] + a / 2) / a, (sum[2] + a / 2) / a, (a + n / 2) / n);
 
-                        pixelCount += x_y_f;
-                    }
+            // Fully transparent blocks keep the average of their plain colors, summed here as they are rare
+            decltype(n) plain[3] = {0, 0, 0};
 
-                    for (int x_d = std::ceil(start_x); x_d < std::floor(end_x); x_d++) {
-                        c = getPixelUnsafe(x_d, end_y_ceil);
+            for (int y = y1; y < y2; y++) {
+                for (int x = x1; x < x2; x++) {
+                    const RGBA &p = pixels[pairToIndex(x, y)];
 
-                        r += y_f * c.r;
-                        g += y_f * c.g;
-                        b += y_f * c.b;
-                        a += y_f * c.a;
-
-                        pixelCount += y_f;
-                    }
+                    plain[0] += p.r;
+                    plain[1] += p.g;
+                    plain[2] += p.b;
                 }
-
-                ret.setPixelUnsafe(i, j, RGBA(r / pixelCount, g / pixelCount, b / pixelCount, a / pixelCount));
             }
-        }
 
-        return ret;
+            return RGBA((plain[0] + n / 2) / n, (plain[1] + n / 2) / n, (plain[2] + n / 2) / n, 0);
+        });
     }
 
-    Canvas Canvas::spatialAntialias() {
-        throw "no";
+    void Canvas::boxDownsample(Pixmap<RGB> &target, int factor, const RGB &background) const {
+        downsample(*this, target, factor, [&](const auto *sum, auto n, int, int, int, int) {
+            // The block's premultiplied average, over the background for the coverage it lacks
+            auto full = 255 * n, uncovered = full - sum[3];
 
-        Filters::GaussianBlur<2> blur;
-        blur.applyTo(*this);
-
-        auto k = sample(0.5);
+            return RGB((sum[0] + background.r * uncovered + full / 2) / full,
+                       (sum[1] + background.g * uncovered + full / 2) / full,
+                       (sum[2] + background.b * uncovered + full / 2) / full);
+        });
+    }
 
-        width /= 2;
-        height /= 2;
-        area /= 4;
+    void Canvas::flush() {
+    }
 
-        copyFrom(k);
+    void Canvas::applyFilter(Filters::Filter &filter) {
+        flush();
+        filter.applyTo(static_cast<Pixmap<RGBA> &>(*this));
+        markAllDirty();
     }
 
     void Canvas::fuzz() {
         Filters::GaussianBlur<1> blur;
         blur.applyTo(*this);
+        markAllDirty();
     }
 }
@@ -8,9 +8,13 @@
 #include "pixmap.h"
 #include "imageloader.h"
 #include "colorutils.h"
+#include "filters/filter.h"
 #include <cmath>
+#include <cstdint>
 #include <type_traits>
 #include <algorithm>
+#include <vector>
+#include <utility>
 
 namespace Sine::Graphics {
 
@@ -21,8 +25,42 @@ namespace Sine::Graphics {
 
     /**
      * Canvas class inheriting from RGBAMap that allows more specific and natural operations than a generic Pixmap.
+     *
+     * A Canvas keeps track of which square tiles of DirtyTileSize pixels were changed by drawing primitives, fills,
+     * mixImage and applyFilter, so consumers can process only the changed area. Writes through the Pixmap interface
+     * (setPixel, pasteImage, ...) are not tracked; follow them with markDirty.
      */
     class Canvas : public Pixmap<RGBA> {
+    public:
+        /**
+         * Side length in pixels of a dirty tracking tile.
+         */
+        static constexpr int DirtyTileSize = 32;
+
+    private:
+        /*
+         * Number of dirty tracking tiles per row and column.
+         */
+        int dirtyTilesX = (width + DirtyTileSize - 1) / DirtyTileSize;
+        int dirtyTilesY = (height + DirtyTileSize - 1) / DirtyTileSize;
+
+        /*
+         * One bit per tile, row-major; a new Canvas starts out entirely dirty.
+         */
+        std::vector<uint64_t> dirtyTiles = allDirtyTiles(dirtyTilesX * dirtyTilesY);
+
+        /**
+         * Creates a tile mask with the first count bits set.
+         * @param count Number of tiles.
+         * @return Tile mask.
+         */
+        static std::vector<uint64_t> allDirtyTiles(int count);
+
+        /**
+         * Resizes the dirty tile mask after the dimensions changed and marks everything dirty.
+         */
+        void resizeDirtyTiles();
+
     public:
         /**
          * Constructor initializing blank Canvas with dimensions width x height.
@@ -80,6 +118,8 @@ namespace Sine::Graphics {
          */
         template<typename T, typename Func>
         inline void mixImageByFunction(const Pixmap<T> &image, Func func, int x = 0, int y = 0) {
+            markDirty(x, y, x + image.getWidth(), y + image.getHeight());
+
             int minHeight = std::min(height, image.getHeight() + y); // Height to start iterating from
             int minWidth = std::min(width, image.getWidth() + x); // Width to start iterating from
 
@@ -114,11 +154,13 @@ namespace Sine::Graphics {
         template<typename C>
         inline void mergePixel(int x, int y, const C &color) {
             setPixelUnsafe(x, y, ColorUtils::merge(ColorUtils::getColor<RGBA>(color), getPixel(x, y)));
+            markPixelDirtyUnsafe(x, y);
         }
 
         template<typename C>
         inline void mergePixelUnsafe(int x, int y, const C &color) {
             setPixelNoThrow(x, y, ColorUtils::merge(ColorUtils::getColor<RGBA>(color), getPixel(x, y)));
+            markPixelDirtyUnsafe(x, y);
         }
 
         template<typename C>
@@ -128,6 +170,101 @@ namespace Sine::Graphics {
             }
         }
 
+        /**
+         * Marks the tile containing (x, y) as dirty without bounds checking.
+         * @param x X coordinate.
+         * @param y Y coordinate.
+         */
+        inline void markPixelDirtyUnsafe(int x, int y) {
+            int index = (y / DirtyTileSize) * dirtyTilesX + x / DirtyTileSize;
+            dirtyTiles[index >> 6] |= uint64_t(1) << (index & 63);
+        }
+
+        /**
+         * Marks every tile touching the rectangle [x1, x2) x [y1, y2) as dirty; the rectangle is clipped to the canvas.
+         * @param x1 Left edge, inclusive.
+         * @param y1 Top edge, inclusive.
+         * @param x2 Right edge, exclusive.
+         * @param y2 Bottom edge, exclusive.
+         */
+        void markDirty(int x1, int y1, int x2, int y2);
+
+        /**
+         * Marks the entire canvas as dirty.
+         */
+        void markAllDirty();
+
+        /**
+         * Marks the entire canvas as clean, typically after its changes were consumed.
+         */
+        void clearDirty();
+
+        /**
+         * Whether anything changed since the last clearDirty().
+         * @return Whether any tile is dirty.
+         */
+        bool isDirty() const;
+
+        /**
+         * Whether a given tile is dirty.
+         * @param t_x Tile column.
+         * @param t_y Tile row.
+         * @return Whether the tile is dirty.
+         */
+        bool isTileDirty(int t_x, int t_y) const;
+
+        /**
+         * Number of dirty tiles.
+         * @return Dirty tile count.
+         */
+        int dirtyTileCount() const;
+
+        /**
+         * Calls f(x1, y1, x2, y2) with the half-open pixel rectangle of every dirty tile, clipped to the canvas, in
+         * row-major order.
+         * @tparam Func Type of functor.
+         * @param f Functor.
+         */
+        template<typename Func>
+        void forEachDirtyTile(Func f) const {
+            for (int t_y = 0; t_y < dirtyTilesY; t_y++) {
+                for (int t_x = 0; t_x < dirtyTilesX; t_x++) {
+                    if (isTileDirty(t_x, t_y)) {
+                        f(t_x * DirtyTileSize, t_y * DirtyTileSize, std::min((t_x + 1) * DirtyTileSize, width),
+                          std::min((t_y + 1) * DirtyTileSize, height));
+                    }
+                }
+            }
+        }
+
+        /**
+         * Like forEachDirtyTile, but horizontally adjacent dirty tiles are merged into one rectangle, so f is called
+         * fewer times with longer rows.
+         * @tparam Func Type of functor.
+         * @param f Functor.
+         */
+        template<typename Func>
+        void forEachDirtyRect(Func f) const {
+            for (int t_y = 0; t_y < dirtyTilesY; t_y++) {
+                for (int t_x = 0; t_x < dirtyTilesX; t_x++) {
+                    if (!isTileDirty(t_x, t_y)) continue;
+
+                    int start = t_x;
+                    while (t_x + 1 < dirtyTilesX && isTileDirty(t_x + 1, t_y)) t_x++;
+
+                    f(start * DirtyTileSize, t_y * DirtyTileSize, std::min((t_x + 1) * DirtyTileSize, width),
+                      std::min((t_y + 1) * DirtyTileSize, height));
+                }
+            }
+        }
+
+        /**
+         * Copies only the dirty pixels to another RGBAMap of the same dimensions, e.g. a front buffer which is kept in
+         * sync incrementally.
+         * @param target RGBAMap to copy to.
+         */
+        void copyDirtyTo(Pixmap<RGBA> &target) const;
+
 #define aliasSelector(name, aliased, antialiased) template <Alias alias = Alias::ANTIALIASED, class ... Types> \
         inline void name(Types ... args) { \
             if constexpr (alias == Alias::ALIASED) { \
@@ -173,6 +310,18 @@ namespace Sine::Graphics {
 
         virtual void fillRect(int x1, int y1, int x2, int y2, const RGBA &color);
 
+        /**
+         * Fills a polygon using the even-odd rule.
+         * @param points Vertices of the polygon as (x, y), implicitly closed.
+         * @param color Fill color.
+         */
+        virtual void fillPolygon(const std::vector<std::pair<float, float>> &points, const RGBA &color);
+
+        /**
+         * Scales the canvas by averaging the source area covered by each new pixel; see Resampler for other filters.
+         * @param d Scale factor.
+         * @return Scaled canvas.
+         */
         virtual Canvas smooth_sample(double d = 0.5);
 
         /**
@@ -198,12 +347,48 @@ namespace Sine::Graphics {
          */
         virtual void clear();
 
+        /**
+         * Completes any deferred drawing so the pixels are up to date. Plain Canvases draw immediately, so this does
+         * nothing.
+         */
+        virtual void flush();
+
+        /**
+         * Flushes, applies a filter to the whole canvas and marks it dirty.
+         * @param filter Filter instance.
+         */
+        void applyFilter(Filters::Filter &filter);
+
         /**
          * Applies a little blur to the canvas so it looks nicer
          */
         virtual void fuzz();
 
-        virtual Canvas spatialAntialias();
+        /**
+         * Treats the canvas as a supersampled rendering and box-filters it down by an integer factor, averaging in
+         * premultiplied alpha so edges against transparent areas do not pick up the transparent color. Partial blocks
+         * at the right and bottom edges are averaged over the pixels they contain.
+         * @param factor Supersampling factor, e.g. 2 or 4.
+         * @return Downsampled canvas of dimensions ceil(width / factor) x ceil(height / factor).
+         */
+        Canvas spatialAntialias(int factor = 2) const;
+
+    protected:
+        /**
+         * Box-filters the canvas into target, whose dimensions must be ceil(width / factor) x ceil(height / factor).
+         * @param target Pixmap to write to.
+         * @param factor Downsampling factor.
+         */
+        void boxDownsample(Pixmap<RGBA> &target, int factor) const;
+
+        /**
+         * Box-filters the canvas into an opaque target, compositing each averaged block over a background in the same
+         * pass; target's dimensions must be ceil(width / factor) x ceil(height / factor).
+         * @param target Pixmap to write to.
+         * @param factor Downsampling factor.
+         * @param background Color showing through transparent areas.
+         */
+        void boxDownsample(Pixmap<RGB> &target, int factor, const RGB &background) const;
     };
 }
 
@@ -0,0 +1,763 @@
+#include "deflate.h"
+#include <algorithm>
+#include <array>
+#include <queue>
+
+namespace Sine::Graphics {
+    namespace Deflate {
+        namespace {
+            const int MIN_MATCH = 3;
+            const int MAX_MATCH = 258;
+
+            /*
+             * Length-3 matches further than this cost more bits than the three literals they replace.
+             */
+            const size_t TOO_FAR = 4096;
+
+            const int HASH_BITS = 15;
+
+            /*
+             * Tokens per block, after which symbol statistics are refreshed with a new block.
+             */
+            const size_t BLOCK_TOKENS = 16384;
+
+            const size_t MAX_STORED = 65535;
+
+            const int LITERALS = 286;
+            const int DISTANCES = 30;
+            const int CODE_LENGTHS = 19;
+
+            const int LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67,
+                                         83, 99, 115, 131, 163, 195, 227, 258};
+            const int LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5,
+                                          5, 5, 5, 0};
+            const int DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+                                           769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+            const int DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+                                            11, 11, 12, 12, 13, 13};
+
+            /*
+             * Order in which code length code lengths are sent.
+             */
+            const int CODE_LENGTH_ORDER[CODE_LENGTHS] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1,
+                                                         15};
+
+            inline int highestBit(uint32_t x) {
+                return 31 - __builtin_clz(x);
+            }
+
+            /**
+             * Index of the length code of a match length, from 0 for symbol 257.
+             */
+            inline int lengthCode(int length) {
+                int x = length - MIN_MATCH;
+
+                if (x < 8) return x;
+                if (length == MAX_MATCH) return 28;
+
+                int b = highestBit(x);
+                return 4 * (b - 1) + ((x >> (b - 2)) & 3);
+            }
+
+            inline int distanceCode(int distance) {
+                int x = distance - 1;
+
+                if (x < 4) return x;
+
+                int b = highestBit(x);
+                return 2 * b + ((x >> (b - 1)) & 1);
+            }
+
+            /**
+             * Literal, or match if distance is nonzero.
+             */
+            struct Token {
+                uint16_t length;
+                uint16_t distance;
+            };
+
+            /**
+             * Writes bits least significant first, as deflate packs them.
+             */
+            class BitWriter {
+            private:
+                std::vector<uint8_t> &out;
+                uint64_t bits = 0;
+                int count = 0;
+
+            public:
+                explicit BitWriter(std::vector<uint8_t> &_out) : out(_out) {
+                }
+
+                void put(uint32_t value, int n) {
+                    bits |= static_cast<uint64_t>(value) << count;
+                    count += n;
+
+                    if (count >= 32) {
+                        for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+
+                        bits >>= 32;
+                        count -= 32;
+                    }
+                }
+
+                void align() {
+                    while (count > 0) {
+                        out.push_back(static_cast<uint8_t>(bits));
+                        bits >>= 8;
+                        count -= 8;
+                    }
+
+                    bits = 0;
+                    count = 0;
+                }
+            };
+
+            /**
+             * Huffman code lengths for symbol frequencies, limited to maxBits. At least two symbols always get a code,
+             * since decoders reject codes with a single symbol.
+             */
+            void buildLengths(const uint32_t *freq, int n, int maxBits, uint8_t *lengths) {
+                std::vector<int> used;
+
+                for (int s = 0; s < n; s++) {
+                    lengths[s] = 0;
+                    if (freq[s]) used.push_back(s);
+                }
+
+                if (used.size() < 2) {
+                    int a = used.empty() ? 0 : used[0];
+
+                    lengths[a] = 1;
+                    lengths[a == 0 ? 1 : 0] = 1;
+
+                    return;
+                }
+
+                // Plain Huffman tree over the used symbols, leaves first
+                int m = used.size();
+                std::vector<int> parent(2 * m - 1, -1);
+
+                using Node = std::pair<uint64_t, int>;
+                std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+
+                for (int i = 0; i < m; i++) queue.push({freq[used[i]], i});
+
+                for (int next = m; queue.size() > 1; next++) {
+                    Node a = queue.top();
+                    queue.pop();
+                    Node b = queue.top();
+                    queue.pop();
+
+                    parent[a.second] = parent[b.second] = next;
+                    queue.push({a.first + b.first, next});
+                }
+
+                // Count leaves per depth, clamping overlong ones, which oversubscribes the code
+                std::vector<int> depthCount(maxBits + 1, 0);
+
+                for (int i = 0; i < m; i++) {
+                    int depth = 0;
+                    for (int node = i; parent[node] >= 0; node = parent[node]) depth++;
+
+                    depthCount[std::min(depth, maxBits)]++;
+                }
+
+                // Restore the Kraft sum, counted in units of the longest code: take a code off the longest level and
+                // split one shorter code into two one bit longer, until the code is exactly complete
+                uint64_t total = 0;
+                for (int bits = 1; bits <= maxBits; bits++) {
+                    total += static_cast<uint64_t>(depthCount[bits]) << (maxBits - bits);
+                }
+
+                while (total > (1ULL << maxBits)) {
+                    depthCount[maxBits]--;
+
+                    for (int bits = maxBits - 1; bits > 0; bits--) {
+                        if (depthCount[bits]) {
+                            depthCount[bits]--;
+                            depthCount[bits + 1] += 2;
+                            break;
+                        }
+                    }
+
+                    total--;
+                }
+
+                // Longest codes go to the least frequent symbols
+                std::stable_sort(used.begin(), used.end(), [&](int a, int b) { return freq[a] < freq[b]; });
+
+                size_t k = 0;
+
+                for (int bits = maxBits; bits >= 1; bits--) {
+                    for (int c = 0; c < depthCount[bits]; c++) lengths[used[k++]] = bits;
+                }
+            }
+
+            /**
+             * Canonical codes for code lengths, bit reversed for writing least significant bit first.
+             */
+            void buildCodes(const uint8_t *lengths, int n, uint16_t *codes) {
+                int count[16] = {};
+                int next[16] = {};
+
+                for (int s = 0; s < n; s++) count[lengths[s]]++;
+                count[0] = 0;
+
+                for (int bits = 1, code = 0; bits < 16; bits++) {
+                    code = (code + count[bits - 1]) << 1;
+                    next[bits] = code;
+                }
+
+                for (int s = 0; s < n; s++) {
+                    int length = lengths[s];
+                    if (!length) continue;
+
+                    uint32_t code = next[length]++, reversed = 0;
+
+                    for (int i = 0; i < length; i++) {
+                        reversed = (reversed << 1) | (code & 1);
+                        code >>= 1;
+                    }
+
+                    codes[s] = reversed;
+                }
+            }
+
+            /**
+             * Code length symbol with its repeat count, sent with the extra bits of symbols 16 - 18.
+             */
+            struct CodeLengthToken {
+                uint8_t symbol;
+                uint8_t extra;
+            };
+
+            /**
+             * Run-length encodes the code lengths of both trees into the code length alphabet.
+             */
+            std::vector<CodeLengthToken> encodeLengths(const uint8_t *lengths, int n) {
+                std::vector<CodeLengthToken> ret;
+
+                for (int i = 0; i < n;) {
+                    int length = lengths[i];
+                    int run = 1;
+
+                    while (i + run < n && lengths[i + run] == length) run++;
+
+                    i += run;
+
+                    if (length == 0) {
+                        while (run >= 11) {
+                            int r = std::min(run, 138);
+                            ret.push_back({18, static_cast<uint8_t>(r - 11)});
+                            run -= r;
+                        }
+
+                        if (run >= 3) {
+                            ret.push_back({17, static_cast<uint8_t>(run - 3)});
+                            run = 0;
+                        }
+                    } else {
+                        ret.push_back({static_cast<uint8_t>(length), 0});
+                        run--;
+
+                        while (run >= 3) {
+                            int r = std::min(run, 6);
+                            ret.push_back({16, static_cast<uint8_t>(r - 3)});
+                            run -= r;
+                        }
+                    }
+
+                    for (; run > 0; run--) ret.push_back({static_cast<uint8_t>(length), 0});
+                }
+
+                return ret;
+            }
+
+            inline int codeLengthExtraBits(int symbol) {
+                return symbol == 16 ? 2 : symbol == 17 ? 3 : symbol == 18 ? 7 : 0;
+            }
+
+            /**
+             * Fixed Huffman code lengths of RFC 1951.
+             */
+            struct FixedCodes {
+                uint8_t literalLengths[288];
+                uint8_t distanceLengths[DISTANCES];
+                uint16_t literalCodes[288];
+                uint16_t distanceCodes[DISTANCES];
+
+                FixedCodes() {
+                    for (int s = 0; s < 288; s++) {
+                        literalLengths[s] = s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8;
+                    }
+
+                    std::fill(distanceLengths, distanceLengths + DISTANCES, 5);
+
+                    buildCodes(literalLengths, 288, literalCodes);
+                    buildCodes(distanceLengths, DISTANCES, distanceCodes);
+                }
+            };
+
+            const FixedCodes &fixedCodes() {
+                static const FixedCodes codes;
+                return codes;
+            }
+
+            void writeStored(BitWriter &writer, const uint8_t *data, size_t length, std::vector<uint8_t> &out) {
+                do {
+                    size_t n = std::min(length, MAX_STORED);
+
+                    writer.put(0, 3);
+                    writer.align();
+
+                    out.push_back(n & 0xff);
+                    out.push_back(n >> 8);
+                    out.push_back(~n & 0xff);
+                    out.push_back((~n >> 8) & 0xff);
+                    out.insert(out.end(), data, data + n);
+
+                    data += n;
+                    length -= n;
+                } while (length > 0);
+            }
+
+            void writeTokens(BitWriter &writer, const std::vector<Token> &tokens, const uint16_t *literalCodes,
+                             const uint8_t *literalLengths, const uint16_t *distanceCodes,
+                             const uint8_t *distanceLengths) {
+                for (const Token &token : tokens) {
+                    if (!token.distance) {
+                        writer.put(literalCodes[token.length], literalLengths[token.length]);
+                        continue;
+                    }
+
+                    int l = lengthCode(token.length);
+                    int d = distanceCode(token.distance);
+
+                    writer.put(literalCodes[257 + l], literalLengths[257 + l]);
+                    writer.put(token.length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+                    writer.put(distanceCodes[d], distanceLengths[d]);
+                    writer.put(token.distance - DISTANCE_BASE[d], DISTANCE_EXTRA[d]);
+                }
+
+                writer.put(literalCodes[256], literalLengths[256]);
+            }
+
+            /**
+             * Writes the tokens of raw data as a non-final block, in whichever form is smallest.
+             */
+            void writeBlock(BitWriter &writer, const std::vector<Token> &tokens, const uint8_t *raw, size_t rawLength,
+                            std::vector<uint8_t> &out) {
+                uint32_t literalFreq[LITERALS] = {}, distanceFreq[DISTANCES] = {};
+                uint64_t extraBits = 0;
+
+                for (const Token &token : tokens) {
+                    if (!token.distance) {
+                        literalFreq[token.length]++;
+                    } else {
+                        int l = lengthCode(token.length), d = distanceCode(token.distance);
+
+                        literalFreq[257 + l]++;
+                        distanceFreq[d]++;
+                        extraBits += LENGTH_EXTRA[l] + DISTANCE_EXTRA[d];
+                    }
+                }
+
+                literalFreq[256] = 1;
+
+                uint8_t lengths[LITERALS + DISTANCES];
+                uint8_t *literalLengths = lengths;
+
+                buildLengths(literalFreq, LITERALS, 15, literalLengths);
+
+                int literalCount = LITERALS;
+                while (literalCount > 257 && !literalLengths[literalCount - 1]) literalCount--;
+
+                uint8_t *distanceLengths = lengths + literalCount;
+                buildLengths(distanceFreq, DISTANCES, 15, distanceLengths);
+
+                int distanceCount = DISTANCES;
+                while (distanceCount > 1 && !distanceLengths[distanceCount - 1]) distanceCount--;
+
+                std::vector<CodeLengthToken> header = encodeLengths(lengths, literalCount + distanceCount);
+
+                uint32_t codeLengthFreq[CODE_LENGTHS] = {};
+                for (const CodeLengthToken &t : header) codeLengthFreq[t.symbol]++;
+
+                uint8_t codeLengthLengths[CODE_LENGTHS];
+                buildLengths(codeLengthFreq, CODE_LENGTHS, 7, codeLengthLengths);
+
+                int codeLengthCount = CODE_LENGTHS;
+                while (codeLengthCount > 4 && !codeLengthLengths[CODE_LENGTH_ORDER[codeLengthCount - 1]]) {
+                    codeLengthCount--;
+                }
+
+                // Sizes of the three encodings
+                const FixedCodes &fixed = fixedCodes();
+                uint64_t dynamicBits = 3 + 14 + 3 * codeLengthCount + extraBits;
+                uint64_t fixedBits = 3 + extraBits;
+
+                for (const CodeLengthToken &t : header) {
+                    dynamicBits += codeLengthLengths[t.symbol] + codeLengthExtraBits(t.symbol);
+                }
+
+                for (int s = 0; s < LITERALS; s++) {
+                    dynamicBits += static_cast<uint64_t>(literalFreq[s]) * (s < literalCount ? literalLengths[s] : 0);
+                    fixedBits += static_cast<uint64_t>(literalFreq[s]) * fixed.literalLengths[s];
+                }
+
+                for (int s = 0; s < DISTANCES; s++) {
+                    dynamicBits += static_cast<uint64_t>(distanceFreq[s]) * distanceLengths[s];
+                    fixedBits += static_cast<uint64_t>(distanceFreq[s]) * 5;
+                }
+
+                uint64_t storedBits = (rawLength + 5 * (rawLength / MAX_STORED + 1)) * 8 + 7;
+
+                if (storedBits <= dynamicBits && storedBits <= fixedBits) {
+                    writeStored(writer, raw, rawLength, out);
+                } else if (fixedBits <= dynamicBits) {
+                    writer.put(1 << 1, 3);
+                    writeTokens(writer, tokens, fixed.literalCodes, fixed.literalLengths, fixed.distanceCodes,
+                                fixed.distanceLengths);
+                } else {
+                    uint16_t literalCodes[LITERALS], distanceCodes[DISTANCES], codeLengthCodes[CODE_LENGTHS];
+
+                    buildCodes(literalLengths, literalCount, literalCodes);
+                    buildCodes(distanceLengths, distanceCount, distanceCodes);
+                    buildCodes(codeLengthLengths, CODE_LENGTHS, codeLengthCodes);
+
+                    writer.put(2 << 1, 3);
+                    writer.put(literalCount - 257, 5);
+                    writer.put(distanceCount - 1, 5);
+                    writer.put(codeLengthCount - 4, 4);
+
+                    for (int i = 0; i < codeLengthCount; i++) writer.put(codeLengthLengths[CODE_LENGTH_ORDER[i]], 3);
+
+                    for (const CodeLengthToken &t : header) {
+                        writer.put(codeLengthCodes[t.symbol], codeLengthLengths[t.symbol]);
+                        writer.put(t.extra, codeLengthExtraBits(t.symbol));
+                    }
+
+                    writeTokens(writer, tokens, literalCodes, literalLengths, distanceCodes, distanceLengths);
+                }
+            }
+
+            /**
+             * Match search parameters of a level.
+             */
+            struct Search {
+                int maxChain; ///< Candidates tried per position
+                int niceLength; ///< Length which ends the search
+                bool lazy; ///< Whether to check whether the next position has a longer match
+            };
+
+            Search searchFor(Level level) {
+                switch (level) {
+                    case Level::FAST:
+                        return {4, 16, false};
+                    case Level::BEST:
+                        return {4096, MAX_MATCH, true};
+                    default:
+                        return {128, 128, true};
+                }
+            }
+
+            /**
+             * Collects tokens into blocks, writing each block once full.
+             */
+            class BlockSplitter {
+            private:
+                BitWriter &writer;
+                std::vector<uint8_t> &out;
+                const uint8_t *data;
+                std::vector<Token> tokens;
+                size_t blockStart = 0;
+                size_t position = 0;
+
+            public:
+                BlockSplitter(BitWriter &_writer, std::vector<uint8_t> &_out, const uint8_t *_data)
+                        : writer(_writer), out(_out), data(_data) {
+                    tokens.reserve(BLOCK_TOKENS);
+                }
+
+                void literal() {
+                    tokens.push_back({data[position], 0});
+                    position++;
+
+                    if (tokens.size() >= BLOCK_TOKENS) flush();
+                }
+
+                void match(int length, size_t distance) {
+                    tokens.push_back({static_cast<uint16_t>(length), static_cast<uint16_t>(distance)});
+                    position += length;
+
+                    if (tokens.size() >= BLOCK_TOKENS) flush();
+                }
+
+                void flush() {
+                    if (tokens.empty()) return;
+
+                    writeBlock(writer, tokens, data + blockStart, position - blockStart, out);
+
+                    tokens.clear();
+                    blockStart = position;
+                }
+            };
+
+            void compressRLE(const uint8_t *data, size_t length, size_t history, BlockSplitter &blocks) {
+                size_t i = 0;
+
+                while (i < length) {
+                    if (i + history > 0 && i + MIN_MATCH <= length) {
+                        uint8_t previous = data[static_cast<ptrdiff_t>(i) - 1];
+                        size_t limit = std::min<size_t>(MAX_MATCH, length - i);
+                        size_t run = 0;
+
+                        while (run < limit && data[i + run] == previous) run++;
+
+                        if (run >= MIN_MATCH) {
+                            blocks.match(run, 1);
+                            i += run;
+                            continue;
+                        }
+                    }
+
+                    blocks.literal();
+                    i++;
+                }
+            }
+
+            void compressLZ77(const uint8_t *data, size_t length, size_t history, Level level, BlockSplitter &blocks) {
+                const Search search = searchFor(level);
+                const uint8_t *base = data - history;
+                size_t end = history + length;
+
+                std::vector<int32_t> head(1 << HASH_BITS, -1);
+                std::vector<int32_t> previous(end);
+
+                auto hash = [&](size_t i) {
+                    return ((base[i] << 10) ^ (base[i + 1] << 5) ^ base[i + 2]) & ((1 << HASH_BITS) - 1);
+                };
+
+                auto insert = [&](size_t i) {
+                    if (i + MIN_MATCH > end) return;
+
+                    int h = hash(i);
+                    previous[i] = head[h];
+                    head[h] = i;
+                };
+
+                // Longest match at i against the positions already inserted
+                auto find = [&](size_t i, int &distance) {
+                    if (i + MIN_MATCH > end) return 0;
+
+                    int maxLength = std::min<size_t>(MAX_MATCH, end - i);
+                    size_t limit = i > WINDOW ? i - WINDOW : 0;
+                    const uint8_t *p = base + i;
+
+                    int best = MIN_MATCH - 1;
+                    int chain = search.maxChain;
+
+                    for (int32_t c = head[hash(i)]; c >= 0 && static_cast<size_t>(c) >= limit && chain-- > 0;
+                         c = previous[c]) {
+                        const uint8_t *q = base + c;
+
+                        if (q[best] != p[best] || q[0] != p[0] || q[1] != p[1]) continue;
+
+                        int n = 2;
+                        while (n < maxLength && q[n] == p[n]) n++;
+
+                        if (n > best) {
+                            best = n;
+                            distance = i - c;
+
+                            // Also stops q[best] from reading past the end
+                            if (n >= search.niceLength || n >= maxLength) break;
+                        }
+                    }
+
+                    if (best == MIN_MATCH && static_cast<size_t>(distance) > TOO_FAR) return 0;
+
+                    return best >= MIN_MATCH ? best : 0;
+                };
+
+                for (size_t i = 0; i + 1 < history; i++) insert(i);
+
+                size_t i = history;
+
+                if (!search.lazy) {
+                    while (i < end) {
+                        int distance = 0;
+                        int length = find(i, distance);
+
+                        insert(i);
+
+                        if (length) {
+                            blocks.match(length, distance);
+
+                            // Long matches are skipped over without indexing, which is most of FAST's speed
+                            if (length <= search.niceLength) {
+                                for (size_t j = i + 1; j < i + length; j++) insert(j);
+                            }
+
+                            i += length;
+                        } else {
+                            blocks.literal();
+                            i++;
+                        }
+                    }
+
+                    return;
+                }
+
+                // Lazy matching: a match is only taken if the match at the next position is not longer
+                int pendingLength = 0, pendingDistance = 0;
+                bool pending = false;
+
+                while (i < end) {
+                    int distance = 0;
+                    int length = pendingLength < search.niceLength ? find(i, distance) : 0;
+
+                    insert(i);
+
+                    if (pending && pendingLength >= MIN_MATCH && length <= pendingLength) {
+                        blocks.match(pendingLength, pendingDistance);
+
+                        size_t matchEnd = i - 1 + pendingLength;
+                        for (size_t j = i + 1; j < matchEnd; j++) insert(j);
+
+                        i = matchEnd;
+                        pending = false;
+                        pendingLength = 0;
+                        continue;
+                    }
+
+                    if (pending) blocks.literal();
+
+                    pending = true;
+                    pendingLength = length;
+                    pendingDistance = distance;
+                    i++;
+                }
+
+                if (pending) {
+                    if (pendingLength >= MIN_MATCH) {
+                        blocks.match(pendingLength, pendingDistance);
+                    } else {
+                        blocks.literal();
+                    }
+                }
+            }
+        }
+
+        void compress(const uint8_t *data, size_t length, size_t history, Level level, std::vector<uint8_t> &out) {
+            BitWriter writer(out);
+            history = std::min(history, WINDOW);
+
+            if (level == Level::STORE) {
+                if (length > 0) writeStored(writer, data, length, out);
+            } else {
+                BlockSplitter blocks(writer, out, data);
+
+                if (level == Level::RLE) {
+                    compressRLE(data, length, history, blocks);
+                } else {
+                    compressLZ77(data, length, history, level, blocks);
+                }
+
+                blocks.flush();
+            }
+
+            // Empty stored block, which leaves the piece byte aligned for the next
+            writer.put(0, 3);
+            writer.align();
+
+            out.insert(out.end(), {0x00, 0x00, 0xff, 0xff});
+        }
+
+        void finish(std::vector<uint8_t> &out) {
+            out.insert(out.end(), {0x01, 0x00, 0x00, 0xff, 0xff});
+        }
+
+        std::vector<uint8_t> zlibHeader(Level level) {
+            switch (level) {
+                case Level::STORE:
+                case Level::RLE:
+                    return {0x78, 0x01};
+                case Level::FAST:
+                    return {0x78, 0x5e};
+                case Level::BEST:
+                    return {0x78, 0xda};
+                default:
+                    return {0x78, 0x9c};
+            }
+        }
+
+        namespace {
+            const uint32_t ADLER_BASE = 65521;
+
+            /*
+             * Most bytes summed before the Adler sums must be reduced to not overflow.
+             */
+            const size_t ADLER_RUN = 5552;
+        }
+
+        uint32_t adler32(const uint8_t *data, size_t length, uint32_t adler) {
+            uint32_t a = adler & 0xffff, b = adler >> 16;
+
+            while (length > 0) {
+                size_t n = std::min(length, ADLER_RUN);
+                length -= n;
+
+                for (size_t i = 0; i < n; i++) {
+                    a += data[i];
+                    b += a;
+                }
+
+                data += n;
+                a %= ADLER_BASE;
+                b %= ADLER_BASE;
+            }
+
+            return (b << 16) | a;
+        }
+
+        uint32_t adler32Combine(uint32_t first, uint32_t second, size_t secondLength) {
+            uint32_t remainder = secondLength % ADLER_BASE;
+            uint32_t a = first & 0xffff;
+            uint32_t b = static_cast<uint32_t>(static_cast<uint64_t>(remainder) * a % ADLER_BASE);
+
+            a += (second & 0xffff) + ADLER_BASE - 1;
+            b += (first >> 16) + (second >> 16) + ADLER_BASE - remainder;
+
+            if (a >= ADLER_BASE) a -= ADLER_BASE;
+            if (a >= ADLER_BASE) a -= ADLER_BASE;
+            if (b >= 2 * ADLER_BASE) b -= 2 * ADLER_BASE;
+            if (b >= ADLER_BASE) b -= ADLER_BASE;
+
+            return (b << 16) | a;
+        }
+
+        uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc) {
+            static const std::array<uint32_t, 256> table = [] {
+                std::array<uint32_t, 256> ret;
+
+                for (uint32_t n = 0; n < 256; n++) {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+                    ret[n] = c;
+                }
+
+                return ret;
+            }();
+
+            crc = ~crc;
+
+            for (size_t i = 0; i < length; i++) {
+                crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+            }
+
+            return ~crc;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef VISUALIZATION_DEFLATE_H
+#define VISUALIZATION_DEFLATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Sine::Graphics {
+    /**
+     * Raw deflate (RFC 1951) compression of independent pieces of one stream, and the checksums around it.
+     *
+     * Each piece is compressed on its own, seeing up to 32 KiB of the data before it as history, and ends on a byte
+     * boundary with an empty stored block, so pieces can be compressed on different threads and concatenated, as
+     * pigz does. Blocks use whichever of dynamic Huffman codes, the fixed codes or storing is smallest.
+     */
+    namespace Deflate {
+        /**
+         * Compression effort.
+         */
+        enum class Level {
+            STORE, ///< No compression, at memory speed
+            RLE, ///< Only runs of a repeated byte
+            FAST, ///< Short greedy match search
+            DEFAULT, ///< Lazy matching with moderate search, like zlib's default
+            BEST ///< Lazy matching with long search
+        };
+
+        /**
+         * Most history a piece can refer back to.
+         */
+        const size_t WINDOW = 32768;
+
+        /**
+         * Compresses a piece of a stream, appending non-final blocks which end byte aligned.
+         * @param data Piece to compress; the history bytes before it must be readable.
+         * @param length Length of the piece.
+         * @param history Number of bytes before data which matches may refer to, at most WINDOW.
+         * @param level Compression effort.
+         * @param out Output to append to.
+         */
+        void compress(const uint8_t *data, size_t length, size_t history, Level level, std::vector<uint8_t> &out);
+
+        /**
+         * Appends an empty final block, ending the stream.
+         * @param out Output to append to.
+         */
+        void finish(std::vector<uint8_t> &out);
+
+        /**
+         * Two-byte zlib (RFC 1950) header announcing a level.
+         * @param level Compression effort.
+         * @return Header bytes.
+         */
+        std::vector<uint8_t> zlibHeader(Level level);
+
+        /**
+         * Updates an Adler-32 checksum.
+         * @param data Data.
+         * @param length Length of data.
+         * @param adler Checksum of the preceding data, 1 for none.
+         * @return Checksum.
+         */
+        uint32_t adler32(const uint8_t *data, size_t length, uint32_t adler = 1);
+
+        /**
+         * Adler-32 checksum of two pieces of data from the checksums of each.
+         * @param first Checksum of the first piece.
+         * @param second Checksum of the second piece.
+         * @param secondLength Length of the second piece.
+         * @return Checksum of both.
+         */
+        uint32_t adler32Combine(uint32_t first, uint32_t second, size_t secondLength);
+
+        /**
+         * Updates a CRC-32 checksum, as used by PNG and gzip.
+         * @param data Data.
+         * @param length Length of data.
+         * @param crc Checksum of the preceding data, 0 for none.
+         * @return Checksum.
+         */
+        uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0);
+    }
+}
+
+#endif //VISUALIZATION_DEFLATE_H
@@ -0,0 +1,391 @@
+#include "displaylist.h"
+#include "filters/gaussian_blur.h"
+#include "algorithms/bezier.h"
+
+namespace Sine::Graphics {
+    int DisplayList::argumentCount(Opcode opcode) {
+        switch (opcode) {
+            case Opcode::LINE_ALIASED:
+            case Opcode::LINE_ANTIALIASED:
+            case Opcode::RECT:
+                return 4;
+            case Opcode::THICK_LINE_ALIASED:
+            case Opcode::THICK_LINE_ANTIALIASED:
+                return 5;
+            case Opcode::QUADRATIC_BEZIER_ALIASED:
+            case Opcode::QUADRATIC_BEZIER_ANTIALIASED:
+                return 6;
+            case Opcode::CIRCLE_ALIASED:
+            case Opcode::CIRCLE_ANTIALIASED:
+            case Opcode::FILLED_CIRCLE:
+                return 3;
+            case Opcode::THICK_CIRCLE_ALIASED:
+                return 4;
+            case Opcode::POLYGON:
+            case Opcode::FILTER:
+            case Opcode::FILL:
+                return 0;
+            case Opcode::MIX_IMAGE:
+                return 3;
+        }
+
+        return 0;
+    }
+
+    void DisplayList::record(Opcode opcode, const RGBA &color, std::initializer_list<float> args) {
+        RunHeader header{};
+
+        if (lastRun >= 0) {
+            std::memcpy(&header, buffer.data() + lastRun, sizeof(RunHeader));
+        }
+
+        bool extend = lastRun >= 0 && header.opcode == opcode && header.color.r == color.r &&
+                      header.color.g == color.g && header.color.b == color.b && header.color.a == color.a;
+
+        if (extend) {
+            header.count++;
+            std::memcpy(buffer.data() + lastRun, &header, sizeof(RunHeader));
+        } else {
+            header = {opcode, color, 1};
+            lastRun = buffer.size();
+
+            buffer.resize(buffer.size() + sizeof(RunHeader));
+            std::memcpy(buffer.data() + lastRun, &header, sizeof(RunHeader));
+        }
+
+        size_t offset = buffer.size();
+        buffer.resize(offset + args.size() * sizeof(float));
+        std::memcpy(buffer.data() + offset, args.begin(), args.size() * sizeof(float));
+
+        commandCount++;
+    }
+
+    size_t DisplayList::size() const {
+        return commandCount;
+    }
+
+    size_t DisplayList::byteSize() const {
+        return buffer.size();
+    }
+
+    bool DisplayList::empty() const {
+        return commandCount == 0;
+    }
+
+    void DisplayList::reset() {
+        buffer.clear();
+        lastRun = -1;
+        commandCount = 0;
+
+        references.clear();
+        polygons.clear();
+        images.clear();
+        filters.clear();
+    }
+
+    void DisplayList::replay(Canvas &target, float scale, float x, float y) const {
+        replayRegion(target, 0, 0, target.getWidth(), target.getHeight(), scale, x, y);
+    }
+
+    void DisplayList::replayRegion(Canvas &target, int r_x1, int r_y1, int r_x2, int r_y2, float scale, float x,
+                                   float y) const {
+        if (r_x1 > r_x2) std::swap(r_x1, r_x2);
+        if (r_y1 > r_y2) std::swap(r_y1, r_y2);
+
+        // Whether the box (x1, y1) -- (x2, y2), in target coordinates, touches the region
+        auto visible = [&](float x1, float y1, float x2, float y2) {
+            return !(std::min(x1, x2) >= r_x2 || std::min(y1, y2) >= r_y2 || std::max(x1, x2) < r_x1 ||
+                     std::max(y1, y2) < r_y1);
+        };
+
+        auto tx = [&](float v) { return v * scale + x; };
+        auto ty = [&](float v) { return v * scale + y; };
+
+        size_t pos = 0;
+        size_t reference = 0; // Next entry of references
+
+        while (pos < buffer.size()) {
+            RunHeader header;
+            std::memcpy(&header, buffer.data() + pos, sizeof(RunHeader));
+            pos += sizeof(RunHeader);
+
+            const int n = argumentCount(header.opcode);
+            const RGBA color = header.color;
+
+            // Dispatch once per run, then loop over its packed arguments
+            auto forEach = [&](auto func) {
+                float a[6];
+
+                for (uint32_t i = 0; i < header.count; i++) {
+                    std::memcpy(a, buffer.data() + pos + i * n * sizeof(float), n * sizeof(float));
+                    func(a);
+                }
+            };
+
+            switch (header.opcode) {
+                case Opcode::LINE_ALIASED:
+                case Opcode::LINE_ANTIALIASED: {
+                    bool aliased = header.opcode == Opcode::LINE_ALIASED;
+
+                    forEach([&](float *a) {
+                        float x1 = tx(a[0]), y1 = ty(a[1]), x2 = tx(a[2]), y2 = ty(a[3]);
+                        if (!visible(std::min(x1, x2) - 2, std::min(y1, y2) - 2, std::max(x1, x2) + 2,
+                                     std::max(y1, y2) + 2))
+                            return;
+
+                        if (aliased) {
+                            target.drawLineAliased(x1, y1, x2, y2, color);
+                        } else {
+                            target.drawLineAntialiased(x1, y1, x2, y2, color);
+                        }
+                    });
+                    break;
+                }
+                case Opcode::THICK_LINE_ALIASED:
+                case Opcode::THICK_LINE_ANTIALIASED: {
+                    bool aliased = header.opcode == Opcode::THICK_LINE_ALIASED;
+
+                    forEach([&](float *a) {
+                        float x1 = tx(a[0]), y1 = ty(a[1]), x2 = tx(a[2]), y2 = ty(a[3]);
+                        float thickness = a[4] * scale;
+                        float m = thickness + 2;
+
+                        if (!visible(std::min(x1, x2) - m, std::min(y1, y2) - m, std::max(x1, x2) + m,
+                                     std::max(y1, y2) + m))
+                            return;
+
+                        if (aliased) {
+                            target.drawThickLineAliased(x1, y1, x2, y2, thickness, color);
+                        } else {
+                            target.drawThickLineAntialiased(x1, y1, x2, y2, thickness, color);
+                        }
+                    });
+                    break;
+                }
+                case Opcode::QUADRATIC_BEZIER_ALIASED:
+                case Opcode::QUADRATIC_BEZIER_ANTIALIASED: {
+                    bool aliased = header.opcode == Opcode::QUADRATIC_BEZIER_ALIASED;
+
+                    forEach([&](float *a) {
+                        float x1 = tx(a[0]), y1 = ty(a[1]), x2 = tx(a[2]), y2 = ty(a[3]), x3 = tx(a[4]), y3 = ty(
+                                a[5]);
+
+                        // The rasterizers can stray several pixels outside the control hull, so a curve whose hull
+                        // misses the region is only culled once its real extent does too
+                        if (!visible(std::min({x1, x2, x3}) - 2, std::min({y1, y2, y3}) - 2,
+                                     std::max({x1, x2, x3}) + 2, std::max({y1, y2, y3}) + 2)) {
+                            auto[b_x1, b_y1, b_x2, b_y2] = Algorithms::quadraticBezierExtent(x1, y1, x2, y2, x3, y3,
+                                                                                             !aliased);
+
+                            if (b_x1 > b_x2 || !visible(b_x1, b_y1, b_x2, b_y2)) return;
+                        }
+
+                        if (aliased) {
+                            target.drawQuadraticBezierAliased(x1, y1, x2, y2, x3, y3, color);
+                        } else {
+                            target.drawQuadraticBezierAntialiased(x1, y1, x2, y2, x3, y3, color);
+                        }
+                    });
+                    break;
+                }
+                case Opcode::CIRCLE_ALIASED:
+                case Opcode::CIRCLE_ANTIALIASED:
+                case Opcode::FILLED_CIRCLE: {
+                    Opcode opcode = header.opcode;
+
+                    forEach([&](float *a) {
+                        float cx = tx(a[0]), cy = ty(a[1]), r = a[2] * scale;
+                        float m = std::abs(r) + 2;
+
+                        if (!visible(cx - m, cy - m, cx + m, cy + m))
+                            return;
+
+                        if (opcode == Opcode::CIRCLE_ALIASED) {
+                            target.drawCircleAliased(cx, cy, std::lround(r), color);
+                        } else if (opcode == Opcode::CIRCLE_ANTIALIASED) {
+                            target.drawCircleAntialiased(cx, cy, r, color);
+                        } else {
+                            target.drawFilledCircle(cx, cy, std::lround(r), color);
+                        }
+                    });
+                    break;
+                }
+                case Opcode::THICK_CIRCLE_ALIASED:
+                    forEach([&](float *a) {
+                        float cx = tx(a[0]), cy = ty(a[1]), r = a[2] * scale, thickness = a[3] * scale;
+                        float m = std::abs(r) + std::abs(thickness) + 2;
+
+                        if (!visible(cx - m, cy - m, cx + m, cy + m))
+                            return;
+
+                        target.drawThickCircleAliased(cx, cy, std::lround(r), thickness, color);
+                    });
+                    break;
+                case Opcode::RECT:
+                    forEach([&](float *a) {
+                        float x1 = tx(a[0]), y1 = ty(a[1]), x2 = tx(a[2]), y2 = ty(a[3]);
+
+                        if (!visible(x1, y1, x2, y2))
+                            return;
+
+                        target.fillRect(std::lround(x1), std::lround(y1), std::lround(x2), std::lround(y2), color);
+                    });
+                    break;
+                case Opcode::POLYGON:
+                    forEach([&](float *) {
+                        const auto &points = polygons[references[reference++]];
+                        std::vector<std::pair<float, float>> transformed;
+                        transformed.reserve(points.size());
+
+                        float x1 = INFINITY, y1 = INFINITY, x2 = -INFINITY, y2 = -INFINITY;
+
+                        for (const auto &p : points) {
+                            transformed.emplace_back(tx(p.first), ty(p.second));
+
+                            x1 = std::min(x1, transformed.back().first);
+                            y1 = std::min(y1, transformed.back().second);
+                            x2 = std::max(x2, transformed.back().first);
+                            y2 = std::max(y2, transformed.back().second);
+                        }
+
+                        if (!visible(x1 - 1, y1 - 1, x2 + 1, y2 + 1))
+                            return;
+
+                        target.fillPolygon(transformed, color);
+                    });
+                    break;
+                case Opcode::FILL:
+                    forEach([&](float *) {
+                        target.fill(color);
+                    });
+                    break;
+                case Opcode::MIX_IMAGE:
+                    target.flush(); // Images and filters work on pixels, so deferred drawing must land first
+
+                    forEach([&](float *a) {
+                        int p_x = std::lround(tx(a[0]));
+                        int p_y = std::lround(ty(a[1]));
+                        auto mix = static_cast<ColorUtils::ColorMix>(static_cast<int>(a[2]));
+
+                        std::visit([&](const auto &image) {
+                            if (!visible(p_x, p_y, p_x + image->getWidth() * scale,
+                                         p_y + image->getHeight() * scale))
+                                return;
+
+                            auto draw = [&](const auto &img) {
+                                using namespace ColorUtils;
+
+                                switch (mix) {
+                                    case ColorMix::AVERAGE:
+                                        target.mixImage<ColorMix::AVERAGE>(img, p_x, p_y);
+                                        break;
+                                    case ColorMix::ADDITION:
+                                        target.mixImage<ColorMix::ADDITION>(img, p_x, p_y);
+                                        break;
+                                    case ColorMix::MULTIPLICATION:
+                                        target.mixImage<ColorMix::MULTIPLICATION>(img, p_x, p_y);
+                                        break;
+                                    case ColorMix::SUBTRACTION:
+                                        target.mixImage<ColorMix::SUBTRACTION>(img, p_x, p_y);
+                                        break;
+                                    case ColorMix::REPLACE:
+                                        target.mixImage<ColorMix::REPLACE>(img, p_x, p_y);
+                                        break;
+                                    case ColorMix::MERGE:
+                                        target.mixImage<ColorMix::MERGE>(img, p_x, p_y);
+                                        break;
+                                }
+                            };
+
+                            if (scale == 1) {
+                                draw(*image);
+                            } else {
+                                draw(image->sample(scale));
+                            }
+                        }, images[references[reference++]]);
+                    });
+                    break;
+                case Opcode::FILTER:
+                    forEach([&](float *) {
+                        target.applyFilter(*filters[references[reference++]]);
+                    });
+                    break;
+            }
+
+            pos += header.count * n * sizeof(float);
+        }
+    }
+
+    void DisplayList::drawLineAliased(float x1, float y1, float x2, float y2, const RGBA &color) {
+        record(Opcode::LINE_ALIASED, color, {x1, y1, x2, y2});
+    }
+
+    void DisplayList::drawLineAntialiased(float x1, float y1, float x2, float y2, const RGBA &color) {
+        record(Opcode::LINE_ANTIALIASED, color, {x1, y1, x2, y2});
+    }
+
+    void DisplayList::drawThickLineAliased(float x1, float y1, float x2, float y2, float thickness,
+                                           const RGBA &color) {
+        record(Opcode::THICK_LINE_ALIASED, color, {x1, y1, x2, y2, thickness});
+    }
+
+    void DisplayList::drawThickLineAntialiased(float x1, float y1, float x2, float y2, float thickness,
+                                               const RGBA &color) {
+        record(Opcode::THICK_LINE_ANTIALIASED, color, {x1, y1, x2, y2, thickness});
+    }
+
+    void DisplayList::drawQuadraticBezierAliased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                                 const RGBA &color) {
+        record(Opcode::QUADRATIC_BEZIER_ALIASED, color, {x1, y1, x2, y2, x3, y3});
+    }
+
+    void DisplayList::drawQuadraticBezierAntialiased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                                     const RGBA &color) {
+        record(Opcode::QUADRATIC_BEZIER_ANTIALIASED, color, {x1, y1, x2, y2, x3, y3});
+    }
+
+    void DisplayList::drawCircleAliased(float x1, float y1, int r, const RGBA &color) {
+        record(Opcode::CIRCLE_ALIASED, color, {x1, y1, static_cast<float>(r)});
+    }
+
+    void DisplayList::drawCircleAntialiased(float x1, float y1, float r, const RGBA &color) {
+        record(Opcode::CIRCLE_ANTIALIASED, color, {x1, y1, r});
+    }
+
+    void DisplayList::drawThickCircleAliased(float x1, float y1, int r, float thickness, const RGBA &color) {
+        record(Opcode::THICK_CIRCLE_ALIASED, color, {x1, y1, static_cast<float>(r), thickness});
+    }
+
+    void DisplayList::drawFilledCircle(float x1, float y1, int r, const RGBA &color) {
+        record(Opcode::FILLED_CIRCLE, color, {x1, y1, static_cast<float>(r)});
+    }
+
+    void DisplayList::fillRect(int x1, int y1, int x2, int y2, const RGBA &color) {
+        record(Opcode::RECT, color,
+               {static_cast<float>(x1), static_cast<float>(y1), static_cast<float>(x2), static_cast<float>(y2)});
+    }
+
+    void DisplayList::fillPolygon(const std::vector<std::pair<float, float>> &points, const RGBA &color) {
+        references.push_back(polygons.size());
+        polygons.push_back(points);
+        record(Opcode::POLYGON, color, {});
+    }
+
+    void DisplayList::fill(Color color) {
+        record(Opcode::FILL, color.rgba(), {});
+    }
+
+    void DisplayList::clear() {
+        fill(RGBA(255, 255, 255, 0));
+    }
+
+    void DisplayList::applyFilter(std::shared_ptr<Filters::Filter> filter) {
+        references.push_back(filters.size());
+        filters.push_back(std::move(filter));
+        record(Opcode::FILTER, RGBA(), {});
+    }
+
+    void DisplayList::fuzz() {
+        applyFilter(std::make_shared<Filters::GaussianBlur<1>>());
+    }
+}
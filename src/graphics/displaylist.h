@@ -0,0 +1,220 @@
+#ifndef VISUALIZATION_DISPLAYLIST_H
+#define VISUALIZATION_DISPLAYLIST_H
+
+#include "canvas.h"
+#include "filters/filter.h"
+#include <memory>
+#include <variant>
+#include <vector>
+#include <cstring>
+
+namespace Sine::Graphics {
+    /**
+     * Records Canvas calls into a compact binary command buffer so they can be replayed onto any Canvas later.
+     *
+     * Consecutive calls of the same kind and color are stored as one run (a single header followed by packed float
+     * arguments), which keeps the buffer small and lets replay dispatch once per run. Replay can scale and translate
+     * the recording and skips primitives outside the target region. Replaying onto a TiledCanvas bins the primitives
+     * so the following flush() rasterizes them across threads.
+     */
+    class DisplayList {
+    public:
+        /**
+         * Kind of a recorded command.
+         */
+        enum class Opcode : uint8_t {
+            LINE_ALIASED,
+            LINE_ANTIALIASED,
+            THICK_LINE_ALIASED,
+            THICK_LINE_ANTIALIASED,
+            QUADRATIC_BEZIER_ALIASED,
+            QUADRATIC_BEZIER_ANTIALIASED,
+            CIRCLE_ALIASED,
+            CIRCLE_ANTIALIASED,
+            THICK_CIRCLE_ALIASED,
+            FILLED_CIRCLE,
+            RECT,
+            POLYGON,
+            FILL,
+            MIX_IMAGE,
+            FILTER
+        };
+
+    private:
+        /**
+         * Header preceding every run of commands with the same opcode and color.
+         */
+        struct RunHeader {
+            Opcode opcode;
+            RGBA color;
+            uint32_t count;
+        };
+
+        using Image = std::variant<std::shared_ptr<const Bitmap>, std::shared_ptr<const Graymap>,
+                std::shared_ptr<const RGBMap>, std::shared_ptr<const RGBAMap>>;
+
+        std::vector<uint8_t> buffer;
+
+        /*
+         * Offset of the header of the last run in buffer, or -1 if there is none.
+         */
+        long lastRun = -1;
+
+        size_t commandCount = 0;
+
+        /*
+         * Indices into polygons, images or filters used by the POLYGON, MIX_IMAGE and FILTER commands, in recording
+         * order. They are kept out of the float arguments, which could not represent large indices exactly.
+         */
+        std::vector<size_t> references;
+
+        std::vector<std::vector<std::pair<float, float>>> polygons;
+        std::vector<Image> images;
+        std::vector<std::shared_ptr<Filters::Filter>> filters;
+
+        /**
+         * Appends a command, extending the last run if it has the same opcode and color.
+         * @param opcode Kind of command.
+         * @param color Color of command.
+         * @param args Arguments, argumentCount(opcode) of them.
+         */
+        void record(Opcode opcode, const RGBA &color, std::initializer_list<float> args);
+
+        template<typename T>
+        void recordImage(const Pixmap<T> &image, ColorUtils::ColorMix mix, int x, int y) {
+            references.push_back(images.size());
+            images.emplace_back(std::make_shared<const Pixmap<T>>(image));
+
+            record(Opcode::MIX_IMAGE, RGBA(), {static_cast<float>(x), static_cast<float>(y), static_cast<float>(mix)});
+        }
+
+    public:
+        /**
+         * Number of float arguments stored per command of a given kind.
+         * @param opcode Kind of command.
+         * @return Argument count.
+         */
+        static int argumentCount(Opcode opcode);
+
+        /**
+         * Number of recorded commands.
+         * @return Command count.
+         */
+        size_t size() const;
+
+        /**
+         * Size of the command buffer, not counting images, polygons and filters.
+         * @return Size in bytes.
+         */
+        size_t byteSize() const;
+
+        /**
+         * Whether nothing has been recorded.
+         * @return Whether the list is empty.
+         */
+        bool empty() const;
+
+        /**
+         * Drops every recorded command.
+         */
+        void reset();
+
+        /**
+         * Replays the recording onto a Canvas, skipping primitives that fall outside it.
+         * @param target Canvas to draw to.
+         * @param scale Factor applied to all coordinates, radii and thicknesses.
+         * @param x X offset added after scaling.
+         * @param y Y offset added after scaling.
+         */
+        void replay(Canvas &target, float scale = 1, float x = 0, float y = 0) const;
+
+        /**
+         * Replays the recording onto a Canvas, skipping primitives that fall outside (r_x1, r_y1) x (r_x2, r_y2).
+         *
+         * Primitives that touch the region are drawn in full, so this is a cull rather than a clip.
+         * @param target Canvas to draw to.
+         * @param r_x1 X coordinate of region corner 1.
+         * @param r_y1 Y coordinate of region corner 1.
+         * @param r_x2 X coordinate of region corner 2.
+         * @param r_y2 Y coordinate of region corner 2.
+         * @param scale Factor applied to all coordinates, radii and thicknesses.
+         * @param x X offset added after scaling.
+         * @param y Y offset added after scaling.
+         */
+        void replayRegion(Canvas &target, int r_x1, int r_y1, int r_x2, int r_y2, float scale = 1, float x = 0,
+                          float y = 0) const;
+
+        aliasSelector(drawLine, drawLineAliased, drawLineAntialiased);
+
+        aliasSelector(drawThickLine, drawThickLineAliased, drawThickLineAntialiased);
+
+        aliasSelector(drawQuadraticBezier, drawQuadraticBezierAliased, drawQuadraticBezierAntialiased);
+
+        aliasSelector(drawCircle, drawCircleAliased, drawCircleAntialiased);
+
+        void drawLineAliased(float x1, float y1, float x2, float y2, const RGBA &color = Colors::BLACK);
+
+        void drawLineAntialiased(float x1, float y1, float x2, float y2, const RGBA &color = Colors::BLACK);
+
+        void drawThickLineAliased(float x1, float y1, float x2, float y2, float thickness,
+                                  const RGBA &color = Colors::BLACK);
+
+        void drawThickLineAntialiased(float x1, float y1, float x2, float y2, float thickness,
+                                      const RGBA &color = Colors::BLACK);
+
+        void drawQuadraticBezierAliased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                        const RGBA &color = Colors::BLACK);
+
+        void drawQuadraticBezierAntialiased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                            const RGBA &color = Colors::BLACK);
+
+        void drawCircleAliased(float x1, float y1, int r, const RGBA &color = Colors::BLACK);
+
+        void drawCircleAntialiased(float x1, float y1, float r, const RGBA &color = Colors::BLACK);
+
+        void drawThickCircleAliased(float x1, float y1, int r, float thickness, const RGBA &color);
+
+        void drawFilledCircle(float x1, float y1, int r, const RGBA &color = Colors::BLACK);
+
+        void fillRect(int x1, int y1, int x2, int y2, const RGBA &color);
+
+        void fillPolygon(const std::vector<std::pair<float, float>> &points, const RGBA &color);
+
+        /**
+         * Records filling the entire canvas uniformly with a given color.
+         * @param color Color fill.
+         */
+        void fill(Color color);
+
+        /**
+         * Records filling the entire canvas with a completely transparent white.
+         */
+        void clear();
+
+        /**
+         * Records mixing in an image; the image is copied, so later changes to it are not recorded.
+         * @tparam mix Mix type
+         * @tparam T Pixel type of Pixmap
+         * @param image Pixmap instance
+         * @param x X coordinate of pasted position
+         * @param y Y coordinate of pasted position
+         */
+        template<ColorUtils::ColorMix mix = ColorUtils::ColorMix::MERGE, typename T>
+        void mixImage(const Pixmap<T> &image, int x = 0, int y = 0) {
+            recordImage(image, mix, x, y);
+        }
+
+        /**
+         * Records applying a filter to the whole canvas. The filter is shared, not copied.
+         * @param filter Filter instance.
+         */
+        void applyFilter(std::shared_ptr<Filters::Filter> filter);
+
+        /**
+         * Records the little blur of Canvas::fuzz().
+         */
+        void fuzz();
+    };
+}
+
+#endif //VISUALIZATION_DISPLAYLIST_H
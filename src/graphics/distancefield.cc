@@ -0,0 +1,265 @@
+#include "distancefield.h"
+#include "parallel.h"
+#include <cmath>
+#include <limits>
+
+namespace Sine::Graphics {
+    namespace {
+        /*
+         * Squared distance standing in for infinity, large enough to never win but small enough to do arithmetic on.
+         */
+        const float FAR = 1e20f;
+
+        /**
+         * One-dimensional squared distance transform of a sampled function: d[q] = min over p of (q - p)^2 + f[p].
+         * @param f Input of n values.
+         * @param d Output of n values.
+         * @param v Scratch space for n parabola locations.
+         * @param z Scratch space for n + 1 parabola boundaries.
+         */
+        void transform1D(const float *f, float *d, int n, int *v, float *z) {
+            int k = 0;
+            v[0] = 0;
+            z[0] = -std::numeric_limits<float>::infinity();
+            z[1] = std::numeric_limits<float>::infinity();
+
+            // Lower envelope of the parabolas rooted at each sample
+            for (int q = 1; q < n; q++) {
+                float s;
+
+                // z[0] is minus infinity, so this stops at the first parabola at the latest
+                while (true) {
+                    int p = v[k];
+                    s = ((f[q] + static_cast<float>(q) * q) - (f[p] + static_cast<float>(p) * p)) / (2.0f * (q - p));
+
+                    if (s > z[k]) break;
+                    k--;
+                }
+
+                k++;
+                v[k] = q;
+                z[k] = s;
+                z[k + 1] = std::numeric_limits<float>::infinity();
+            }
+
+            k = 0;
+
+            for (int q = 0; q < n; q++) {
+                while (z[k + 1] < q) k++;
+
+                float dq = static_cast<float>(q - v[k]);
+                d[q] = dq * dq + f[v[k]];
+            }
+        }
+    }
+
+    DistanceField::DistanceField(int _width, int _height, bool _isSigned)
+            : width(_width), height(_height), isSignedField(_isSigned),
+              distances(static_cast<size_t>(_width) * _height) {
+    }
+
+    std::vector<float> DistanceField::squaredDistances(const Bitmap &mask, bool value) {
+        int width = mask.getWidth();
+        int height = mask.getHeight();
+        const bool *pixels = mask.getPixels();
+
+        std::vector<float> ret(static_cast<size_t>(width) * height);
+
+        // Down every column
+        Parallel::parallelBands(0, width, [&](int x1, int x2) {
+            std::vector<float> f(height), d(height), z(height + 1);
+            std::vector<int> v(height);
+
+            for (int x = x1; x < x2; x++) {
+                for (int y = 0; y < height; y++) {
+                    f[y] = pixels[static_cast<size_t>(y) * width + x] == value ? 0 : FAR;
+                }
+
+                transform1D(f.data(), d.data(), height, v.data(), z.data());
+
+                for (int y = 0; y < height; y++) {
+                    ret[static_cast<size_t>(y) * width + x] = d[y];
+                }
+            }
+        });
+
+        // Then along every row
+        Parallel::parallelBands(0, height, [&](int y1, int y2) {
+            std::vector<float> f(width), z(width + 1);
+            std::vector<int> v(width);
+
+            for (int y = y1; y < y2; y++) {
+                float *row = &ret[static_cast<size_t>(y) * width];
+
+                std::copy(row, row + width, f.begin());
+                transform1D(f.data(), row, width, v.data(), z.data());
+            }
+        });
+
+        return ret;
+    }
+
+    DistanceField DistanceField::fromBitmap(const Bitmap &mask) {
+        DistanceField ret(mask.getWidth(), mask.getHeight(), false);
+
+        if (mask.getArea() == 0) return ret;
+
+        std::vector<float> squared = squaredDistances(mask, true);
+
+        Parallel::parallelBands(0, mask.getArea(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) {
+                ret.distances[i] = squared[i] >= FAR / 2 ? std::numeric_limits<float>::infinity()
+                                                         : std::sqrt(squared[i]);
+            }
+        });
+
+        return ret;
+    }
+
+    DistanceField DistanceField::signedFromBitmap(const Bitmap &mask) {
+        DistanceField ret(mask.getWidth(), mask.getHeight(), true);
+
+        if (mask.getArea() == 0) return ret;
+
+        std::vector<float> outside = squaredDistances(mask, true);
+        std::vector<float> inside = squaredDistances(mask, false);
+        const bool *pixels = mask.getPixels();
+
+        // Pixel centers are half a pixel from the boundary between a set and an unset pixel
+        Parallel::parallelBands(0, mask.getArea(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) {
+                float squared = pixels[i] ? inside[i] : outside[i];
+                float distance = squared >= FAR / 2 ? std::numeric_limits<float>::infinity()
+                                                    : std::sqrt(squared) - 0.5f;
+
+                ret.distances[i] = pixels[i] ? -distance : distance;
+            }
+        });
+
+        return ret;
+    }
+
+    namespace {
+        Bitmap threshold(const Graymap &image, uint8_t threshold) {
+            Bitmap ret(image.getWidth(), image.getHeight());
+            const uint8_t *in = image.getPixels();
+            bool *out = ret.getPixels();
+
+            Parallel::parallelBands(0, image.getArea(), [&](int i1, int i2) {
+                for (int i = i1; i < i2; i++) out[i] = in[i] >= threshold;
+            });
+
+            return ret;
+        }
+    }
+
+    DistanceField DistanceField::fromGraymap(const Graymap &image, uint8_t threshold) {
+        return fromBitmap(Graphics::threshold(image, threshold));
+    }
+
+    DistanceField DistanceField::signedFromGraymap(const Graymap &image, uint8_t threshold) {
+        return signedFromBitmap(Graphics::threshold(image, threshold));
+    }
+
+    int DistanceField::getWidth() const {
+        return width;
+    }
+
+    int DistanceField::getHeight() const {
+        return height;
+    }
+
+    bool DistanceField::isSigned() const {
+        return isSignedField;
+    }
+
+    float DistanceField::getUnsafe(int x, int y) const {
+        return distances[static_cast<size_t>(y) * width + x];
+    }
+
+    float DistanceField::get(int x, int y) const {
+        return getUnsafe(std::min(std::max(x, 0), width - 1), std::min(std::max(y, 0), height - 1));
+    }
+
+    const std::vector<float> &DistanceField::getDistances() const {
+        return distances;
+    }
+
+    Graymap DistanceField::toGraymap(float scale, float bias) const {
+        Graymap ret(width, height);
+        uint8_t *out = ret.getPixels();
+
+        Parallel::parallelBands(0, ret.getArea(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) {
+                float v = distances[i] * scale + bias;
+                out[i] = static_cast<uint8_t>(std::min(std::max(v + 0.5f, 0.0f), 255.0f));
+            }
+        });
+
+        return ret;
+    }
+
+    Bitmap DistanceField::offset(float distance) const {
+        Bitmap ret(width, height);
+        bool *out = ret.getPixels();
+
+        Parallel::parallelBands(0, ret.getArea(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) out[i] = distances[i] <= distance;
+        });
+
+        return ret;
+    }
+
+    namespace {
+        /**
+         * Builds a layer of a single color whose alpha is scaled by a coverage function of the pixel.
+         */
+        template<typename Coverage>
+        RGBAMap layer(int width, int height, const RGBA &color, Coverage coverage) {
+            RGBAMap ret(width, height);
+            RGBA *out = ret.getPixels();
+
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                for (int y = y1; y < y2; y++) {
+                    for (int x = 0; x < width; x++) {
+                        float c = std::min(std::max(coverage(x, y), 0.0f), 1.0f);
+                        out[static_cast<size_t>(y) * width + x] = RGBA(color.r, color.g, color.b,
+                                                                       static_cast<uint8_t>(color.a * c + 0.5f));
+                    }
+                }
+            });
+
+            return ret;
+        }
+    }
+
+    RGBAMap DistanceField::outline(float lineWidth, const RGBA &color, float distance) const {
+        // Coverage falls off over one pixel at either side of the line, for antialiasing
+        return layer(width, height, color, [&](int x, int y) {
+            return lineWidth / 2 + 0.5f - std::abs(getUnsafe(x, y) - distance);
+        });
+    }
+
+    RGBAMap DistanceField::glow(float radius, const RGBA &color) const {
+        return layer(width, height, color, [&](int x, int y) {
+            float d = std::max(getUnsafe(x, y), 0.0f);
+            if (d >= radius) return 0.0f;
+
+            float t = 1 - d / radius;
+            return t * t;
+        });
+    }
+
+    RGBAMap DistanceField::dropShadow(int dx, int dy, float softness, const RGBA &color) const {
+        float edge = std::max(softness, 1.0f);
+
+        return layer(width, height, color, [&](int x, int y) {
+            float d = get(x - dx, y - dy);
+
+            // Unsigned fields only know the shape's interior as 0; put their boundary between pixels too
+            if (!isSignedField) d = d == 0 ? -0.5f : d - 0.5f;
+
+            return 0.5f - d / edge;
+        });
+    }
+}
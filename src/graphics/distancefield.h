@@ -0,0 +1,146 @@
+#ifndef VISUALIZATION_DISTANCEFIELD_H
+#define VISUALIZATION_DISTANCEFIELD_H
+
+#include "pixmap.h"
+#include <vector>
+
+namespace Sine::Graphics {
+    /**
+     * Euclidean distance field of a shape, in pixels, and the effects drawn from it.
+     *
+     * Distances are exact, computed with the Felzenszwalb - Huttenlocher transform: a lower envelope of parabolas
+     * down every column and then along every row, each taking linear time and split across threads. Signed fields
+     * are negative inside the shape and positive outside, with the zero crossing on the boundary between pixels;
+     * unsigned fields are 0 on the shape. Once a field is computed, every effect costs constant time per pixel
+     * whatever its radius.
+     */
+    class DistanceField {
+    private:
+        int width;
+        int height;
+        bool isSignedField;
+        std::vector<float> distances;
+
+        DistanceField(int width, int height, bool isSigned);
+
+        /**
+         * Squared distance from every pixel to the nearest pixel of a mask.
+         */
+        static std::vector<float> squaredDistances(const Bitmap &mask, bool value);
+
+    public:
+        /**
+         * Unsigned field: distance from every pixel to the nearest set pixel of a mask, or infinity if it has none.
+         * @param mask Shape.
+         * @return Distance field.
+         */
+        static DistanceField fromBitmap(const Bitmap &mask);
+
+        /**
+         * Unsigned field of the pixels of a Graymap at or above a threshold.
+         * @param image Image.
+         * @param threshold Lowest value belonging to the shape.
+         * @return Distance field.
+         */
+        static DistanceField fromGraymap(const Graymap &image, uint8_t threshold = 128);
+
+        /**
+         * Signed field of the set pixels of a mask.
+         * @param mask Shape.
+         * @return Distance field.
+         */
+        static DistanceField signedFromBitmap(const Bitmap &mask);
+
+        /**
+         * Signed field of the pixels of a Graymap at or above a threshold.
+         * @param image Image.
+         * @param threshold Lowest value belonging to the shape.
+         * @return Distance field.
+         */
+        static DistanceField signedFromGraymap(const Graymap &image, uint8_t threshold = 128);
+
+        /**
+         * Getter for width.
+         * @return Width in pixels.
+         */
+        int getWidth() const;
+
+        /**
+         * Getter for height.
+         * @return Height in pixels.
+         */
+        int getHeight() const;
+
+        /**
+         * Whether the field is signed.
+         * @return Whether the field is signed.
+         */
+        bool isSigned() const;
+
+        /**
+         * Distance at a pixel, without bounds checking.
+         * @param x x coordinate.
+         * @param y y coordinate.
+         * @return Distance in pixels.
+         */
+        float getUnsafe(int x, int y) const;
+
+        /**
+         * Distance at a pixel, clamped to the field.
+         * @param x x coordinate.
+         * @param y y coordinate.
+         * @return Distance in pixels.
+         */
+        float get(int x, int y) const;
+
+        /**
+         * Getter for distances.
+         * @return Row-major distances.
+         */
+        const std::vector<float> &getDistances() const;
+
+        /**
+         * Converts the field to a Graymap, with values distance * scale + bias clamped to 0 - 255.
+         * @param scale Levels per pixel of distance.
+         * @param bias Level of distance 0.
+         * @return Graymap.
+         */
+        Graymap toGraymap(float scale = 1, float bias = 0) const;
+
+        /**
+         * Shape grown (positive distance) or shrunk (negative distance) by a distance.
+         * @param distance Offset in pixels.
+         * @return Pixels whose distance is at most the offset.
+         */
+        Bitmap offset(float distance) const;
+
+        /**
+         * Antialiased line following the curve at a fixed distance from the shape.
+         * @param width Line width in pixels.
+         * @param color Line color.
+         * @param distance Offset of the curve; 0 follows the boundary of signed fields.
+         * @return Layer to composite, transparent elsewhere.
+         */
+        RGBAMap outline(float width, const RGBA &color, float distance = 0) const;
+
+        /**
+         * Glow fading out over a radius from the shape.
+         * @param radius Distance at which the glow vanishes.
+         * @param color Glow color at the shape.
+         * @return Layer to composite, transparent elsewhere.
+         */
+        RGBAMap glow(float radius, const RGBA &color) const;
+
+        /**
+         * Soft shadow of the shape, displaced by an offset.
+         * @param dx Horizontal offset in pixels.
+         * @param dy Vertical offset in pixels.
+         * @param softness Width of the shadow's blurred edge in pixels.
+         * @param color Shadow color.
+         * @return Layer to composite, transparent elsewhere.
+         */
+        RGBAMap dropShadow(int dx, int dy, float softness, const RGBA &color) const;
+    };
+}
+
+#endif //VISUALIZATION_DISTANCEFIELD_H
@@ -0,0 +1,143 @@
+#include "exportqueue.h"
+#include <algorithm>
+
+namespace Sine::Graphics {
+    namespace {
+        double seconds(ExportQueue::Clock::duration duration) {
+            return std::chrono::duration<double>(duration).count();
+        }
+    }
+
+    ExportQueue::ExportQueue(unsigned int workerCount, size_t _capacity)
+            : capacity(std::max<size_t>(_capacity, 1)), created(Clock::now()) {
+        workerCount = std::max(workerCount, 1U);
+        workers.reserve(workerCount);
+
+        for (unsigned int i = 0; i < workerCount; i++) {
+            workers.emplace_back(&ExportQueue::run, this);
+        }
+    }
+
+    ExportQueue::~ExportQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        notEmpty.notify_all();
+
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    std::future<void> ExportQueue::enqueue(std::function<void()> encode, const std::string &path, Callback callback) {
+        Job job;
+        job.encode = std::move(encode);
+        job.path = path;
+        job.callback = std::move(callback);
+
+        std::future<void> ret = job.done.get_future();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Clock::time_point start = Clock::now();
+
+            notFull.wait(lock, [&]() { return jobs.size() < capacity; });
+
+            job.queued = Clock::now();
+            stats.blockedSeconds += seconds(job.queued - start);
+            stats.submitted++;
+
+            jobs.push_back(std::move(job));
+        }
+
+        notEmpty.notify_one();
+
+        return ret;
+    }
+
+    void ExportQueue::run() {
+        while (true) {
+            Job job;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [&]() { return stopping || !jobs.empty(); });
+
+                // Stopping still drains the queue
+                if (jobs.empty()) return;
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                active++;
+
+                double wait = seconds(Clock::now() - job.queued);
+                stats.waitSeconds += wait;
+                stats.maxWaitSeconds = std::max(stats.maxWaitSeconds, wait);
+            }
+
+            notFull.notify_one();
+
+            Clock::time_point start = Clock::now();
+            std::exception_ptr error = nullptr;
+
+            try {
+                job.encode();
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            double encode = seconds(Clock::now() - start);
+
+            if (job.callback) {
+                try {
+                    job.callback(job.path, error);
+                } catch (...) {
+                    // A throwing callback must not take the worker down
+                }
+            }
+
+            // Counted before the future is ready, so stats read after it include this export
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                active--;
+                stats.completed++;
+                stats.encodeSeconds += encode;
+
+                if (error) stats.failed++;
+            }
+
+            if (error) {
+                job.done.set_exception(error);
+            } else {
+                job.done.set_value();
+            }
+
+            idle.notify_all();
+        }
+    }
+
+    void ExportQueue::wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&]() { return jobs.empty() && active == 0; });
+    }
+
+    ExportQueue::Stats ExportQueue::getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats ret = stats;
+
+        ret.pending = jobs.size() + active;
+        ret.elapsedSeconds = seconds(Clock::now() - created);
+
+        return ret;
+    }
+
+    size_t ExportQueue::getCapacity() const {
+        return capacity;
+    }
+
+    unsigned int ExportQueue::getWorkerCount() const {
+        return workers.size();
+    }
+}
@@ -0,0 +1,177 @@
+#ifndef VISUALIZATION_EXPORTQUEUE_H
+#define VISUALIZATION_EXPORTQUEUE_H
+
+#include "imageutils.h"
+#include "pixmap.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Sine::Graphics {
+    /**
+     * Exports images on background threads, so a renderer can draw the next frame while the last one is encoded.
+     *
+     * The queue takes ownership of each image: move it in to hand it over for free, or pass it by reference to export
+     * a copy while the caller keeps drawing on the original. At most a fixed number of images wait at once; pushing
+     * onto a full queue blocks until a worker takes the oldest image, which bounds memory when encoding is slower than
+     * rendering. The destructor exports everything still queued.
+     */
+    class ExportQueue {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * Called on the worker thread once an export finishes.
+         * @param path Path of the file.
+         * @param error Exception thrown by the export, or nullptr on success.
+         */
+        using Callback = std::function<void(const std::string &path, std::exception_ptr error)>;
+
+        /**
+         * Counters since the queue was constructed.
+         */
+        struct Stats {
+            uint64_t submitted = 0;
+            uint64_t completed = 0; ///< Exports finished, including failures
+            uint64_t failed = 0;
+            size_t pending = 0; ///< Images queued or being exported
+            double elapsedSeconds = 0; ///< Time since the queue was constructed
+            double encodeSeconds = 0; ///< Total time spent exporting
+            double waitSeconds = 0; ///< Total time images spent queued before a worker took them
+            double maxWaitSeconds = 0;
+            double blockedSeconds = 0; ///< Total time pushes spent waiting for room in the queue
+
+            /**
+             * Exports finished per second since the queue was constructed.
+             * @return Throughput.
+             */
+            double throughput() const {
+                return elapsedSeconds > 0 ? completed / elapsedSeconds : 0;
+            }
+
+            /**
+             * Mean time an image spent queued.
+             * @return Latency in seconds.
+             */
+            double meanWaitSeconds() const {
+                return completed > 0 ? waitSeconds / completed : 0;
+            }
+
+            /**
+             * Mean time spent exporting an image.
+             * @return Time in seconds.
+             */
+            double meanEncodeSeconds() const {
+                return completed > 0 ? encodeSeconds / completed : 0;
+            }
+        };
+
+    private:
+        struct Job {
+            std::function<void()> encode;
+            std::string path;
+            Callback callback;
+            std::promise<void> done;
+            Clock::time_point queued;
+        };
+
+        size_t capacity;
+        Clock::time_point created;
+
+        mutable std::mutex mutex;
+        std::condition_variable notFull;
+        std::condition_variable notEmpty;
+        std::condition_variable idle;
+
+        std::deque<Job> jobs;
+        size_t active = 0; ///< Jobs taken by workers and not yet finished
+        bool stopping = false;
+        Stats stats;
+
+        std::vector<std::thread> workers;
+
+        std::future<void> enqueue(std::function<void()> encode, const std::string &path, Callback callback);
+
+        void run();
+
+    public:
+        /**
+         * Constructor starting the workers.
+         * @param workerCount Number of images exported at once. Encoders are themselves parallel, so one is often
+         * enough.
+         * @param capacity Maximum number of images waiting to be exported.
+         */
+        explicit ExportQueue(unsigned int workerCount = 1, size_t capacity = 4);
+
+        ExportQueue(const ExportQueue &) = delete;
+
+        ExportQueue &operator=(const ExportQueue &) = delete;
+
+        /**
+         * Destructor, which exports every queued image and then stops the workers.
+         */
+        ~ExportQueue();
+
+        /**
+         * Queues an image for export, blocking while the queue is full.
+         * @tparam T Pixel type.
+         * @param image Image, moved or copied in.
+         * @param path Path of the file.
+         * @param type Format, or ImageType::UNKNOWN to use the extension of the path.
+         * @param callback Optional function called on the worker thread when the export finishes.
+         * @return Future which becomes ready when the export finishes, and rethrows its exception if it failed.
+         */
+        template<typename T>
+        std::future<void> push(Pixmap<T> image, const std::string &path, ImageType type = ImageType::UNKNOWN,
+                               Callback callback = nullptr) {
+            if (type == ImageType::UNKNOWN) type = extractImageType(path);
+
+            if (type == ImageType::UNKNOWN) {
+                throw std::invalid_argument("Unknown image type for " + path + ".");
+            }
+
+            // std::function must be copyable, so the image is held by a shared pointer
+            auto owned = std::make_shared<Pixmap<T>>(std::move(image));
+
+            return enqueue([owned, path, type]() {
+                if (!owned->exportToFile(path, type)) {
+                    throw std::runtime_error("Could not export " + path + ".");
+                }
+            }, path, std::move(callback));
+        }
+
+        /**
+         * Blocks until every queued image has been exported.
+         */
+        void wait();
+
+        /**
+         * Getter for statistics.
+         * @return Snapshot of the counters.
+         */
+        Stats getStats() const;
+
+        /**
+         * Getter for capacity.
+         * @return Maximum number of images waiting to be exported.
+         */
+        size_t getCapacity() const;
+
+        /**
+         * Getter for worker count.
+         * @return Number of worker threads.
+         */
+        unsigned int getWorkerCount() const;
+    };
+}
+
+#endif //VISUALIZATION_EXPORTQUEUE_H
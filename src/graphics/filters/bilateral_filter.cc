@@ -0,0 +1,202 @@
+#include "bilateral_filter.h"
+#include "channels.h"
+#include "convolution.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            /*
+             * Empty cells around the grid, enough for the blur kernel to never reach past them.
+             */
+            const int GRID_PADDING = 2;
+
+            /*
+             * Binomial approximation of a Gaussian with a standard deviation of one cell.
+             */
+            const std::vector<float> GRID_KERNEL = {1 / 16.0f, 4 / 16.0f, 6 / 16.0f, 4 / 16.0f, 1 / 16.0f};
+
+            inline float luma(const float *c, int channels) {
+                return channels >= 3 ? 0.299f * c[0] + 0.587f * c[1] + 0.114f * c[2] : c[0];
+            }
+
+            /**
+             * Position of a pixel in the grid, split into the lower cell and the fractional offset in each axis.
+             */
+            struct GridPoint {
+                int x, y, z;
+                float fx, fy, fz;
+
+                GridPoint(float gx, float gy, float gz) {
+                    x = static_cast<int>(gx);
+                    y = static_cast<int>(gy);
+                    z = static_cast<int>(gz);
+                    fx = gx - x;
+                    fy = gy - y;
+                    fz = gz - z;
+                }
+
+                /**
+                 * Calls func(cell, weight) for the eight surrounding cells.
+                 */
+                template<typename Func>
+                void forEachCorner(int gridWidth, int gridDepth, Func func) const {
+                    for (int dy = 0; dy < 2; dy++) {
+                        float wy = dy ? fy : 1 - fy;
+
+                        for (int dx = 0; dx < 2; dx++) {
+                            float wxy = wy * (dx ? fx : 1 - fx);
+                            size_t cell = (static_cast<size_t>(y + dy) * gridWidth + x + dx) * gridDepth + z;
+
+                            func(cell, wxy * (1 - fz));
+                            func(cell + 1, wxy * fz);
+                        }
+                    }
+                }
+            };
+        }
+
+        BilateralFilter::BilateralFilter(float _spatialSigma, float _rangeSigma)
+                : spatialSigma(_spatialSigma), rangeSigma(_rangeSigma) {
+            if (!(spatialSigma >= 1) || !(rangeSigma > 0)) {
+                throw std::invalid_argument("Bilateral filter needs a spatial sigma of at least 1 and a positive "
+                                            "range sigma.");
+            }
+        }
+
+        float BilateralFilter::getSpatialSigma() const {
+            return spatialSigma;
+        }
+
+        float BilateralFilter::getRangeSigma() const {
+            return rangeSigma;
+        }
+
+        template<typename T>
+        void BilateralFilter::filter(Pixmap<T> &map) const {
+            constexpr int C = ChannelTraits<T>::count;
+            constexpr int K = C + 1; // Channel sums and the weight
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+
+            if (map.getArea() == 0) return;
+
+            int gridWidth = static_cast<int>((width - 1) / spatialSigma) + 2 + 2 * GRID_PADDING;
+            int gridHeight = static_cast<int>((height - 1) / spatialSigma) + 2 + 2 * GRID_PADDING;
+            int gridDepth = static_cast<int>(255 / rangeSigma) + 2 + 2 * GRID_PADDING;
+            size_t gridSize = static_cast<size_t>(gridWidth) * gridHeight * gridDepth * K;
+
+            std::vector<float> data = loadChannels<float>(map);
+
+            auto locate = [&](int x, int y) {
+                return GridPoint(x / spatialSigma + GRID_PADDING, y / spatialSigma + GRID_PADDING,
+                                 luma(&data[(static_cast<size_t>(y) * width + x) * C], C) / rangeSigma
+                                 + GRID_PADDING);
+            };
+
+            // Splat in parallel bands of grid rows. Each band writes the rows it owns straight into the grid; only
+            // the row past them, which its last pixels also reach, goes to a buffer of its own, added in afterwards.
+            size_t rowSize = static_cast<size_t>(gridWidth) * gridDepth * K;
+            std::vector<float> grid(gridSize, 0.0f);
+
+            std::vector<int> rowCell(height);
+
+            for (int y = 0; y < height; y++) {
+                rowCell[y] = static_cast<int>(y / spatialSigma + GRID_PADDING);
+            }
+
+            int bands = std::max(std::min<int>(Parallel::threadCount(), gridHeight), 1);
+            std::vector<std::vector<float>> overlaps(bands);
+
+            Parallel::parallelFor(0, bands, [&](int band) {
+                int g1 = static_cast<long>(gridHeight) * band / bands;
+                int g2 = static_cast<long>(gridHeight) * (band + 1) / bands;
+
+                // Pixel rows whose lower grid row is in [g1, g2)
+                int y1 = std::lower_bound(rowCell.begin(), rowCell.end(), g1) - rowCell.begin();
+                int y2 = std::lower_bound(rowCell.begin(), rowCell.end(), g2) - rowCell.begin();
+
+                if (y1 == y2) return;
+
+                // The last band's pixels never reach past the padding at the bottom of the grid
+                std::vector<float> &overlap = overlaps[band];
+                if (g2 < gridHeight) overlap.assign(rowSize, 0.0f);
+
+                size_t end = g2 * rowSize;
+
+                for (int y = y1; y < y2; y++) {
+                    for (int x = 0; x < width; x++) {
+                        const float *pixel = &data[(static_cast<size_t>(y) * width + x) * C];
+
+                        locate(x, y).forEachCorner(gridWidth, gridDepth, [&](size_t cell, float weight) {
+                            size_t i = cell * K;
+                            float *out = i < end ? &grid[i] : &overlap[i - end];
+
+                            for (int c = 0; c < C; c++) out[c] += weight * pixel[c];
+                            out[C] += weight;
+                        });
+                    }
+                }
+            });
+
+            // Every band's overlap is the first row of the next band, so these never collide
+            Parallel::parallelFor(0, bands, [&](int band) {
+                const std::vector<float> &overlap = overlaps[band];
+                if (overlap.empty()) return;
+
+                float *row = &grid[static_cast<long>(gridHeight) * (band + 1) / bands * rowSize];
+
+                for (size_t i = 0; i < rowSize; i++) row[i] += overlap[i];
+            });
+
+            overlaps.clear();
+
+            // Blur across x and y with each cell's depth as channels, then along the depth
+            std::vector<float> identity = {1};
+
+            convolveSeparable(grid, gridWidth, gridHeight, gridDepth * K, GRID_KERNEL, GRID_KERNEL);
+            convolveSeparable(grid, gridDepth, gridWidth * gridHeight, K, GRID_KERNEL, identity);
+
+            // Slice: read every pixel back by trilinear interpolation
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                for (int y = y1; y < y2; y++) {
+                    for (int x = 0; x < width; x++) {
+                        float sum[K] = {};
+
+                        locate(x, y).forEachCorner(gridWidth, gridDepth, [&](size_t cell, float weight) {
+                            const float *in = &grid[cell * K];
+
+                            for (int c = 0; c < K; c++) sum[c] += weight * in[c];
+                        });
+
+                        if (sum[C] > 0) {
+                            float *pixel = &data[(static_cast<size_t>(y) * width + x) * C];
+
+                            for (int c = 0; c < C; c++) pixel[c] = sum[c] / sum[C];
+                        }
+                    }
+                }
+            });
+
+            storeChannels(map, data);
+        }
+
+        void BilateralFilter::applyTo(Bitmap &) {
+        }
+
+        void BilateralFilter::applyTo(Graymap &map) {
+            filter(map);
+        }
+
+        void BilateralFilter::applyTo(RGBMap &map) {
+            filter(map);
+        }
+
+        void BilateralFilter::applyTo(RGBAMap &map) {
+            filter(map);
+        }
+    }
+}
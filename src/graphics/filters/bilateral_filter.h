@@ -0,0 +1,56 @@
+#ifndef BILATERAL_FILTER_DEFINED_
+#define BILATERAL_FILTER_DEFINED_
+
+#include "filter.h"
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * Edge-preserving smoothing which averages pixels that are both close in position and similar in brightness.
+         *
+         * Implemented with a bilateral grid (Chen, Paris and Durand): pixels are splatted into a coarse 3-D grid over
+         * position and luma with cells of spatialSigma pixels by rangeSigma levels, the grid is blurred with a small
+         * separable kernel, and each pixel reads its result back by trilinear interpolation. The cost is linear in the
+         * number of pixels and does not grow with spatialSigma. All channels, including alpha, share the weights
+         * computed from the luma of the color. Bitmaps are left unchanged.
+         */
+        class BilateralFilter : public Filter {
+        private:
+            float spatialSigma;
+            float rangeSigma;
+
+            template<typename T>
+            void filter(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Constructor.
+             * @param spatialSigma Spatial extent in pixels, at least 1.
+             * @param rangeSigma Range extent in levels of the 0 - 255 scale, positive.
+             */
+            BilateralFilter(float spatialSigma, float rangeSigma);
+
+            /**
+             * Getter for spatial extent.
+             * @return Spatial extent in pixels.
+             */
+            float getSpatialSigma() const;
+
+            /**
+             * Getter for range extent.
+             * @return Range extent in levels.
+             */
+            float getRangeSigma() const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,44 @@
+#include "box_blur.h"
+#include "../integralimage.h"
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        BoxBlur::BoxBlur(int _radiusX, int _radiusY) : radiusX(_radiusX), radiusY(_radiusY) {
+            if (radiusX < 0 || radiusY < 0) {
+                throw std::invalid_argument("Box blur radius must be nonnegative.");
+            }
+        }
+
+        int BoxBlur::getRadiusX() const {
+            return radiusX;
+        }
+
+        int BoxBlur::getRadiusY() const {
+            return radiusY;
+        }
+
+        template<typename T>
+        void BoxBlur::blur(Pixmap<T> &map) const {
+            if (map.getArea() == 0 || (radiusX == 0 && radiusY == 0)) return;
+
+            map = IntegralImage<T>(map, false).boxBlur(radiusX, radiusY);
+        }
+
+        void BoxBlur::applyTo(Bitmap &map) {
+            blur(map);
+        }
+
+        void BoxBlur::applyTo(Graymap &map) {
+            blur(map);
+        }
+
+        void BoxBlur::applyTo(RGBMap &map) {
+            blur(map);
+        }
+
+        void BoxBlur::applyTo(RGBAMap &map) {
+            blur(map);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef BOX_BLUR_DEFINED_
+#define BOX_BLUR_DEFINED_
+
+#include "filter.h"
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * Box blur over a window of (2 * radiusX + 1) x (2 * radiusY + 1) pixels, clipped to the image, computed from
+         * an IntegralImage in constant time per pixel.
+         */
+        class BoxBlur : public Filter {
+        private:
+            int radiusX;
+            int radiusY;
+
+            template<typename T>
+            void blur(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Constructor.
+             * @param radiusX Horizontal radius.
+             * @param radiusY Vertical radius.
+             */
+            BoxBlur(int radiusX, int radiusY);
+
+            /**
+             * Getter for horizontal radius.
+             * @return Horizontal radius.
+             */
+            int getRadiusX() const;
+
+            /**
+             * Getter for vertical radius.
+             * @return Vertical radius.
+             */
+            int getRadiusY() const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef CHANNELS_DEFINED_
+#define CHANNELS_DEFINED_
+
+#include "../pixmap.h"
+#include "../parallel.h"
+#include <vector>
+#include <algorithm>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * Conversion between a pixel type and the interleaved channels filters compute in, on a 0 - 255 scale. Channels
+         * are floats, or bytes for fixed-point filters.
+         * @tparam T Pixel type.
+         */
+        template<typename T>
+        struct ChannelTraits;
+
+        /**
+         * Rounds and clamps a channel value to a byte.
+         * @param v Channel value.
+         * @return Byte value.
+         */
+        inline uint8_t toByte(float v) {
+            return static_cast<uint8_t>(std::min(std::max(v + 0.5f, 0.0f), 255.0f));
+        }
+
+        inline uint8_t toByte(uint8_t v) {
+            return v;
+        }
+
+        template<>
+        struct ChannelTraits<bool> {
+            static constexpr int count = 1;
+
+            template<typename S>
+            static void load(bool p, S *c) {
+                c[0] = p ? 255 : 0;
+            }
+
+            template<typename S>
+            static bool store(const S *c) {
+                return c[0] >= 127.5f;
+            }
+        };
+
+        template<>
+        struct ChannelTraits<uint8_t> {
+            static constexpr int count = 1;
+
+            template<typename S>
+            static void load(uint8_t p, S *c) {
+                c[0] = p;
+            }
+
+            template<typename S>
+            static uint8_t store(const S *c) {
+                return toByte(c[0]);
+            }
+        };
+
+        template<>
+        struct ChannelTraits<RGB> {
+            static constexpr int count = 3;
+
+            template<typename S>
+            static void load(const RGB &p, S *c) {
+                c[0] = p.r;
+                c[1] = p.g;
+                c[2] = p.b;
+            }
+
+            template<typename S>
+            static RGB store(const S *c) {
+                return RGB(toByte(c[0]), toByte(c[1]), toByte(c[2]));
+            }
+        };
+
+        template<>
+        struct ChannelTraits<RGBA> {
+            static constexpr int count = 4;
+
+            template<typename S>
+            static void load(const RGBA &p, S *c) {
+                c[0] = p.r;
+                c[1] = p.g;
+                c[2] = p.b;
+                c[3] = p.a;
+            }
+
+            template<typename S>
+            static RGBA store(const S *c) {
+                return RGBA(toByte(c[0]), toByte(c[1]), toByte(c[2]), toByte(c[3]));
+            }
+        };
+
+        /**
+         * Unpacks a Pixmap into interleaved channels, row by row.
+         * @tparam S Channel type, float or uint8_t.
+         * @tparam T Pixel type.
+         * @param map Pixmap to read.
+         * @return width * height * ChannelTraits<T>::count channels.
+         */
+        template<typename S = float, typename T>
+        std::vector<S> loadChannels(const Pixmap<T> &map) {
+            constexpr int C = ChannelTraits<T>::count;
+            std::vector<S> data(static_cast<size_t>(map.getArea()) * C);
+
+            const T *pixels = map.getPixels();
+
+            Parallel::parallelBands(0, map.getArea(), [&](int i1, int i2) {
+                for (int i = i1; i < i2; i++) {
+                    ChannelTraits<T>::load(pixels[i], &data[static_cast<size_t>(i) * C]);
+                }
+            });
+
+            return data;
+        }
+
+        /**
+         * Packs interleaved channels back into a Pixmap.
+         * @tparam S Channel type, float or uint8_t.
+         * @tparam T Pixel type.
+         * @param map Pixmap to write.
+         * @param data Channels as returned by loadChannels.
+         */
+        template<typename S, typename T>
+        void storeChannels(Pixmap<T> &map, const std::vector<S> &data) {
+            constexpr int C = ChannelTraits<T>::count;
+            T *pixels = map.getPixels();
+
+            Parallel::parallelBands(0, map.getArea(), [&](int i1, int i2) {
+                for (int i = i1; i < i2; i++) {
+                    pixels[i] = ChannelTraits<T>::store(&data[static_cast<size_t>(i) * C]);
+                }
+            });
+        }
+    }
+}
+
+#endif
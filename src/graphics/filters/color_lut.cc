@@ -0,0 +1,304 @@
+#include "color_lut.h"
+#include "channels.h"
+#include "../parallel.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            /**
+             * Finds the cell holding an 8-bit level along one axis, and the weight of its upper sample.
+             */
+            inline void locate(int v, int size, float min, float max, int &cell, float &weight) {
+                float position = (v / 255.0f - min) / (max - min) * (size - 1);
+                position = std::min(std::max(position, 0.0f), static_cast<float>(size - 1));
+
+                // The last cell is closed, so the top sample is reached with a weight of 1
+                cell = std::min(static_cast<int>(position), size - 2);
+                weight = position - cell;
+            }
+
+            /**
+             * Cell offset into the table and weight of the upper sample, for every 8-bit level along one axis.
+             */
+            struct AxisTable {
+                std::array<int, 256> offset;
+                std::array<float, 256> weight;
+
+                AxisTable(int size, int stride, float min, float max) {
+                    for (int v = 0; v < 256; v++) {
+                        locate(v, size, min, max, offset[v], weight[v]);
+                        offset[v] *= stride;
+                    }
+                }
+            };
+
+            /**
+             * Interpolates the cell whose lowest corner is at p.
+             * @param sr Stride between samples along red.
+             * @param sg Stride between samples along green.
+             * @param sb Stride between samples along blue.
+             */
+            inline void interpolate(const float *p, int sr, int sg, int sb, float fr, float fg, float fb,
+                                    ColorLUT::Interpolation interpolation, float *out) {
+                if (interpolation == ColorLUT::Interpolation::TRILINEAR) {
+                    for (int c = 0; c < 3; c++) {
+                        float c00 = p[c] + fr * (p[sr + c] - p[c]);
+                        float c10 = p[sg + c] + fr * (p[sg + sr + c] - p[sg + c]);
+                        float c01 = p[sb + c] + fr * (p[sb + sr + c] - p[sb + c]);
+                        float c11 = p[sb + sg + c] + fr * (p[sb + sg + sr + c] - p[sb + sg + c]);
+
+                        float c0 = c00 + fg * (c10 - c00);
+                        float c1 = c01 + fg * (c11 - c01);
+
+                        out[c] = c0 + fb * (c1 - c0);
+                    }
+
+                    return;
+                }
+
+                // Walk from the black corner to the white corner of the cell along the axes in decreasing order of
+                // their weights; the three steps span the tetrahedron holding the color
+                int s1, s2, s3;
+                float w1, w2, w3;
+
+                if (fr >= fg) {
+                    if (fg >= fb) {
+                        s1 = sr, s2 = sg, s3 = sb, w1 = fr, w2 = fg, w3 = fb;
+                    } else if (fr >= fb) {
+                        s1 = sr, s2 = sb, s3 = sg, w1 = fr, w2 = fb, w3 = fg;
+                    } else {
+                        s1 = sb, s2 = sr, s3 = sg, w1 = fb, w2 = fr, w3 = fg;
+                    }
+                } else {
+                    if (fr >= fb) {
+                        s1 = sg, s2 = sr, s3 = sb, w1 = fg, w2 = fr, w3 = fb;
+                    } else if (fg >= fb) {
+                        s1 = sg, s2 = sb, s3 = sr, w1 = fg, w2 = fb, w3 = fr;
+                    } else {
+                        s1 = sb, s2 = sg, s3 = sr, w1 = fb, w2 = fg, w3 = fr;
+                    }
+                }
+
+                const float *p1 = p + s1, *p2 = p1 + s2, *p3 = p2 + s3;
+
+                for (int c = 0; c < 3; c++) {
+                    out[c] = (1 - w1) * p[c] + (w1 - w2) * p1[c] + (w2 - w3) * p2[c] + w3 * p3[c];
+                }
+            }
+        }
+
+        ColorLUT::ColorLUT(int _size, const std::vector<float> &samples, Interpolation _interpolation)
+                : size(_size), domainMin{0, 0, 0}, domainMax{1, 1, 1}, interpolation(_interpolation) {
+            if (size < 2 || size > 256) {
+                throw std::invalid_argument("Color lookup table size must be from 2 to 256.");
+            }
+
+            if (samples.size() != static_cast<size_t>(size) * size * size * 3) {
+                throw std::invalid_argument("Color lookup table needs size^3 RGB samples.");
+            }
+
+            table.resize(samples.size());
+
+            for (size_t i = 0; i < samples.size(); i++) {
+                table[i] = samples[i] * 255;
+            }
+        }
+
+        ColorLUT ColorLUT::identity(int size) {
+            return fromFunction([](const RGB &c) { return c; }, size);
+        }
+
+        ColorLUT ColorLUT::fromFunction(const std::function<RGB(const RGB &)> &transform, int size) {
+            if (size < 2 || size > 256) {
+                throw std::invalid_argument("Color lookup table size must be from 2 to 256.");
+            }
+
+            std::vector<float> samples(static_cast<size_t>(size) * size * size * 3);
+
+            auto level = [&](int i) {
+                return static_cast<color_base>(std::lround(i * 255.0 / (size - 1)));
+            };
+
+            Parallel::parallelFor(0, size * size, [&](int gb) {
+                int g = gb % size, b = gb / size;
+
+                for (int r = 0; r < size; r++) {
+                    RGB out = transform(RGB(level(r), level(g), level(b)));
+                    float *sample = &samples[(static_cast<size_t>(gb) * size + r) * 3];
+
+                    sample[0] = out.r / 255.0f;
+                    sample[1] = out.g / 255.0f;
+                    sample[2] = out.b / 255.0f;
+                }
+            });
+
+            return ColorLUT(size, samples);
+        }
+
+        ColorLUT ColorLUT::fromCube(const std::string &path) {
+            std::ifstream in(path);
+
+            if (!in) {
+                throw std::runtime_error("Color lookup table file does not exist or is inaccessible.");
+            }
+
+            return fromCube(in);
+        }
+
+        ColorLUT ColorLUT::fromCube(std::istream &in) {
+            int size = 0;
+            std::array<float, 3> min = {0, 0, 0}, max = {1, 1, 1};
+            std::vector<float> samples;
+            std::string line;
+
+            while (std::getline(in, line)) {
+                std::istringstream tokens(line);
+                std::string keyword;
+
+                if (!(tokens >> keyword) || keyword[0] == '#' || keyword == "TITLE") continue;
+
+                if (keyword == "LUT_3D_SIZE") {
+                    if (!(tokens >> size) || size < 2 || size > 256) {
+                        throw std::runtime_error("Invalid LUT_3D_SIZE in color lookup table.");
+                    }
+
+                    samples.reserve(static_cast<size_t>(size) * size * size * 3);
+                } else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX") {
+                    std::array<float, 3> &domain = keyword == "DOMAIN_MIN" ? min : max;
+
+                    if (!(tokens >> domain[0] >> domain[1] >> domain[2])) {
+                        throw std::runtime_error("Invalid " + keyword + " in color lookup table.");
+                    }
+                } else if (keyword == "LUT_1D_SIZE" || keyword == "LUT_1D_INPUT_RANGE") {
+                    throw std::runtime_error("1-D color lookup tables are not supported.");
+                } else if (keyword == "LUT_3D_INPUT_RANGE") {
+                    if (!(tokens >> min[0] >> max[0])) {
+                        throw std::runtime_error("Invalid LUT_3D_INPUT_RANGE in color lookup table.");
+                    }
+
+                    min[1] = min[2] = min[0];
+                    max[1] = max[2] = max[0];
+                } else {
+                    // Anything else is a sample, or a keyword this reader does not know
+                    float r, g, b;
+                    std::istringstream sample(line);
+
+                    if (!(sample >> r >> g >> b)) {
+                        if (std::isalpha(static_cast<unsigned char>(keyword[0]))) continue;
+
+                        throw std::runtime_error("Invalid sample in color lookup table.");
+                    }
+
+                    samples.push_back(r);
+                    samples.push_back(g);
+                    samples.push_back(b);
+                }
+            }
+
+            if (size == 0) {
+                throw std::runtime_error("Color lookup table has no LUT_3D_SIZE.");
+            }
+
+            if (samples.size() != static_cast<size_t>(size) * size * size * 3) {
+                throw std::runtime_error("Color lookup table has the wrong number of samples.");
+            }
+
+            for (int c = 0; c < 3; c++) {
+                if (!(max[c] > min[c])) {
+                    throw std::runtime_error("Color lookup table domain is empty.");
+                }
+            }
+
+            ColorLUT ret(size, samples);
+            ret.domainMin = min;
+            ret.domainMax = max;
+
+            return ret;
+        }
+
+        int ColorLUT::getSize() const {
+            return size;
+        }
+
+        ColorLUT::Interpolation ColorLUT::getInterpolation() const {
+            return interpolation;
+        }
+
+        void ColorLUT::setInterpolation(Interpolation _interpolation) {
+            interpolation = _interpolation;
+        }
+
+        RGB ColorLUT::lookup(const RGB &color) const {
+            int sr = 3, sg = 3 * size, sb = 3 * size * size;
+            int r, g, b;
+            float fr, fg, fb, out[3];
+
+            locate(color.r, size, domainMin[0], domainMax[0], r, fr);
+            locate(color.g, size, domainMin[1], domainMax[1], g, fg);
+            locate(color.b, size, domainMin[2], domainMax[2], b, fb);
+
+            interpolate(&table[r * sr + g * sg + b * sb], sr, sg, sb, fr, fg, fb, interpolation, out);
+
+            return RGB(toByte(out[0]), toByte(out[1]), toByte(out[2]));
+        }
+
+        template<typename T>
+        void ColorLUT::filter(Pixmap<T> &map) const {
+            constexpr int C = ChannelTraits<T>::count;
+
+            int sr = 3, sg = 3 * size, sb = 3 * size * size;
+
+            AxisTable red(size, sr, domainMin[0], domainMax[0]);
+            AxisTable green(size, sg, domainMin[1], domainMax[1]);
+            AxisTable blue(size, sb, domainMin[2], domainMax[2]);
+
+            T *pixels = map.getPixels();
+
+            // Stays scalar, unlike the Simd::PixelKernels users: each pixel reads four or eight table corners at
+            // offsets given by its own color, and the tetrahedral path branches on the order of its weights, so
+            // neighbouring pixels share neither addresses nor control flow. The cost is those scattered table reads
+            // (a 33-point table is 431 KB of floats) rather than the few multiplies around them.
+            Parallel::parallelBands(0, map.getArea(), [&](int i1, int i2) {
+                uint8_t c[C];
+                float out[3];
+
+                for (int i = i1; i < i2; i++) {
+                    ChannelTraits<T>::load(pixels[i], c);
+
+                    // Graymaps are grays
+                    uint8_t r = c[0], g = c[C >= 3 ? 1 : 0], b = c[C >= 3 ? 2 : 0];
+
+                    interpolate(&table[red.offset[r] + green.offset[g] + blue.offset[b]], sr, sg, sb,
+                                red.weight[r], green.weight[g], blue.weight[b], interpolation, out);
+
+                    if (C >= 3) {
+                        for (int k = 0; k < 3; k++) c[k] = toByte(out[k]);
+                    } else {
+                        c[0] = toByte(0.299f * out[0] + 0.587f * out[1] + 0.114f * out[2]);
+                    }
+
+                    pixels[i] = ChannelTraits<T>::store(c);
+                }
+            });
+        }
+
+        void ColorLUT::applyTo(Bitmap &) {
+        }
+
+        void ColorLUT::applyTo(Graymap &map) {
+            filter(map);
+        }
+
+        void ColorLUT::applyTo(RGBMap &map) {
+            filter(map);
+        }
+
+        void ColorLUT::applyTo(RGBAMap &map) {
+            filter(map);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef COLOR_LUT_DEFINED_
+#define COLOR_LUT_DEFINED_
+
+#include "filter.h"
+#include <array>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * Color transform baked into a 3-D lookup table over the RGB cube.
+         *
+         * Any chain of per-pixel color operations, however expensive, costs one table lookup per pixel once sampled.
+         * Colors between the samples are interpolated, tetrahedrally by default: the cell around the color is split
+         * into six tetrahedra along its gray diagonal, and the color is blended from the four corners of its
+         * tetrahedron, which is cheaper than the eight corners of trilinear interpolation and keeps grays neutral.
+         * The cell and weights of every 8-bit level are computed once per application, and pixels are processed in
+         * parallel bands. Alpha is left unchanged; Graymaps are transformed as grays and reduced to their luma, and
+         * Bitmaps are left unchanged.
+         */
+        class ColorLUT : public Filter {
+        public:
+            /**
+             * How colors between samples are computed.
+             */
+            enum class Interpolation {
+                TRILINEAR,
+                TETRAHEDRAL
+            };
+
+        private:
+            int size;
+            std::vector<float> table; ///< Red fastest, then green, then blue; channels on the 0 - 255 scale
+            std::array<float, 3> domainMin;
+            std::array<float, 3> domainMax;
+            Interpolation interpolation;
+
+            template<typename T>
+            void filter(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Constructor from samples.
+             * @param size Number of samples along each axis, from 2 to 256.
+             * @param samples size^3 RGB triplets from 0 to 1, red varying fastest, then green, then blue.
+             * @param interpolation Interpolation.
+             */
+            ColorLUT(int size, const std::vector<float> &samples,
+                     Interpolation interpolation = Interpolation::TETRAHEDRAL);
+
+            /**
+             * Table which leaves every color unchanged.
+             * @param size Number of samples along each axis.
+             * @return Table.
+             */
+            static ColorLUT identity(int size = 33);
+
+            /**
+             * Samples a color transform into a table; common sizes are 17, 33 and 65.
+             * @param transform Transform, called once per sample, in parallel.
+             * @param size Number of samples along each axis.
+             * @return Table.
+             */
+            static ColorLUT fromFunction(const std::function<RGB(const RGB &)> &transform, int size = 33);
+
+            /**
+             * Loads a table in the Adobe / Resolve .cube format.
+             * @param path Path of the file.
+             * @return Table.
+             */
+            static ColorLUT fromCube(const std::string &path);
+
+            /**
+             * Reads a table in the Adobe / Resolve .cube format.
+             * @param in Stream to read.
+             * @return Table.
+             */
+            static ColorLUT fromCube(std::istream &in);
+
+            /**
+             * Getter for size.
+             * @return Number of samples along each axis.
+             */
+            int getSize() const;
+
+            /**
+             * Getter for interpolation.
+             * @return Interpolation.
+             */
+            Interpolation getInterpolation() const;
+
+            /**
+             * Setter for interpolation.
+             * @param interpolation Interpolation.
+             */
+            void setInterpolation(Interpolation interpolation);
+
+            /**
+             * Transforms a single color.
+             * @param color Color.
+             * @return Transformed color.
+             */
+            RGB lookup(const RGB &color) const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,341 @@
+#include "convolution.h"
+#include "channels.h"
+#include "../simd/kernels.h"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            /*
+             * Fixed point weights are scaled by at most 2 ^ FIXED_SHIFT.
+             */
+            const int FIXED_SHIFT = 14;
+
+            /*
+             * Fractional bits kept at most in the 16-bit intermediates between the fixed point passes.
+             */
+            const int INTERMEDIATE_SHIFT = 7;
+
+            /*
+             * Number of channel values per column block of the vertical pass.
+             */
+            const int COLUMN_BLOCK = 512;
+
+            inline void accumulate(const Simd::PixelKernels &kernels, float *sum, const float *in, float weight,
+                                   size_t n) {
+                kernels.accumulate(sum, in, weight, n);
+            }
+
+            inline void accumulate(const Simd::PixelKernels &kernels, int32_t *sum, const uint8_t *in, int32_t weight,
+                                   size_t n) {
+                kernels.accumulateFixed(sum, in, weight, n);
+            }
+
+            inline void accumulate(const Simd::PixelKernels &kernels, int32_t *sum, const int16_t *in, int32_t weight,
+                                   size_t n) {
+                kernels.accumulateFixed16(sum, in, weight, n);
+            }
+
+            /**
+             * Rounds a fixed point sum, dropping shift fractional bits, and clamps it to [min, max].
+             */
+            inline int32_t roundFixed(int32_t sum, int shift, int32_t min, int32_t max) {
+                if (shift > 0) sum = (sum + (1 << (shift - 1))) >> shift;
+
+                return std::min(std::max(sum, min), max);
+            }
+
+            /**
+             * Convolves every row of interleaved channels with a kernel. source and dest may be the same vector.
+             * @tparam S Source channel type.
+             * @tparam D Destination channel type.
+             * @tparam W Weight and accumulator type.
+             * @tparam Finish Type of functor converting a sum to D.
+             */
+            template<typename S, typename D, typename W, typename Finish>
+            void convolveRows(const std::vector<S> &source, std::vector<D> &dest, int width, int height, int channels,
+                              const std::vector<W> &kernel, EdgeMode edge, Finish finish) {
+                int radius = kernel.size() / 2;
+                size_t stride = static_cast<size_t>(width) * channels;
+                const Simd::PixelKernels &kernels = Simd::pixelKernels();
+
+                Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                    std::vector<S> padded((width + 2 * radius) * channels);
+                    std::vector<W> sum(stride);
+
+                    for (int y = y1; y < y2; y++) {
+                        const S *row = &source[y * stride];
+
+                        // Pad the row once so the inner loop needs no edge checks
+                        for (int x = -radius; x < width + radius; x++) {
+                            std::copy_n(row + edgeIndex(x, width, edge) * channels, channels,
+                                        &padded[(x + radius) * channels]);
+                        }
+
+                        std::fill(sum.begin(), sum.end(), 0);
+
+                        for (size_t k = 0; k < kernel.size(); k++) {
+                            accumulate(kernels, sum.data(), &padded[k * channels], kernel[k], stride);
+                        }
+
+                        D *out = &dest[y * stride];
+
+                        for (size_t i = 0; i < stride; i++) {
+                            out[i] = finish(sum[i]);
+                        }
+                    }
+                });
+            }
+
+            /**
+             * Convolves every column of interleaved channels with a kernel. source and dest must not overlap.
+             * @tparam S Source channel type.
+             * @tparam D Destination channel type.
+             * @tparam W Weight and accumulator type.
+             * @tparam Finish Type of functor converting a sum to D.
+             */
+            template<typename S, typename D, typename W, typename Finish>
+            void convolveColumns(const std::vector<S> &source, std::vector<D> &dest, int width, int height,
+                                 int channels, const std::vector<W> &kernel, EdgeMode edge, Finish finish) {
+                int radius = kernel.size() / 2;
+                int stride = width * channels;
+                int blocks = (stride + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+                const Simd::PixelKernels &kernels = Simd::pixelKernels();
+
+                Parallel::parallelFor(0, blocks, [&](int block) {
+                    int i1 = block * COLUMN_BLOCK;
+                    int n = std::min(COLUMN_BLOCK, stride - i1);
+
+                    W sum[COLUMN_BLOCK];
+
+                    for (int y = 0; y < height; y++) {
+                        std::fill(sum, sum + n, 0);
+
+                        for (size_t k = 0; k < kernel.size(); k++) {
+                            const S *in = &source[static_cast<size_t>(edgeIndex(y + k - radius, height, edge)) * stride
+                                                  + i1];
+
+                            accumulate(kernels, sum, in, kernel[k], n);
+                        }
+
+                        D *out = &dest[static_cast<size_t>(y) * stride + i1];
+
+                        for (int i = 0; i < n; i++) {
+                            out[i] = finish(sum[i]);
+                        }
+                    }
+                });
+            }
+
+            /**
+             * Rounds a kernel to fixed point, keeping its sum exact by correcting the center tap.
+             * @param kernel Kernel.
+             * @param shift Fractional bits of the weights.
+             */
+            std::vector<int32_t> toFixed(const std::vector<float> &kernel, int shift) {
+                std::vector<int32_t> ret(kernel.size());
+                double total = 0;
+                int32_t fixedTotal = 0;
+
+                for (size_t i = 0; i < kernel.size(); i++) {
+                    ret[i] = std::lround(kernel[i] * (1 << shift));
+                    total += kernel[i];
+                    fixedTotal += ret[i];
+                }
+
+                ret[kernel.size() / 2] += std::lround(total * (1 << shift)) - fixedTotal;
+
+                return ret;
+            }
+
+            /**
+             * Sum of the absolute values of a kernel's taps, which bounds how far it can scale a channel.
+             */
+            double gain(const std::vector<float> &kernel) {
+                double ret = 0;
+
+                for (float k : kernel) {
+                    ret += std::abs(k);
+                }
+
+                return std::max(ret, 1.0);
+            }
+
+            void checkKernel(const std::vector<float> &kernel) {
+                if (kernel.size() % 2 == 0) {
+                    throw std::invalid_argument("Convolution kernels must have odd length.");
+                }
+            }
+        }
+
+        void convolveSeparable(std::vector<float> &data, int width, int height, int channels,
+                               const std::vector<float> &horizontal, const std::vector<float> &vertical,
+                               EdgeMode edge) {
+            checkKernel(horizontal);
+            checkKernel(vertical);
+
+            auto identity = [](const std::vector<float> &kernel) {
+                return kernel.size() == 1 && kernel[0] == 1;
+            };
+
+            auto same = [](float sum) {
+                return sum;
+            };
+
+            if (!identity(horizontal)) convolveRows(data, data, width, height, channels, horizontal, edge, same);
+
+            if (!identity(vertical)) {
+                std::vector<float> source = data;
+                convolveColumns(source, data, width, height, channels, vertical, edge, same);
+            }
+        }
+
+        void convolveSeparableRows(const std::function<const float *(int)> &input, int y1, int y2, int width,
+                                   int height, int channels, const std::vector<float> &horizontal,
+                                   const std::vector<float> &vertical, EdgeMode edge, float *out) {
+            checkKernel(horizontal);
+            checkKernel(vertical);
+
+            int vRadius = vertical.size() / 2;
+            int hRadius = horizontal.size() / 2;
+            size_t stride = static_cast<size_t>(width) * channels;
+            const Simd::PixelKernels &kernels = Simd::pixelKernels();
+
+            std::vector<float> padded((width + 2 * hRadius) * channels);
+            float *row = &padded[hRadius * channels];
+
+            for (int y = y1; y < y2; y++) {
+                std::fill(row, row + stride, 0.0f);
+
+                for (size_t k = 0; k < vertical.size(); k++) {
+                    accumulate(kernels, row, input(edgeIndex(y + static_cast<int>(k) - vRadius, height, edge)),
+                               vertical[k], stride);
+                }
+
+                // Pad the vertically convolved row so the horizontal pass needs no edge checks
+                for (int x = -hRadius; x < 0; x++) {
+                    std::copy_n(row + edgeIndex(x, width, edge) * channels, channels, row + x * channels);
+                }
+
+                for (int x = width; x < width + hRadius; x++) {
+                    std::copy_n(row + edgeIndex(x, width, edge) * channels, channels, row + x * channels);
+                }
+
+                float *dest = out + (y - y1) * stride;
+                std::fill(dest, dest + stride, 0.0f);
+
+                for (size_t k = 0; k < horizontal.size(); k++) {
+                    accumulate(kernels, dest, &padded[k * channels], horizontal[k], stride);
+                }
+            }
+        }
+
+        int edgeIndex(int i, int n, EdgeMode edge) {
+            if (i >= 0 && i < n) return i;
+
+            switch (edge) {
+                case EdgeMode::CLAMP:
+                    return std::min(std::max(i, 0), n - 1);
+                case EdgeMode::MIRROR: {
+                    if (n == 1) return 0;
+
+                    int period = 2 * n - 2;
+                    i = ((i % period) + period) % period;
+
+                    return i < n ? i : period - i;
+                }
+                case EdgeMode::WRAP:
+                    return ((i % n) + n) % n;
+            }
+
+            return 0;
+        }
+
+        SeparableConvolution::SeparableConvolution(std::vector<float> kernel, EdgeMode _edge, Precision _precision)
+                : SeparableConvolution(kernel, kernel, _edge, _precision) {
+        }
+
+        SeparableConvolution::SeparableConvolution(std::vector<float> _horizontal, std::vector<float> _vertical,
+                                                   EdgeMode _edge, Precision _precision)
+                : horizontal(std::move(_horizontal)), vertical(std::move(_vertical)), edge(_edge),
+                  precision(_precision) {
+            checkKernel(horizontal);
+            checkKernel(vertical);
+        }
+
+        const std::vector<float> &SeparableConvolution::getHorizontalKernel() const {
+            return horizontal;
+        }
+
+        const std::vector<float> &SeparableConvolution::getVerticalKernel() const {
+            return vertical;
+        }
+
+        EdgeMode SeparableConvolution::getEdgeMode() const {
+            return edge;
+        }
+
+        SeparableConvolution::Precision SeparableConvolution::getPrecision() const {
+            return precision;
+        }
+
+        template<typename T>
+        void SeparableConvolution::convolve(Pixmap<T> &map) const {
+            constexpr int C = ChannelTraits<T>::count;
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+
+            if (map.getArea() == 0) return;
+
+            if (precision == Precision::FIXED) {
+                // The horizontal pass keeps signed 16-bit intermediates, so negative taps are not clipped before the
+                // vertical pass. Their fractional bits, and those of the vertical weights, shrink as the kernels'
+                // gains grow, so the intermediates fit 16 bits and the vertical sums 32.
+                int intermediateShift = std::max(std::min(INTERMEDIATE_SHIFT, static_cast<int>(
+                        std::floor(std::log2(INT16_MAX / (255 * gain(horizontal)))))), 0);
+                int verticalShift = std::max(std::min(FIXED_SHIFT, static_cast<int>(
+                        std::floor(std::log2(INT32_MAX / (INT16_MAX * gain(vertical))))) - 1), 0);
+                int finalShift = verticalShift + intermediateShift;
+
+                std::vector<uint8_t> data = loadChannels<uint8_t>(map);
+                std::vector<int16_t> intermediate(data.size());
+
+                convolveRows(data, intermediate, width, height, C, toFixed(horizontal, FIXED_SHIFT), edge,
+                             [&](int32_t sum) -> int16_t {
+                                 return roundFixed(sum, FIXED_SHIFT - intermediateShift, INT16_MIN, INT16_MAX);
+                             });
+                convolveColumns(intermediate, data, width, height, C, toFixed(vertical, verticalShift), edge,
+                                [&](int32_t sum) -> uint8_t {
+                                    return roundFixed(sum, finalShift, 0, 255);
+                                });
+
+                storeChannels(map, data);
+            } else {
+                std::vector<float> data = loadChannels<float>(map);
+
+                convolveSeparable(data, width, height, C, horizontal, vertical, edge);
+
+                storeChannels(map, data);
+            }
+        }
+
+        void SeparableConvolution::applyTo(Bitmap &map) {
+            convolve(map);
+        }
+
+        void SeparableConvolution::applyTo(Graymap &map) {
+            convolve(map);
+        }
+
+        void SeparableConvolution::applyTo(RGBMap &map) {
+            convolve(map);
+        }
+
+        void SeparableConvolution::applyTo(RGBAMap &map) {
+            convolve(map);
+        }
+    }
+}
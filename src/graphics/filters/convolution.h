@@ -0,0 +1,144 @@
+#ifndef CONVOLUTION_DEFINED_
+#define CONVOLUTION_DEFINED_
+
+#include "filter.h"
+#include <functional>
+#include <vector>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * How filters read pixels beyond the border of an image.
+         */
+        enum class EdgeMode {
+            CLAMP, ///< Repeat the border pixel
+            MIRROR, ///< Reflect about the border pixel, i.e. -1 reads 1
+            WRAP ///< Tile the image
+        };
+
+        /**
+         * Convolution with a separable kernel: a horizontal 1-D kernel followed by a vertical one.
+         *
+         * The horizontal pass splits rows across threads; the vertical pass processes blocks of columns, so the rows
+         * under the kernel stay in cache, and splits the blocks across threads. Both inner loops run along contiguous
+         * channel data through the Simd accumulate kernels. FIXED precision reads and writes bytes with integer
+         * weights and keeps signed 16-bit intermediates between the passes, so kernels with negative taps are not
+         * clipped halfway; FLOAT computes on float channels.
+         */
+        class SeparableConvolution : public Filter {
+        public:
+            /**
+             * Arithmetic used for the passes.
+             */
+            enum class Precision {
+                FLOAT,
+                FIXED
+            };
+
+        private:
+            std::vector<float> horizontal;
+            std::vector<float> vertical;
+            EdgeMode edge;
+            Precision precision;
+
+            template<typename T>
+            void convolve(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Constructor using the same kernel in both directions.
+             * @param kernel Kernel of odd length, centered on the middle tap.
+             * @param edge Edge mode.
+             * @param precision Arithmetic to use.
+             */
+            explicit SeparableConvolution(std::vector<float> kernel, EdgeMode edge = EdgeMode::CLAMP,
+                                          Precision precision = Precision::FLOAT);
+
+            /**
+             * Constructor.
+             * @param horizontal Horizontal kernel of odd length, centered on the middle tap.
+             * @param vertical Vertical kernel of odd length, centered on the middle tap.
+             * @param edge Edge mode.
+             * @param precision Arithmetic to use.
+             */
+            SeparableConvolution(std::vector<float> horizontal, std::vector<float> vertical,
+                                 EdgeMode edge = EdgeMode::CLAMP, Precision precision = Precision::FLOAT);
+
+            /**
+             * Getter for horizontal kernel.
+             * @return Horizontal kernel.
+             */
+            const std::vector<float> &getHorizontalKernel() const;
+
+            /**
+             * Getter for vertical kernel.
+             * @return Vertical kernel.
+             */
+            const std::vector<float> &getVerticalKernel() const;
+
+            /**
+             * Getter for edge mode.
+             * @return Edge mode.
+             */
+            EdgeMode getEdgeMode() const;
+
+            /**
+             * Getter for precision.
+             * @return Precision.
+             */
+            Precision getPrecision() const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+
+        /**
+         * Convolves interleaved float channels with a horizontal, then a vertical kernel, as SeparableConvolution
+         * does in FLOAT precision. Kernels consisting of a single 1 are skipped.
+         * @param data width * height * channels values, convolved in place.
+         * @param width Width in pixels.
+         * @param height Height in pixels.
+         * @param channels Channels per pixel.
+         * @param horizontal Horizontal kernel of odd length.
+         * @param vertical Vertical kernel of odd length.
+         * @param edge Edge mode.
+         */
+        void convolveSeparable(std::vector<float> &data, int width, int height, int channels,
+                               const std::vector<float> &horizontal, const std::vector<float> &vertical,
+                               EdgeMode edge = EdgeMode::CLAMP);
+
+        /**
+         * Computes rows [y1, y2) of an image convolved with a vertical, then a horizontal kernel, reading the input
+         * rows through a functor, so a strip can be convolved without the whole image in memory.
+         * @param input Returns a pointer to input row y, for every y the vertical kernel reaches from [y1, y2).
+         * @param y1 First output row.
+         * @param y2 One past the last output row.
+         * @param width Width in pixels.
+         * @param height Height in pixels.
+         * @param channels Channels per pixel.
+         * @param horizontal Horizontal kernel of odd length.
+         * @param vertical Vertical kernel of odd length.
+         * @param edge Edge mode.
+         * @param out Output rows, (y2 - y1) * width * channels floats.
+         */
+        void convolveSeparableRows(const std::function<const float *(int)> &input, int y1, int y2, int width,
+                                   int height, int channels, const std::vector<float> &horizontal,
+                                   const std::vector<float> &vertical, EdgeMode edge, float *out);
+
+        /**
+         * Maps an index outside [0, n) into it according to an edge mode.
+         * @param i Index.
+         * @param n Length of the row or column.
+         * @param edge Edge mode.
+         * @return Index in [0, n).
+         */
+        int edgeIndex(int i, int n, EdgeMode edge);
+    }
+}
+
+#endif
@@ -0,0 +1,249 @@
+#include "fast_gaussian_blur.h"
+#include "channels.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            /**
+             * Box blurs every row of interleaved channels with a running sum.
+             * @tparam C Channel count.
+             * @param data Channels, blurred in place.
+             * @param width Image width.
+             * @param height Image height.
+             * @param r Box radius.
+             */
+            template<int C>
+            void boxBlurRows(std::vector<float> &data, int width, int height, int r) {
+                float inv = 1.0f / (2 * r + 1);
+
+                Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                    std::vector<float> row(static_cast<size_t>(width) * C);
+
+                    for (int y = y1; y < y2; y++) {
+                        float *out = &data[static_cast<size_t>(y) * width * C];
+                        std::copy(out, out + row.size(), row.begin());
+
+                        for (int c = 0; c < C; c++) {
+                            float sum = (r + 1) * row[c];
+
+                            for (int i = 1; i <= r; i++) {
+                                sum += row[std::min(i, width - 1) * C + c];
+                            }
+
+                            for (int x = 0; x < width; x++) {
+                                out[x * C + c] = sum * inv;
+                                sum += row[std::min(x + r + 1, width - 1) * C + c] - row[std::max(x - r, 0) * C + c];
+                            }
+                        }
+                    }
+                });
+            }
+
+            /**
+             * Box blurs every column of interleaved channels. Whole rows are accumulated at once so the inner loops
+             * run along contiguous memory; threads take bands of columns.
+             */
+            template<int C>
+            void boxBlurColumns(std::vector<float> &data, int width, int height, int r) {
+                float inv = 1.0f / (2 * r + 1);
+                std::vector<float> source = data;
+
+                Parallel::parallelBands(0, width * C, [&](int i1, int i2) {
+                    size_t stride = static_cast<size_t>(width) * C;
+                    std::vector<float> sum(i2 - i1);
+
+                    auto row = [&](int y) {
+                        return &source[std::min(std::max(y, 0), height - 1) * stride + i1];
+                    };
+
+                    for (int i = 0; i < i2 - i1; i++) {
+                        sum[i] = (r + 1) * row(0)[i];
+                    }
+
+                    for (int k = 1; k <= r; k++) {
+                        const float *in = row(k);
+
+                        for (int i = 0; i < i2 - i1; i++) {
+                            sum[i] += in[i];
+                        }
+                    }
+
+                    for (int y = 0; y < height; y++) {
+                        float *out = &data[y * stride + i1];
+                        const float *add = row(y + r + 1);
+                        const float *remove = row(y - r);
+
+                        for (int i = 0; i < i2 - i1; i++) {
+                            out[i] = sum[i] * inv;
+                            sum[i] += add[i] - remove[i];
+                        }
+                    }
+                });
+            }
+
+            /**
+             * Coefficients of the Young - van Vliet recursive Gaussian, normalized so that
+             * out[n] = b * in[n] + a1 * out[n - 1] + a2 * out[n - 2] + a3 * out[n - 3].
+             */
+            struct Recursive {
+                float b, a1, a2, a3;
+
+                explicit Recursive(float sigma) {
+                    float q = sigma >= 2.5f ? 0.98711f * sigma - 0.96330f
+                                            : 3.97156f - 4.14554f * std::sqrt(1 - 0.26891f * sigma);
+
+                    float q2 = q * q, q3 = q2 * q;
+                    float b0 = 1.57825f + 2.44413f * q + 1.4281f * q2 + 0.422205f * q3;
+
+                    a1 = (2.44413f * q + 2.85619f * q2 + 1.26661f * q3) / b0;
+                    a2 = -(1.4281f * q2 + 1.26661f * q3) / b0;
+                    a3 = 0.422205f * q3 / b0;
+                    b = 1 - (a1 + a2 + a3);
+                }
+            };
+
+            template<int C>
+            void recursiveBlurRows(std::vector<float> &data, int width, int height, const Recursive &f) {
+                Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                    for (int y = y1; y < y2; y++) {
+                        float *p = &data[static_cast<size_t>(y) * width * C];
+
+                        for (int c = 0; c < C; c++) {
+                            // The border value is the steady state of the filter, so it extends the edge
+                            float w1 = p[c], w2 = w1, w3 = w1;
+
+                            for (int x = 0; x < width; x++) {
+                                float w = f.b * p[x * C + c] + f.a1 * w1 + f.a2 * w2 + f.a3 * w3;
+                                p[x * C + c] = w;
+                                w3 = w2;
+                                w2 = w1;
+                                w1 = w;
+                            }
+
+                            w1 = w2 = w3 = p[(width - 1) * C + c];
+
+                            for (int x = width - 1; x >= 0; x--) {
+                                float w = f.b * p[x * C + c] + f.a1 * w1 + f.a2 * w2 + f.a3 * w3;
+                                p[x * C + c] = w;
+                                w3 = w2;
+                                w2 = w1;
+                                w1 = w;
+                            }
+                        }
+                    }
+                });
+            }
+
+            template<int C>
+            void recursiveBlurColumns(std::vector<float> &data, int width, int height, const Recursive &f) {
+                Parallel::parallelBands(0, width * C, [&](int i1, int i2) {
+                    size_t stride = static_cast<size_t>(width) * C;
+                    auto row = [&](int y) {
+                        return &data[std::min(std::max(y, 0), height - 1) * stride + i1];
+                    };
+
+                    // The filter maps a constant signal to itself, so the first and last rows come out unchanged and
+                    // clamping the row index extends the edges; in place, since each row is read before it is written
+                    for (int y = 1; y < height; y++) {
+                        float *p = row(y);
+                        const float *w1 = row(y - 1), *w2 = row(y - 2), *w3 = row(y - 3);
+
+                        for (int i = 0; i < i2 - i1; i++) {
+                            p[i] = f.b * p[i] + f.a1 * w1[i] + f.a2 * w2[i] + f.a3 * w3[i];
+                        }
+                    }
+
+                    for (int y = height - 2; y >= 0; y--) {
+                        float *p = row(y);
+                        const float *w1 = row(y + 1), *w2 = row(y + 2), *w3 = row(y + 3);
+
+                        for (int i = 0; i < i2 - i1; i++) {
+                            p[i] = f.b * p[i] + f.a1 * w1[i] + f.a2 * w2[i] + f.a3 * w3[i];
+                        }
+                    }
+                });
+            }
+        }
+
+        FastGaussianBlur::FastGaussianBlur(float _sigma, Method _method) : method(_method) {
+            setSigma(_sigma);
+        }
+
+        float FastGaussianBlur::getSigma() const {
+            return sigma;
+        }
+
+        void FastGaussianBlur::setSigma(float _sigma) {
+            if (!(_sigma >= 0)) {
+                throw std::invalid_argument("Blur standard deviation must be nonnegative.");
+            }
+
+            sigma = _sigma;
+        }
+
+        FastGaussianBlur::Method FastGaussianBlur::getMethod() const {
+            return method;
+        }
+
+        void FastGaussianBlur::setMethod(Method _method) {
+            method = _method;
+        }
+
+        template<typename T>
+        void FastGaussianBlur::blur(Pixmap<T> &map) const {
+            constexpr int C = ChannelTraits<T>::count;
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+
+            if (sigma < 0.5f || map.getArea() == 0) return;
+
+            std::vector<float> data = loadChannels(map);
+
+            if (method == Method::BOX_CASCADE) {
+                // Box widths whose cascade matches the variance of the Gaussian (Kovesi, "Fast almost-Gaussian
+                // filtering")
+                const int n = 3;
+                float variance = 12 * sigma * sigma;
+
+                int lower = static_cast<int>(std::sqrt(variance / n + 1));
+                if (lower % 2 == 0) lower--;
+
+                int upper = lower + 2;
+                int m = std::lround((variance - n * lower * lower - 4 * n * lower - 3 * n) / (-4.0f * lower - 4));
+
+                for (int i = 0; i < n; i++) {
+                    int r = ((i < m ? lower : upper) - 1) / 2;
+
+                    boxBlurRows<C>(data, width, height, r);
+                    boxBlurColumns<C>(data, width, height, r);
+                }
+            } else {
+                Recursive f(sigma);
+
+                recursiveBlurRows<C>(data, width, height, f);
+                recursiveBlurColumns<C>(data, width, height, f);
+            }
+
+            storeChannels(map, data);
+        }
+
+        void FastGaussianBlur::applyTo(Bitmap &map) {
+            blur(map);
+        }
+
+        void FastGaussianBlur::applyTo(Graymap &map) {
+            blur(map);
+        }
+
+        void FastGaussianBlur::applyTo(RGBMap &map) {
+            blur(map);
+        }
+
+        void FastGaussianBlur::applyTo(RGBAMap &map) {
+            blur(map);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef FAST_GAUSSIAN_BLUR_DEFINED_
+#define FAST_GAUSSIAN_BLUR_DEFINED_
+
+#include "filter.h"
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * Gaussian blur with a standard deviation chosen at runtime, costing constant time per pixel whatever the
+         * radius. Edges are extended by repeating the border pixels.
+         */
+        class FastGaussianBlur : public Filter {
+        public:
+            /**
+             * Algorithm approximating the Gaussian.
+             */
+            enum class Method {
+                BOX_CASCADE, ///< Three successive box blurs computed with running sums
+                RECURSIVE ///< Young - van Vliet third order recursive filter, run forwards and backwards
+            };
+
+        private:
+            float sigma;
+            Method method;
+
+            template<typename T>
+            void blur(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Constructor.
+             * @param sigma Standard deviation of the Gaussian in pixels; values below 0.5 leave images unchanged.
+             * @param method Algorithm to use.
+             */
+            explicit FastGaussianBlur(float sigma, Method method = Method::RECURSIVE);
+
+            /**
+             * Getter for standard deviation.
+             * @return Standard deviation in pixels.
+             */
+            float getSigma() const;
+
+            /**
+             * Setter for standard deviation.
+             * @param sigma Standard deviation in pixels.
+             */
+            void setSigma(float sigma);
+
+            /**
+             * Getter for algorithm.
+             * @return Algorithm in use.
+             */
+            Method getMethod() const;
+
+            /**
+             * Setter for algorithm.
+             * @param method Algorithm to use.
+             */
+            void setMethod(Method method);
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+    }
+}
+
+#endif
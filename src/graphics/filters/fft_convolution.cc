@@ -0,0 +1,337 @@
+#include "fft_convolution.h"
+#include "channels.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            using Complex = Math::FFT::Complex;
+
+            /*
+             * Relative error below which a kernel counts as separable.
+             */
+            const float SEPARABLE_TOLERANCE = 1e-5f;
+
+            /**
+             * Forward 2-D transform of a width x height real array into height rows of width / 2 + 1 values:
+             * real transforms along rows, then complex transforms down columns.
+             */
+            void forward2D(const std::vector<float> &in, std::vector<Complex> &out, int width, int height) {
+                int spectrumWidth = width / 2 + 1;
+                auto rowPlan = Math::RealFFT::cached(width);
+                auto columnPlan = Math::FFT::cached(height);
+
+                out.resize(static_cast<size_t>(spectrumWidth) * height);
+
+                Parallel::parallelFor(0, height, [&](int y) {
+                    rowPlan->forward(&in[static_cast<size_t>(y) * width],
+                                     &out[static_cast<size_t>(y) * spectrumWidth]);
+                });
+
+                Parallel::parallelBands(0, spectrumWidth, [&](int x1, int x2) {
+                    std::vector<Complex> column(height), transformed(height);
+
+                    for (int x = x1; x < x2; x++) {
+                        for (int y = 0; y < height; y++) {
+                            column[y] = out[static_cast<size_t>(y) * spectrumWidth + x];
+                        }
+
+                        columnPlan->forward(column.data(), transformed.data());
+
+                        for (int y = 0; y < height; y++) {
+                            out[static_cast<size_t>(y) * spectrumWidth + x] = transformed[y];
+                        }
+                    }
+                });
+            }
+
+            /**
+             * Inverse of forward2D; the spectrum is overwritten.
+             */
+            void inverse2D(std::vector<Complex> &in, std::vector<float> &out, int width, int height) {
+                int spectrumWidth = width / 2 + 1;
+                auto rowPlan = Math::RealFFT::cached(width);
+                auto columnPlan = Math::FFT::cached(height);
+
+                out.resize(static_cast<size_t>(width) * height);
+
+                Parallel::parallelBands(0, spectrumWidth, [&](int x1, int x2) {
+                    std::vector<Complex> column(height), transformed(height);
+
+                    for (int x = x1; x < x2; x++) {
+                        for (int y = 0; y < height; y++) {
+                            column[y] = in[static_cast<size_t>(y) * spectrumWidth + x];
+                        }
+
+                        columnPlan->inverse(column.data(), transformed.data());
+
+                        for (int y = 0; y < height; y++) {
+                            in[static_cast<size_t>(y) * spectrumWidth + x] = transformed[y];
+                        }
+                    }
+                });
+
+                Parallel::parallelFor(0, height, [&](int y) {
+                    rowPlan->inverse(&in[static_cast<size_t>(y) * spectrumWidth],
+                                     &out[static_cast<size_t>(y) * width]);
+                });
+            }
+        }
+
+        FFTConvolution::FFTConvolution(std::vector<float> _kernel, int _kernelWidth, int _kernelHeight,
+                                       EdgeMode _edge, Method _method)
+                : kernel(std::move(_kernel)), kernelWidth(_kernelWidth), kernelHeight(_kernelHeight), edge(_edge),
+                  method(_method) {
+            if (kernelWidth % 2 == 0 || kernelHeight % 2 == 0 || kernelWidth < 1 || kernelHeight < 1) {
+                throw std::invalid_argument("Convolution kernels must have odd, positive dimensions.");
+            }
+
+            if (kernel.size() != static_cast<size_t>(kernelWidth) * kernelHeight) {
+                throw std::invalid_argument("Kernel size does not match its dimensions.");
+            }
+
+            findFactors();
+
+            if (method == Method::SEPARABLE && !separable) {
+                throw std::invalid_argument("Kernel is not separable.");
+            }
+        }
+
+        void FFTConvolution::findFactors() {
+            // A rank one kernel is its largest entry's column times its row, scaled
+            size_t largest = 0;
+
+            for (size_t i = 0; i < kernel.size(); i++) {
+                if (std::abs(kernel[i]) > std::abs(kernel[largest])) largest = i;
+            }
+
+            int pivotX = largest % kernelWidth;
+            int pivotY = largest / kernelWidth;
+            float pivot = kernel[largest];
+
+            columnFactor.resize(kernelHeight);
+            rowFactor.resize(kernelWidth);
+
+            for (int j = 0; j < kernelHeight; j++) {
+                columnFactor[j] = kernel[j * kernelWidth + pivotX];
+            }
+
+            for (int i = 0; i < kernelWidth; i++) {
+                rowFactor[i] = pivot == 0 ? 0 : kernel[pivotY * kernelWidth + i] / pivot;
+            }
+
+            separable = true;
+
+            for (int j = 0; j < kernelHeight && separable; j++) {
+                for (int i = 0; i < kernelWidth; i++) {
+                    float error = kernel[j * kernelWidth + i] - columnFactor[j] * rowFactor[i];
+
+                    if (std::abs(error) > SEPARABLE_TOLERANCE * std::abs(pivot)) {
+                        separable = false;
+                        break;
+                    }
+                }
+            }
+        }
+
+        const std::vector<float> &FFTConvolution::getKernel() const {
+            return kernel;
+        }
+
+        int FFTConvolution::getKernelWidth() const {
+            return kernelWidth;
+        }
+
+        int FFTConvolution::getKernelHeight() const {
+            return kernelHeight;
+        }
+
+        EdgeMode FFTConvolution::getEdgeMode() const {
+            return edge;
+        }
+
+        bool FFTConvolution::isSeparable() const {
+            return separable;
+        }
+
+        FFTConvolution::Method FFTConvolution::chooseMethod(int width, int height) const {
+            if (method != Method::AUTO) return method;
+
+            // Rough cost per pixel and channel, in multiply-adds of the direct method
+            double direct = kernelWidth * kernelHeight;
+            double split = separable ? kernelWidth + kernelHeight : std::numeric_limits<double>::infinity();
+
+            double paddedArea = static_cast<double>(Math::nextFastFFTSize(width + kernelWidth - 1))
+                                * Math::nextFastFFTSize(height + kernelHeight - 1);
+            double fft = paddedArea / (std::max(width, 1) * static_cast<double>(std::max(height, 1)))
+                         * (12 * std::log2(paddedArea) + 16);
+
+            if (split <= direct && split <= fft) return Method::SEPARABLE;
+
+            return direct <= fft ? Method::DIRECT : Method::FFT;
+        }
+
+        std::shared_ptr<const FFTConvolution::Spectrum> FFTConvolution::kernelSpectrum(int width, int height) const {
+            std::lock_guard<std::mutex> lock(spectraMutex);
+            std::shared_ptr<const Spectrum> &spectrum = spectra[{width, height}];
+
+            if (!spectrum) {
+                std::vector<float> padded(static_cast<size_t>(width) * height, 0.0f);
+
+                for (int j = 0; j < kernelHeight; j++) {
+                    std::copy_n(&kernel[j * kernelWidth], kernelWidth, &padded[static_cast<size_t>(j) * width]);
+                }
+
+                auto transformed = std::make_shared<Spectrum>();
+                forward2D(padded, *transformed, width, height);
+
+                // Conjugating turns the product of spectra into a correlation, so the kernel is not flipped
+                for (Complex &c : *transformed) c = std::conj(c);
+
+                spectrum = transformed;
+            }
+
+            return spectrum;
+        }
+
+        void FFTConvolution::convolveDirect(std::vector<float> &data, int width, int height, int channels) const {
+            int rx = kernelWidth / 2;
+            int ry = kernelHeight / 2;
+            size_t stride = static_cast<size_t>(width) * channels;
+            size_t paddedStride = static_cast<size_t>(width + 2 * rx) * channels;
+
+            // Pad every row once so the inner loops need no edge checks
+            std::vector<float> padded(paddedStride * height);
+
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                for (int y = y1; y < y2; y++) {
+                    for (int x = -rx; x < width + rx; x++) {
+                        std::copy_n(&data[y * stride + edgeIndex(x, width, edge) * channels], channels,
+                                    &padded[y * paddedStride + (x + rx) * channels]);
+                    }
+                }
+            });
+
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                std::vector<float> sum(stride);
+
+                for (int y = y1; y < y2; y++) {
+                    std::fill(sum.begin(), sum.end(), 0.0f);
+
+                    for (int j = 0; j < kernelHeight; j++) {
+                        const float *row = &padded[edgeIndex(y + j - ry, height, edge) * paddedStride];
+
+                        for (int i = 0; i < kernelWidth; i++) {
+                            float weight = kernel[j * kernelWidth + i];
+                            if (weight == 0) continue;
+
+                            const float *in = row + i * channels;
+
+                            for (size_t k = 0; k < stride; k++) {
+                                sum[k] += weight * in[k];
+                            }
+                        }
+                    }
+
+                    std::copy(sum.begin(), sum.end(), &data[y * stride]);
+                }
+            });
+        }
+
+        void FFTConvolution::convolveFFT(std::vector<float> &data, int width, int height, int channels) const {
+            int rx = kernelWidth / 2;
+            int ry = kernelHeight / 2;
+            int paddedWidth = Math::nextFastFFTSize(width + 2 * rx);
+            int paddedHeight = Math::nextFastFFTSize(height + 2 * ry);
+
+            std::shared_ptr<const Spectrum> spectrum = kernelSpectrum(paddedWidth, paddedHeight);
+
+            std::vector<float> padded(static_cast<size_t>(paddedWidth) * paddedHeight);
+            std::vector<Complex> transformed;
+
+            for (int c = 0; c < channels; c++) {
+                // Image extended by the kernel radius at (rx, ry), zeros beyond
+                Parallel::parallelFor(0, paddedHeight, [&](int py) {
+                    float *row = &padded[static_cast<size_t>(py) * paddedWidth];
+
+                    if (py >= height + 2 * ry) {
+                        std::fill(row, row + paddedWidth, 0.0f);
+                        return;
+                    }
+
+                    const float *source = &data[static_cast<size_t>(edgeIndex(py - ry, height, edge)) * width
+                                                * channels];
+
+                    for (int px = 0; px < width + 2 * rx; px++) {
+                        row[px] = source[edgeIndex(px - rx, width, edge) * channels + c];
+                    }
+
+                    std::fill(row + width + 2 * rx, row + paddedWidth, 0.0f);
+                });
+
+                forward2D(padded, transformed, paddedWidth, paddedHeight);
+
+                for (size_t i = 0; i < transformed.size(); i++) {
+                    transformed[i] *= (*spectrum)[i];
+                }
+
+                inverse2D(transformed, padded, paddedWidth, paddedHeight);
+
+                Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                    for (int y = y1; y < y2; y++) {
+                        for (int x = 0; x < width; x++) {
+                            data[(static_cast<size_t>(y) * width + x) * channels + c] =
+                                    padded[static_cast<size_t>(y) * paddedWidth + x];
+                        }
+                    }
+                });
+            }
+        }
+
+        template<typename T>
+        void FFTConvolution::convolve(Pixmap<T> &map) const {
+            constexpr int C = ChannelTraits<T>::count;
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+
+            if (map.getArea() == 0) return;
+
+            switch (chooseMethod(width, height)) {
+                case Method::SEPARABLE:
+                    SeparableConvolution(rowFactor, columnFactor, edge).applyTo(map);
+                    return;
+                case Method::FFT: {
+                    std::vector<float> data = loadChannels<float>(map);
+                    convolveFFT(data, width, height, C);
+                    storeChannels(map, data);
+                    return;
+                }
+                default: {
+                    std::vector<float> data = loadChannels<float>(map);
+                    convolveDirect(data, width, height, C);
+                    storeChannels(map, data);
+                    return;
+                }
+            }
+        }
+
+        void FFTConvolution::applyTo(Bitmap &map) {
+            convolve(map);
+        }
+
+        void FFTConvolution::applyTo(Graymap &map) {
+            convolve(map);
+        }
+
+        void FFTConvolution::applyTo(RGBMap &map) {
+            convolve(map);
+        }
+
+        void FFTConvolution::applyTo(RGBAMap &map) {
+            convolve(map);
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef FFT_CONVOLUTION_DEFINED_
+#define FFT_CONVOLUTION_DEFINED_
+
+#include "filter.h"
+#include "convolution.h"
+#include "../../math/fft.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * Convolution with an arbitrary 2-D kernel, computed directly, as two 1-D passes when the kernel is
+         * separable, or through the fast Fourier transform, whichever is estimated to be cheapest for the image
+         * and kernel size. Like SeparableConvolution, the kernel is applied without flipping: pixel (x, y) becomes
+         * the sum of kernel[j * kernelWidth + i] * pixel(x + i - kernelWidth / 2, y + j - kernelHeight / 2).
+         *
+         * The FFT path pads the image by the kernel radius according to the edge mode, and zero-fills it up to a
+         * size with small prime factors, so no wraparound reaches the result. Transform plans are shared globally,
+         * and the kernel spectrum is cached per padded size, so repeated calls on images of the same size only
+         * transform the image.
+         */
+        class FFTConvolution : public Filter {
+        public:
+            /**
+             * How the convolution is computed.
+             */
+            enum class Method {
+                AUTO, ///< Pick the cheapest method for each image
+                DIRECT,
+                SEPARABLE, ///< Only allowed for separable kernels
+                FFT
+            };
+
+        private:
+            using Spectrum = std::vector<Math::FFT::Complex>;
+
+            std::vector<float> kernel;
+            int kernelWidth;
+            int kernelHeight;
+            EdgeMode edge;
+            Method method;
+
+            bool separable = false;
+            std::vector<float> rowFactor;
+            std::vector<float> columnFactor;
+
+            mutable std::mutex spectraMutex;
+            mutable std::map<std::pair<int, int>, std::shared_ptr<const Spectrum>> spectra;
+
+            void findFactors();
+
+            std::shared_ptr<const Spectrum> kernelSpectrum(int width, int height) const;
+
+            void convolveDirect(std::vector<float> &data, int width, int height, int channels) const;
+
+            void convolveFFT(std::vector<float> &data, int width, int height, int channels) const;
+
+            template<typename T>
+            void convolve(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Constructor.
+             * @param kernel Row-major kernel weights.
+             * @param kernelWidth Kernel width, odd.
+             * @param kernelHeight Kernel height, odd.
+             * @param edge Edge mode.
+             * @param method Method to use.
+             */
+            FFTConvolution(std::vector<float> kernel, int kernelWidth, int kernelHeight,
+                           EdgeMode edge = EdgeMode::CLAMP, Method method = Method::AUTO);
+
+            /**
+             * Getter for kernel.
+             * @return Row-major kernel weights.
+             */
+            const std::vector<float> &getKernel() const;
+
+            /**
+             * Getter for kernel width.
+             * @return Kernel width.
+             */
+            int getKernelWidth() const;
+
+            /**
+             * Getter for kernel height.
+             * @return Kernel height.
+             */
+            int getKernelHeight() const;
+
+            /**
+             * Getter for edge mode.
+             * @return Edge mode.
+             */
+            EdgeMode getEdgeMode() const;
+
+            /**
+             * Whether the kernel is the product of a column and a row vector.
+             * @return Whether the kernel is separable.
+             */
+            bool isSeparable() const;
+
+            /**
+             * Method that will be used for an image of the given size.
+             * @param width Image width.
+             * @param height Image height.
+             * @return DIRECT, SEPARABLE or FFT.
+             */
+            Method chooseMethod(int width, int height) const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+    }
+}
+
+#endif
@@ -12,6 +12,9 @@ namespace Sine::Graphics {
          * Abstract base class for all filters.
          */
         class Filter {
+        public:
+            virtual ~Filter() = default;
+
             /**
              * Apply filter to Bitmap.
              * @param map Bitmap instance.
@@ -2,8 +2,11 @@
 #define GAUSSIAN_BLUR_DEFINED_
 
 #include "filter.h"
+#include "convolution.h"
 #include <iostream>
 #include <limits>
+#include <vector>
+#include <cstdlib>
 
 namespace Sine::Graphics {
     namespace Filters {
@@ -143,23 +146,10 @@ namespace Sine::Graphics {
                 };
             };
 
-            /**
-             * Sums an array recursively
-             * @param array Array to sum
-             * @param pos_first_elem Position of first element
-             * @param pos_last_elem Position of last element
-             * @return Sum of array
-             */
-            constexpr unsigned long sum(const unsigned int array[], int pos_first_elem, int pos_last_elem) {
-                return (pos_first_elem == pos_last_elem) ? array[pos_first_elem] : array[pos_first_elem] +
-                                                                                   sum(array, pos_first_elem + 1,
-                                                                                       pos_last_elem);
-            }
-
         };
 
         /**
-         * Gaussian Blur Filter.
+         * Gaussian Blur Filter, computed by SeparableConvolution in fixed point with clamped edges.
          * @tparam size Radius of the blur.
          */
         template<unsigned int size>
@@ -170,10 +160,18 @@ namespace Sine::Graphics {
              */
             typedef typename generate_array<
                     size + 1, 50 * size, MetaFunc>::result gaussian_gen;
+
             /**
-             * Scale factor of gaussian array.
+             * Normalized kernel built from gaussian_gen.
+             * @return Kernel of length 2 * size + 1.
              */
-            static unsigned long denominator;
+            static std::vector<float> kernel();
+
+            /**
+             * Applies the kernel through SeparableConvolution.
+             */
+            template<typename T>
+            void blur(Pixmap<T> &map);
 
         public:
             void applyTo(Bitmap &map);
@@ -197,246 +195,52 @@ namespace Sine::Graphics {
             }
         }
 
-        // Calculate denominator based on sum of gaussian_gen
-        template<unsigned int size>
-        unsigned long GaussianBlur<size>::denominator =
-                sum(gaussian_gen::data, 1, size + 1) * 2 + gaussian_gen::data[0];
-
-        // The general blur strategy is to go in two passes, one vertical and the other horizontal.
-        // The properties of the gaussian blur make this possible. This reduces computational complexity
-        // from O(4whr^2) to O(2whr), where w is width, h is height, and r is the blur radius.
-
         template<unsigned int size>
-        void GaussianBlur<size>::applyTo(Bitmap &map) {
-            int width = map.getWidth();
-            int height = map.getHeight();
-            int size_nu = size;
-
-            bool a[std::max(width, height)]; // Buffer which holds the current row or column, should fit in cache...
-
-            for (int y_s = 0; y_s < height; y_s++) {
-                for (int x_s = 0; x_s < width; x_s++) { // Fill up the buffer with a row
-                    a[x_s] = map.getPixelUnsafe(x_s, y_s);
-                }
-
-                for (int x_s = 0; x_s < width; x_s++) {
-                    long graySum = 0;
-                    int multiplier;
+        std::vector<float> GaussianBlur<size>::kernel() {
+            std::vector<float> ret(2 * size + 1);
+            float total = 0;
 
-                    for (int x_f = std::max(0, x_s - size_nu), loc = x_f - x_s;
-                         x_f <=
-                         std::min(width - 1, x_s + size_nu); x_f++, loc++) { // Pretty liberal usage of , operator eh
-                        multiplier = gaussian_gen::data[std::abs(loc)]; // Weighted sum based on Gaussian function
-
-                        graySum += a[x_f] ? 0 : 256 * multiplier;
-                    }
-
-                    graySum /= denominator; // Find average
-
-                    map.setPixelUnsafe(x_s, y_s, (graySum < 128)); // Pixel output
-                }
+            for (int i = -static_cast<int>(size); i <= static_cast<int>(size); i++) {
+                ret[i + size] = gaussian_gen::data[std::abs(i)];
+                total += ret[i + size];
             }
 
-            for (int x_s = 0; x_s < width; x_s++) {
-                for (int y_s = 0; y_s < height; y_s++) { // Fill up the buffer with a column
-                    a[y_s] = map.getPixelUnsafe(x_s, y_s);
-                }
-
-                for (int y_s = 0; y_s < height; y_s++) {
-                    long graySum = 0;
-                    int multiplier;
+            for (float &weight : ret) {
+                weight /= total;
+            }
 
-                    for (int y_f = std::max(0, y_s - size_nu), loc = y_f - y_s;
-                         y_f <= std::min(width - 1, y_s + size_nu); y_f++, loc++) {
-                        multiplier = gaussian_gen::data[std::abs(loc)];
+            return ret;
+        }
 
-                        graySum += a[y_f] ? 0 : 256 * multiplier;
-                    }
+        // The general blur strategy is to go in two passes, one vertical and the other horizontal.
+        // The properties of the gaussian blur make this possible. This reduces computational complexity
+        // from O(4whr^2) to O(2whr), where w is width, h is height, and r is the blur radius.
 
-                    graySum /= denominator;
+        template<unsigned int size>
+        template<typename T>
+        void GaussianBlur<size>::blur(Pixmap<T> &map) {
+            SeparableConvolution convolution(kernel(), EdgeMode::CLAMP, SeparableConvolution::Precision::FIXED);
+            convolution.applyTo(map);
+        }
 
-                    map.setPixelUnsafe(x_s, y_s, (graySum < 128));
-                }
-            }
+        template<unsigned int size>
+        void GaussianBlur<size>::applyTo(Bitmap &map) {
+            blur(map);
         }
 
         template<unsigned int size>
         void GaussianBlur<size>::applyTo(Graymap &map) {
-            int width = map.getWidth();
-            int height = map.getHeight();
-            int size_nu = size;
-
-            unsigned char a[std::max(width, height)];
-
-            for (int y_s = 0; y_s < height; y_s++) {
-                for (int x_s = 0; x_s < width; x_s++) {
-                    a[x_s] = map.getPixelUnsafe(x_s, y_s);
-                }
-
-                for (int x_s = 0; x_s < width; x_s++) {
-                    long graySum = 0;
-                    int multiplier;
-
-                    for (int x_f = std::max(0, x_s - size_nu), loc = x_f - x_s;
-                         x_f <= std::min(width - 1, x_s + size_nu); x_f++, loc++) {
-                        multiplier = gaussian_gen::data[std::abs(loc)];
-
-                        graySum += multiplier * a[x_f];
-                    }
-
-                    graySum /= denominator;
-
-                    map.setPixelUnsafe(x_s, y_s, graySum);
-                }
-            }
-
-            for (int x_s = 0; x_s < width; x_s++) {
-                for (int y_s = 0; y_s < height; y_s++) {
-                    a[y_s] = map.getPixelUnsafe(x_s, y_s);
-                }
-
-                for (int y_s = 0; y_s < height; y_s++) {
-                    long graySum = 0;
-                    int multiplier;
-
-                    for (int y_f = std::max(0, y_s - size_nu), loc = y_f - y_s;
-                         y_f <= std::min(height - 1, y_s + size_nu); y_f++, loc++) {
-                        multiplier = gaussian_gen::data[std::abs(loc)];
-
-                        graySum += multiplier * a[y_f];
-                    }
-
-                    graySum /= denominator;
-
-                    map.setPixelUnsafe(x_s, y_s, graySum);
-                }
-            }
+            blur(map);
         }
 
         template<unsigned int size>
         void GaussianBlur<size>::applyTo(RGBMap &map) {
-            int width = map.getWidth();
-            int height = map.getHeight();
-            int size_nu = size;
-
-            RGB a[std::max(width, height)];
-
-            for (int y_s = 0; y_s < height; y_s++) {
-                for (int x_s = 0; x_s < width; x_s++) {
-                    a[x_s] = map.getPixelUnsafe(x_s, y_s);
-                }
-
-                for (int x_s = 0; x_s < width; x_s++) {
-                    long rSum = 0, gSum = 0, bSum = 0;
-                    int multiplier;
-
-                    for (int x_f = std::max(0, x_s - size_nu), loc = x_f - x_s;
-                         x_f <= std::min(width - 1, x_s + size_nu); x_f++, loc++) {
-                        multiplier = gaussian_gen::data[std::abs(loc)];
-
-                        rSum += multiplier * a[x_f].r;
-                        gSum += multiplier * a[x_f].g;
-                        bSum += multiplier * a[x_f].b;
-                    }
-
-                    rSum /= denominator;
-                    gSum /= denominator;
-                    bSum /= denominator;
-
-                    map.setPixelUnsafe(x_s, y_s, RGB(rSum, gSum, bSum));
-                }
-            }
-
-            for (int x_s = 0; x_s < width; x_s++) {
-                for (int y_s = 0; y_s < height; y_s++) {
-                    a[y_s] = map.getPixelUnsafe(x_s, y_s);
-                }
-
-                for (int y_s = 0; y_s < height; y_s++) {
-                    long rSum = 0, gSum = 0, bSum = 0;
-                    int multiplier;
-
-                    for (int y_f = std::max(0, y_s - size_nu), loc = y_f - y_s;
-                         y_f <= std::min(height - 1, y_s + size_nu); y_f++, loc++) {
-                        multiplier = gaussian_gen::data[std::abs(loc)];
-
-                        rSum += multiplier * a[y_f].r;
-                        gSum += multiplier * a[y_f].g;
-                        bSum += multiplier * a[y_f].b;
-                    }
-
-                    rSum /= denominator;
-                    gSum /= denominator;
-                    bSum /= denominator;
-
-                    map.setPixelUnsafe(x_s, y_s, RGB(rSum, gSum, bSum));
-                }
-            }
+            blur(map);
         }
 
         template<unsigned int size>
         void GaussianBlur<size>::applyTo(RGBAMap &map) {
-            int width = map.getWidth();
-            int height = map.getHeight();
-            int size_nu = size;
-
-            RGBA a[std::max(width, height)];
-
-            for (int y_s = 0; y_s < height; y_s++) {
-                for (int x_s = 0; x_s < width; x_s++) {
-                    a[x_s] = map.getPixelUnsafe(x_s, y_s);
-                }
-
-                for (int x_s = 0; x_s < width; x_s++) {
-                    long rSum = 0, gSum = 0, bSum = 0, aSum = 0;
-                    int multiplier;
-
-                    for (int x_f = std::max(0, x_s - size_nu), loc = x_f - x_s;
-                         x_f <= std::min(width - 1, x_s + size_nu); x_f++, loc++) {
-                        multiplier = gaussian_gen::data[std::abs(loc)];
-
-                        rSum += multiplier * a[x_f].r;
-                        gSum += multiplier * a[x_f].g;
-                        bSum += multiplier * a[x_f].b;
-                        aSum += multiplier * a[x_f].a;
-                    }
-
-                    rSum /= denominator;
-                    gSum /= denominator;
-                    bSum /= denominator;
-                    aSum /= denominator;
-
-                    map.setPixelUnsafe(x_s, y_s, RGBA(rSum, gSum, bSum, aSum));
-                }
-            }
-
-            for (int x_s = 0; x_s < width; x_s++) {
-                for (int y_s = 0; y_s < height; y_s++) {
-                    a[y_s] = map.getPixelUnsafe(x_s, y_s);
-                }
-
-                for (int y_s = 0; y_s < height; y_s++) {
-                    long rSum = 0, gSum = 0, bSum = 0, aSum = 0;
-                    int multiplier;
-
-                    for (int y_f = std::max(0, y_s - size_nu), loc = y_f - y_s;
-                         y_f <= std::min(height - 1, y_s + size_nu); y_f++, loc++) {
-                        multiplier = gaussian_gen::data[std::abs(loc)];
-
-                        rSum += multiplier * a[y_f].r;
-                        gSum += multiplier * a[y_f].g;
-                        bSum += multiplier * a[y_f].b;
-                        aSum += multiplier * a[y_f].a;
-                    }
-
-                    rSum /= denominator;
-                    gSum /= denominator;
-                    bSum /= denominator;
-                    aSum /= denominator;
-
-                    map.setPixelUnsafe(x_s, y_s, RGBA(rSum, gSum, bSum, aSum));
-                }
-            }
+            blur(map);
         }
     } // namespace Filters
 } // namespace Sine
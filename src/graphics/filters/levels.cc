@@ -0,0 +1,379 @@
+#include "levels.h"
+#include "channels.h"
+#include "../histogram.h"
+#include "../parallel.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            /**
+             * Number of channels of a pixel type carrying color, as opposed to alpha.
+             */
+            template<typename T>
+            constexpr int colorChannels() {
+                return std::min(ChannelTraits<T>::count, 3);
+            }
+
+            /**
+             * Calls func(channels) on the byte channels of every pixel in a single parallel pass, storing them back.
+             */
+            template<typename T, typename Func>
+            void forEachPixel(Pixmap<T> &map, Func func) {
+                constexpr int C = ChannelTraits<T>::count;
+                T *pixels = map.getPixels();
+
+                Parallel::parallelBands(0, map.getArea(), [&](int i1, int i2) {
+                    uint8_t c[C];
+
+                    for (int i = i1; i < i2; i++) {
+                        ChannelTraits<T>::load(pixels[i], c);
+                        func(c);
+                        pixels[i] = ChannelTraits<T>::store(c);
+                    }
+                });
+            }
+
+            /**
+             * Moves the luma of a pixel from one level to another. Colors are scaled by the ratio of the two, clamped,
+             * so that their hue is kept; a single channel is just set.
+             */
+            template<int C>
+            inline void setLuma(uint8_t *c, int from, int to) {
+                if (C < 3) {
+                    c[0] = to;
+                } else if (from == 0) {
+                    c[0] = c[1] = c[2] = to;
+                } else {
+                    for (int k = 0; k < 3; k++) {
+                        c[k] = std::min((c[k] * to + from / 2) / from, 255);
+                    }
+                }
+            }
+
+            template<int C>
+            inline int lumaOf(const uint8_t *c) {
+                return C >= 3 ? Histogram::luma(c[0], c[1], c[2]) : c[0];
+            }
+
+            /**
+             * Table stretching the levels from low to high over the full range.
+             */
+            LevelTable stretch(int low, int high) {
+                if (high <= low) return LookupTable::identity();
+
+                LevelTable ret;
+
+                for (int v = 0; v < 256; v++) {
+                    ret[v] = toByte(static_cast<float>(v - low) * 255 / (high - low));
+                }
+
+                return ret;
+            }
+        }
+
+        LevelTable LookupTable::identity() {
+            LevelTable ret;
+
+            for (int v = 0; v < 256; v++) ret[v] = v;
+
+            return ret;
+        }
+
+        LevelTable LookupTable::sample(const std::function<float(float)> &curve) {
+            LevelTable ret;
+
+            for (int v = 0; v < 256; v++) {
+                ret[v] = toByte(curve(v / 255.0f) * 255);
+            }
+
+            return ret;
+        }
+
+        LookupTable LookupTable::fromCurve(const std::function<float(float)> &curve) {
+            return LookupTable(sample(curve));
+        }
+
+        LookupTable::LookupTable(const LevelTable &table) : tables{table, table, table} {
+        }
+
+        LookupTable::LookupTable(const LevelTable &red, const LevelTable &green, const LevelTable &blue)
+                : tables{red, green, blue} {
+        }
+
+        const LevelTable &LookupTable::getTable(int channel) const {
+            return tables.at(channel);
+        }
+
+        template<typename T>
+        void LookupTable::filter(Pixmap<T> &map) const {
+            constexpr int C = colorChannels<T>();
+
+            forEachPixel(map, [&](uint8_t *c) {
+                for (int k = 0; k < C; k++) c[k] = tables[k][c[k]];
+            });
+        }
+
+        void LookupTable::applyTo(Bitmap &map) {
+            filter(map);
+        }
+
+        void LookupTable::applyTo(Graymap &map) {
+            filter(map);
+        }
+
+        void LookupTable::applyTo(RGBMap &map) {
+            filter(map);
+        }
+
+        void LookupTable::applyTo(RGBAMap &map) {
+            filter(map);
+        }
+
+        AutoLevels::AutoLevels(double _clip, bool _perChannel) : clip(_clip), perChannel(_perChannel) {
+            if (!(clip >= 0 && clip < 0.5)) {
+                throw std::invalid_argument("Auto levels clip fraction must be in [0, 0.5).");
+            }
+        }
+
+        double AutoLevels::getClip() const {
+            return clip;
+        }
+
+        bool AutoLevels::isPerChannel() const {
+            return perChannel;
+        }
+
+        template<typename T>
+        void AutoLevels::filter(Pixmap<T> &map) const {
+            constexpr int C = colorChannels<T>();
+
+            if (map.getArea() == 0) return;
+
+            Histogram histogram = Histogram::ofChannels(map);
+            LevelTable tables[3];
+
+            for (int k = 0; k < C; k++) {
+                Histogram levels = perChannel ? histogram.pooled(k, 1) : histogram.pooled(0, C);
+
+                tables[k] = stretch(levels.percentile(clip), levels.percentile(1 - clip));
+            }
+
+            if (C == 1) {
+                LookupTable(tables[0]).applyTo(map);
+            } else {
+                LookupTable(tables[0], tables[1], tables[2]).applyTo(map);
+            }
+        }
+
+        void AutoLevels::applyTo(Bitmap &) {
+        }
+
+        void AutoLevels::applyTo(Graymap &map) {
+            filter(map);
+        }
+
+        void AutoLevels::applyTo(RGBMap &map) {
+            filter(map);
+        }
+
+        void AutoLevels::applyTo(RGBAMap &map) {
+            filter(map);
+        }
+
+        namespace {
+            template<typename T>
+            void equalize(Pixmap<T> &map) {
+                constexpr int C = ChannelTraits<T>::count;
+
+                if (map.getArea() == 0) return;
+
+                LevelTable table = Histogram::ofLuminance(map).equalization();
+
+                forEachPixel(map, [&](uint8_t *c) {
+                    int luma = lumaOf<C>(c);
+                    setLuma<C>(c, luma, table[luma]);
+                });
+            }
+        }
+
+        void HistogramEqualization::applyTo(Bitmap &) {
+        }
+
+        void HistogramEqualization::applyTo(Graymap &map) {
+            equalize(map);
+        }
+
+        void HistogramEqualization::applyTo(RGBMap &map) {
+            equalize(map);
+        }
+
+        void HistogramEqualization::applyTo(RGBAMap &map) {
+            equalize(map);
+        }
+
+        CLAHE::CLAHE(int _tilesX, int _tilesY, double _clipLimit)
+                : tilesX(_tilesX), tilesY(_tilesY), clipLimit(_clipLimit) {
+            if (tilesX < 1 || tilesY < 1) {
+                throw std::invalid_argument("CLAHE needs at least one tile in each direction.");
+            }
+
+            if (!(clipLimit >= 1)) {
+                throw std::invalid_argument("CLAHE clip limit must be at least 1.");
+            }
+        }
+
+        int CLAHE::getTilesX() const {
+            return tilesX;
+        }
+
+        int CLAHE::getTilesY() const {
+            return tilesY;
+        }
+
+        double CLAHE::getClipLimit() const {
+            return clipLimit;
+        }
+
+        namespace {
+            /**
+             * Pair of neighboring tiles and the weight of the second, for every pixel along one axis.
+             */
+            struct TileBlend {
+                std::vector<int> first;
+                std::vector<float> weight;
+
+                TileBlend(int length, int tiles) : first(length), weight(length) {
+                    double tileLength = static_cast<double>(length) / tiles;
+
+                    for (int i = 0; i < length; i++) {
+                        // Position relative to the tile centers, clamped past the outermost ones
+                        double t = (i + 0.5) / tileLength - 0.5;
+                        int tile = static_cast<int>(std::floor(t));
+
+                        if (tile < 0) {
+                            first[i] = 0;
+                            weight[i] = 0;
+                        } else if (tile >= tiles - 1) {
+                            first[i] = tiles - 1;
+                            weight[i] = 0;
+                        } else {
+                            first[i] = tile;
+                            weight[i] = static_cast<float>(t - tile);
+                        }
+                    }
+                }
+
+                int second(int i) const {
+                    return weight[i] > 0 ? first[i] + 1 : first[i];
+                }
+            };
+        }
+
+        template<typename T>
+        void CLAHE::filter(Pixmap<T> &map) const {
+            constexpr int C = ChannelTraits<T>::count;
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+
+            if (map.getArea() == 0) return;
+
+            // Tiles are at least a pixel
+            int columns = std::min(tilesX, width);
+            int rows = std::min(tilesY, height);
+
+            std::vector<uint8_t> lumas(map.getArea());
+            T *pixels = map.getPixels();
+
+            Parallel::parallelBands(0, map.getArea(), [&](int i1, int i2) {
+                uint8_t c[C];
+
+                for (int i = i1; i < i2; i++) {
+                    ChannelTraits<T>::load(pixels[i], c);
+                    lumas[i] = lumaOf<C>(c);
+                }
+            });
+
+            std::vector<LevelTable> tables(static_cast<size_t>(columns) * rows);
+
+            Parallel::parallelFor(0, columns * rows, [&](int tile) {
+                int x1 = width * (tile % columns) / columns, x2 = width * (tile % columns + 1) / columns;
+                int y1 = height * (tile / columns) / rows, y2 = height * (tile / columns + 1) / rows;
+                long area = static_cast<long>(x2 - x1) * (y2 - y1);
+
+                long bins[256] = {};
+
+                for (int y = y1; y < y2; y++) {
+                    const uint8_t *row = &lumas[static_cast<size_t>(y) * width];
+
+                    for (int x = x1; x < x2; x++) bins[row[x]]++;
+                }
+
+                // Clip and spread the excess evenly, the remainder one count per bin at regular intervals
+                long limit = std::max(static_cast<long>(clipLimit * area / 256), 1L);
+                long excess = 0;
+
+                for (long &bin : bins) {
+                    if (bin > limit) {
+                        excess += bin - limit;
+                        bin = limit;
+                    }
+                }
+
+                for (long &bin : bins) bin += excess / 256;
+                for (long k = 0, remainder = excess % 256; k < remainder; k++) bins[k * 256 / remainder]++;
+
+                LevelTable &table = tables[tile];
+                long cumulative = 0;
+
+                for (int v = 0; v < 256; v++) {
+                    cumulative += bins[v];
+                    table[v] = static_cast<uint8_t>((cumulative * 255 + area / 2) / area);
+                }
+            });
+
+            TileBlend blendX(width, columns), blendY(height, rows);
+
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                uint8_t c[C];
+
+                for (int y = y1; y < y2; y++) {
+                    const LevelTable *top = &tables[static_cast<size_t>(blendY.first[y]) * columns];
+                    const LevelTable *bottom = &tables[static_cast<size_t>(blendY.second(y)) * columns];
+                    float wy = blendY.weight[y];
+
+                    for (int x = 0; x < width; x++) {
+                        size_t i = static_cast<size_t>(y) * width + x;
+                        int left = blendX.first[x], right = blendX.second(x);
+                        float wx = blendX.weight[x];
+                        uint8_t luma = lumas[i];
+
+                        float upper = top[left][luma] + wx * (top[right][luma] - top[left][luma]);
+                        float lower = bottom[left][luma] + wx * (bottom[right][luma] - bottom[left][luma]);
+
+                        ChannelTraits<T>::load(pixels[i], c);
+                        setLuma<C>(c, luma, toByte(upper + wy * (lower - upper)));
+                        pixels[i] = ChannelTraits<T>::store(c);
+                    }
+                }
+            });
+        }
+
+        void CLAHE::applyTo(Bitmap &) {
+        }
+
+        void CLAHE::applyTo(Graymap &map) {
+            filter(map);
+        }
+
+        void CLAHE::applyTo(RGBMap &map) {
+            filter(map);
+        }
+
+        void CLAHE::applyTo(RGBAMap &map) {
+            filter(map);
+        }
+    }
+}
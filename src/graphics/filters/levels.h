@@ -0,0 +1,193 @@
+#ifndef LEVELS_DEFINED_
+#define LEVELS_DEFINED_
+
+#include "filter.h"
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * 256-entry table mapping each level of a channel to a new level.
+         */
+        using LevelTable = std::array<uint8_t, 256>;
+
+        /**
+         * Remaps the color channels of every pixel through lookup tables, in a single parallel pass. Alpha is left
+         * unchanged; Graymaps and Bitmaps use the first table, Bitmaps thresholding the result at 128.
+         */
+        class LookupTable : public Filter {
+        private:
+            std::vector<LevelTable> tables;
+
+            template<typename T>
+            void filter(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Table which leaves every level unchanged.
+             * @return Identity table.
+             */
+            static LevelTable identity();
+
+            /**
+             * Samples a curve into a table.
+             * @param curve Function from 0 - 1 to 0 - 1, clamped.
+             * @return Table.
+             */
+            static LevelTable sample(const std::function<float(float)> &curve);
+
+            /**
+             * Constructor for a filter applying a curve to every color channel.
+             * @param curve Function from 0 - 1 to 0 - 1, clamped.
+             * @return Filter.
+             */
+            static LookupTable fromCurve(const std::function<float(float)> &curve);
+
+            /**
+             * Constructor for a filter applying the same table to every color channel.
+             * @param table Table.
+             */
+            explicit LookupTable(const LevelTable &table);
+
+            /**
+             * Constructor for a filter applying a table to each color channel.
+             * @param red Table for red, and for Graymaps and Bitmaps.
+             * @param green Table for green.
+             * @param blue Table for blue.
+             */
+            LookupTable(const LevelTable &red, const LevelTable &green, const LevelTable &blue);
+
+            /**
+             * Getter for a table.
+             * @param channel Color channel index, from 0 to 2.
+             * @return Table.
+             */
+            const LevelTable &getTable(int channel = 0) const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+
+        /**
+         * Stretches the levels of an image so that a small fraction of its pixels clip to black and to white.
+         *
+         * Costs one parallel histogram pass and one lookup table pass. By default, the black and white points are
+         * taken from the histogram of all color channels pooled, which keeps the color balance; per channel, each is
+         * stretched on its own, which also removes color casts. Alpha and Bitmaps are left unchanged.
+         */
+        class AutoLevels : public Filter {
+        private:
+            double clip;
+            bool perChannel;
+
+            template<typename T>
+            void filter(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Constructor.
+             * @param clip Fraction of the pixels clipped at each end, from 0 to 0.5.
+             * @param perChannel Whether to stretch each color channel on its own.
+             */
+            explicit AutoLevels(double clip = 0.005, bool perChannel = false);
+
+            /**
+             * Getter for clipped fraction.
+             * @return Fraction of the pixels clipped at each end.
+             */
+            double getClip() const;
+
+            /**
+             * Whether each color channel is stretched on its own.
+             * @return Whether each color channel is stretched on its own.
+             */
+            bool isPerChannel() const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+
+        /**
+         * Flattens the histogram of the luma of an image. Colors are scaled by the ratio of their new luma to their
+         * old, which keeps their hue. Bitmaps are left unchanged.
+         */
+        class HistogramEqualization : public Filter {
+        public:
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+
+        /**
+         * Contrast limited adaptive histogram equalization.
+         *
+         * The image is split into a grid of tiles, and each tile gets an equalization table from its own luma
+         * histogram, with bins clipped at clipLimit times their mean height and the excess spread over all bins, which
+         * caps how much contrast noise can gain. Every pixel blends the tables of its four nearest tile centers
+         * bilinearly, so there are no seams. Colors are scaled as in HistogramEqualization. Bitmaps are left
+         * unchanged.
+         */
+        class CLAHE : public Filter {
+        private:
+            int tilesX;
+            int tilesY;
+            double clipLimit;
+
+            template<typename T>
+            void filter(Pixmap<T> &map) const;
+
+        public:
+            /**
+             * Constructor.
+             * @param tilesX Number of tile columns, positive.
+             * @param tilesY Number of tile rows, positive.
+             * @param clipLimit Maximum height of a bin as a multiple of the mean, at least 1.
+             */
+            explicit CLAHE(int tilesX = 8, int tilesY = 8, double clipLimit = 2);
+
+            /**
+             * Getter for tile columns.
+             * @return Number of tile columns.
+             */
+            int getTilesX() const;
+
+            /**
+             * Getter for tile rows.
+             * @return Number of tile rows.
+             */
+            int getTilesY() const;
+
+            /**
+             * Getter for clip limit.
+             * @return Maximum height of a bin as a multiple of the mean.
+             */
+            double getClipLimit() const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,190 @@
+#include "median_filter.h"
+#include "channels.h"
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            const int COARSE = 16;
+            const int FINE = 256;
+
+            /*
+             * Fewest rows per band, since every band rebuilds its column histograms from scratch.
+             */
+            const int MIN_BAND = 32;
+
+            /**
+             * Adds (sign 1) or subtracts (sign -1) a run of column histogram bins from window histogram bins.
+             */
+            template<int N>
+            inline void accumulate(uint32_t *window, const uint16_t *column, int sign) {
+                if (sign > 0) {
+                    for (int i = 0; i < N; i++) window[i] += column[i];
+                } else {
+                    for (int i = 0; i < N; i++) window[i] -= column[i];
+                }
+            }
+
+            /**
+             * Median filters rows [y1, y2) of one channel.
+             * @param in Channels of the source.
+             * @param out Channels of the result.
+             * @param channels Channel count.
+             * @param c Channel to filter.
+             */
+            void medianBand(const std::vector<uint8_t> &in, std::vector<uint8_t> &out, int width, int height,
+                            int channels, int c, int radius, int y1, int y2,
+                            std::vector<uint16_t> &columnCoarse, std::vector<uint16_t> &columnFine) {
+                size_t stride = static_cast<size_t>(width) * channels;
+
+                columnCoarse.assign(static_cast<size_t>(width) * COARSE, 0);
+                columnFine.assign(static_cast<size_t>(width) * FINE, 0);
+
+                auto addRow = [&](int y, int delta) {
+                    const uint8_t *row = &in[y * stride + c];
+
+                    for (int x = 0; x < width; x++) {
+                        uint8_t v = row[x * channels];
+
+                        columnCoarse[x * COARSE + (v >> 4)] += delta;
+                        columnFine[x * FINE + v] += delta;
+                    }
+                };
+
+                for (int y = std::max(y1 - radius, 0); y <= std::min(y1 + radius - 1, height - 1); y++) {
+                    addRow(y, 1);
+                }
+
+                uint32_t coarse[COARSE];
+                uint32_t fine[FINE];
+                int fineX[COARSE];
+
+                for (int y = y1; y < y2; y++) {
+                    // Slide the column histograms down to rows [y - radius, y + radius]
+                    if (y - radius - 1 >= 0 && y > y1) addRow(y - radius - 1, -1);
+                    if (y + radius < height) addRow(y + radius, 1);
+
+                    int rows = std::min(y + radius, height - 1) - std::max(y - radius, 0) + 1;
+
+                    std::fill(coarse, coarse + COARSE, 0);
+                    std::fill(fineX, fineX + COARSE, -1);
+
+                    for (int x = 0; x <= std::min(radius, width - 1); x++) {
+                        accumulate<COARSE>(coarse, &columnCoarse[x * COARSE], 1);
+                    }
+
+                    for (int x = 0; x < width; x++) {
+                        if (x > 0) {
+                            if (x + radius < width) {
+                                accumulate<COARSE>(coarse, &columnCoarse[(x + radius) * COARSE], 1);
+                            }
+                            if (x - radius - 1 >= 0) {
+                                accumulate<COARSE>(coarse, &columnCoarse[(x - radius - 1) * COARSE], -1);
+                            }
+                        }
+
+                        int columns = std::min(x + radius, width - 1) - std::max(x - radius, 0) + 1;
+                        uint32_t rank = (columns * rows - 1) / 2;
+
+                        int k = 0;
+                        while (coarse[k] <= rank) {
+                            rank -= coarse[k];
+                            k++;
+                        }
+
+                        // Bring the fine bins of bucket k up to date with the window at x
+                        uint32_t *segment = &fine[k * COARSE];
+
+                        if (fineX[k] < 0 || x - fineX[k] > 2 * radius + 1) {
+                            std::fill(segment, segment + COARSE, 0);
+
+                            for (int j = std::max(x - radius, 0); j <= std::min(x + radius, width - 1); j++) {
+                                accumulate<COARSE>(segment, &columnFine[j * FINE + k * COARSE], 1);
+                            }
+                        } else {
+                            for (int j = fineX[k] + 1; j <= x; j++) {
+                                if (j + radius < width) {
+                                    accumulate<COARSE>(segment, &columnFine[(j + radius) * FINE + k * COARSE], 1);
+                                }
+                                if (j - radius - 1 >= 0) {
+                                    accumulate<COARSE>(segment, &columnFine[(j - radius - 1) * FINE + k * COARSE],
+                                                       -1);
+                                }
+                            }
+                        }
+
+                        fineX[k] = x;
+
+                        int f = 0;
+                        while (segment[f] <= rank) {
+                            rank -= segment[f];
+                            f++;
+                        }
+
+                        out[y * stride + x * channels + c] = k * COARSE + f;
+                    }
+                }
+            }
+        }
+
+        MedianFilter::MedianFilter(int _radius) {
+            setRadius(_radius);
+        }
+
+        int MedianFilter::getRadius() const {
+            return radius;
+        }
+
+        void MedianFilter::setRadius(int _radius) {
+            if (_radius < 0) {
+                throw std::invalid_argument("Median radius must be nonnegative.");
+            }
+
+            radius = _radius;
+        }
+
+        template<typename T>
+        void MedianFilter::filter(Pixmap<T> &map) const {
+            constexpr int C = ChannelTraits<T>::count;
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+
+            if (map.getArea() == 0 || radius == 0) return;
+
+            std::vector<uint8_t> in = loadChannels<uint8_t>(map);
+            std::vector<uint8_t> out(in.size());
+
+            int bands = std::max(std::min<int>(Parallel::threadCount(), height / MIN_BAND), 1);
+
+            Parallel::parallelFor(0, bands, [&](int band) {
+                int y1 = static_cast<long>(height) * band / bands;
+                int y2 = static_cast<long>(height) * (band + 1) / bands;
+
+                std::vector<uint16_t> columnCoarse, columnFine;
+
+                for (int c = 0; c < C; c++) {
+                    medianBand(in, out, width, height, C, c, radius, y1, y2, columnCoarse, columnFine);
+                }
+            });
+
+            storeChannels(map, out);
+        }
+
+        void MedianFilter::applyTo(Bitmap &map) {
+            filter(map);
+        }
+
+        void MedianFilter::applyTo(Graymap &map) {
+            filter(map);
+        }
+
+        void MedianFilter::applyTo(RGBMap &map) {
+            filter(map);
+        }
+
+        void MedianFilter::applyTo(RGBAMap &map) {
+            filter(map);
+        }
+    }
+}
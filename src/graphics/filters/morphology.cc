@@ -0,0 +1,479 @@
+#include "morphology.h"
+#include "channels.h"
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            /*
+             * Number of bytes per column block of vertical passes on channels.
+             */
+            const int BYTE_BLOCK = 1024;
+
+            /*
+             * Number of words per column block of vertical passes on packed Bitmaps.
+             */
+            const int WORD_BLOCK = 16;
+
+            struct MaxOp {
+                uint8_t operator()(uint8_t a, uint8_t b) const {
+                    return std::max(a, b);
+                }
+            };
+
+            struct MinOp {
+                uint8_t operator()(uint8_t a, uint8_t b) const {
+                    return std::min(a, b);
+                }
+            };
+
+            struct OrOp {
+                uint64_t operator()(uint64_t a, uint64_t b) const {
+                    return a | b;
+                }
+            };
+
+            struct AndOp {
+                uint64_t operator()(uint64_t a, uint64_t b) const {
+                    return a & b;
+                }
+            };
+
+            /**
+             * van Herk / Gil-Werman filter over a window of 2 * radius + 1 items, in place.
+             *
+             * The sequence is padded with the neutral value and cut into blocks the size of the window; g holds
+             * running results from the start of each block and h from its end, so every window is covered by one h
+             * and one g value.
+             * @tparam V Value type.
+             * @tparam Op Associative, idempotent operation with the neutral value as identity.
+             * @param data First value of the first item.
+             * @param n Number of items.
+             * @param stride Distance between items.
+             * @param m Number of contiguous values per item.
+             * @param g Scratch space.
+             * @param h Scratch space.
+             */
+            template<typename V, typename Op>
+            void vanHerk(V *data, int n, size_t stride, int m, int radius, V neutral, Op op,
+                         std::vector<V> &g, std::vector<V> &h) {
+                int window = 2 * radius + 1;
+                int padded = (n + 2 * radius + window - 1) / window * window;
+
+                g.resize(static_cast<size_t>(padded) * m);
+                h.resize(static_cast<size_t>(padded) * m);
+
+                auto item = [&](int i) -> const V * {
+                    return (i >= radius && i < radius + n) ? data + (i - radius) * stride : nullptr;
+                };
+
+                for (int i = 0; i < padded; i++) {
+                    const V *in = item(i);
+                    V *out = &g[static_cast<size_t>(i) * m];
+
+                    if (i % window == 0) {
+                        for (int j = 0; j < m; j++) out[j] = in ? in[j] : neutral;
+                    } else if (in) {
+                        for (int j = 0; j < m; j++) out[j] = op(out[j - m], in[j]);
+                    } else {
+                        std::copy_n(out - m, m, out);
+                    }
+                }
+
+                for (int i = padded - 1; i >= 0; i--) {
+                    const V *in = item(i);
+                    V *out = &h[static_cast<size_t>(i) * m];
+
+                    if (i % window == window - 1) {
+                        for (int j = 0; j < m; j++) out[j] = in ? in[j] : neutral;
+                    } else if (in) {
+                        for (int j = 0; j < m; j++) out[j] = op(out[j + m], in[j]);
+                    } else {
+                        std::copy_n(out + m, m, out);
+                    }
+                }
+
+                for (int x = 0; x < n; x++) {
+                    V *out = data + x * stride;
+                    const V *left = &h[static_cast<size_t>(x) * m];
+                    const V *right = &g[static_cast<size_t>(x + 2 * radius) * m];
+
+                    for (int j = 0; j < m; j++) out[j] = op(left[j], right[j]);
+                }
+            }
+
+            /**
+             * Runs van Herk / Gil-Werman down every column of rows of stride values, in blocks of columns.
+             */
+            template<typename V, typename Op>
+            void columnPass(std::vector<V> &data, size_t stride, int height, int radius, int block, V neutral,
+                            Op op) {
+                int blocks = (stride + block - 1) / block;
+
+                Parallel::parallelFor(0, blocks, [&](int b) {
+                    size_t i1 = static_cast<size_t>(b) * block;
+                    int m = std::min<size_t>(block, stride - i1);
+                    std::vector<V> g, h;
+
+                    vanHerk(&data[i1], height, stride, m, radius, neutral, op, g, h);
+                });
+            }
+
+            template<typename Op>
+            void erodeOrDilateBytes(std::vector<uint8_t> &data, int width, int height, int channels,
+                                    const StructuringElement &element, uint8_t neutral, Op op) {
+                size_t stride = static_cast<size_t>(width) * channels;
+
+                if (element.isDiagonal()) {
+                    bool anti = element.getDiagonalDirection() == LineDirection::ANTIDIAGONAL;
+                    int radius = element.getDiagonalRadius();
+
+                    // Line k holds the pixels with x - y (or x + y for antidiagonals) equal to k - (height - 1)
+                    Parallel::parallelBands(0, width + height - 1, [&](int k1, int k2) {
+                        std::vector<uint8_t> line, g, h;
+
+                        for (int k = k1; k < k2; k++) {
+                            int x0, y0, length, dx;
+
+                            if (anti) {
+                                y0 = std::max(0, k - (width - 1));
+                                x0 = k - y0;
+                                length = std::min(x0 + 1, height - y0);
+                                dx = -1;
+                            } else {
+                                int d = k - (height - 1);
+                                x0 = std::max(d, 0);
+                                y0 = x0 - d;
+                                length = std::min(width - x0, height - y0);
+                                dx = 1;
+                            }
+
+                            line.resize(static_cast<size_t>(length) * channels);
+
+                            for (int t = 0; t < length; t++) {
+                                std::copy_n(&data[(y0 + t) * stride + (x0 + dx * t) * channels], channels,
+                                            &line[t * channels]);
+                            }
+
+                            vanHerk(line.data(), length, channels, channels, radius, neutral, op, g, h);
+
+                            for (int t = 0; t < length; t++) {
+                                std::copy_n(&line[t * channels], channels,
+                                            &data[(y0 + t) * stride + (x0 + dx * t) * channels]);
+                            }
+                        }
+                    });
+
+                    return;
+                }
+
+                if (element.getRadiusX() > 0) {
+                    Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                        std::vector<uint8_t> g, h;
+
+                        for (int y = y1; y < y2; y++) {
+                            vanHerk(&data[y * stride], width, channels, channels, element.getRadiusX(), neutral,
+                                    op, g, h);
+                        }
+                    });
+                }
+
+                if (element.getRadiusY() > 0) {
+                    columnPass(data, stride, height, element.getRadiusY(), BYTE_BLOCK, neutral, op);
+                }
+            }
+
+            void erodeOrDilateBytes(std::vector<uint8_t> &data, int width, int height, int channels,
+                                    const StructuringElement &element, bool dilate) {
+                if (dilate) {
+                    erodeOrDilateBytes(data, width, height, channels, element, 0, MaxOp());
+                } else {
+                    erodeOrDilateBytes(data, width, height, channels, element, 255, MinOp());
+                }
+            }
+
+            /**
+             * Reads a row of packed bits displaced by offset pixels, so out[x] = row[x + offset], filling
+             * pixels beyond the row with fill.
+             */
+            void shiftBits(const uint64_t *row, uint64_t *out, int words, int offset, uint64_t fill) {
+                int q = std::abs(offset) / 64;
+                int b = std::abs(offset) % 64;
+
+                auto get = [&](int k) {
+                    return (k >= 0 && k < words) ? row[k] : fill;
+                };
+
+                for (int k = 0; k < words; k++) {
+                    if (offset >= 0) {
+                        out[k] = b ? (get(k + q) >> b) | (get(k + q + 1) << (64 - b)) : get(k + q);
+                    } else {
+                        out[k] = b ? (get(k - q) << b) | (get(k - q - 1) >> (64 - b)) : get(k - q);
+                    }
+                }
+            }
+
+            /**
+             * Combines each pixel of a packed row with its neighbours up to radius pixels away, by doubling the
+             * covered span with shifted copies first towards the end of the row, then towards its start.
+             */
+            template<typename Op>
+            void spreadBits(uint64_t *row, int words, int radius, uint64_t fill, Op op, std::vector<uint64_t> &tmp) {
+                tmp.resize(words);
+
+                for (int direction : {1, -1}) {
+                    for (int span = 1; span < radius + 1;) {
+                        int step = std::min(span, radius + 1 - span);
+
+                        shiftBits(row, tmp.data(), words, direction * step, fill);
+                        for (int k = 0; k < words; k++) row[k] = op(row[k], tmp[k]);
+
+                        span += step;
+                    }
+                }
+            }
+
+            template<typename Op>
+            void erodeOrDilateBits(std::vector<uint64_t> &bits, int width, int height,
+                                   const StructuringElement &element, uint64_t fill, Op op) {
+                int words = (width + 63) / 64;
+                int tail = width % 64;
+
+                if (element.getRadiusX() > 0) {
+                    Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                        std::vector<uint64_t> tmp;
+
+                        for (int y = y1; y < y2; y++) {
+                            uint64_t *row = &bits[static_cast<size_t>(y) * words];
+
+                            // Padding bits past the width must be neutral
+                            if (tail) {
+                                uint64_t mask = ~0ULL << tail;
+                                row[words - 1] = (row[words - 1] & ~mask) | (fill & mask);
+                            }
+
+                            spreadBits(row, words, element.getRadiusX(), fill, op, tmp);
+                        }
+                    });
+                }
+
+                if (element.getRadiusY() > 0) {
+                    columnPass(bits, words, height, element.getRadiusY(), WORD_BLOCK, fill, op);
+                }
+            }
+
+            void erodeOrDilateBits(std::vector<uint64_t> &bits, int width, int height,
+                                   const StructuringElement &element, bool dilate) {
+                if (dilate) {
+                    erodeOrDilateBits(bits, width, height, element, 0, OrOp());
+                } else {
+                    erodeOrDilateBits(bits, width, height, element, ~0ULL, AndOp());
+                }
+            }
+
+            /**
+             * Performs an operation given erosion or dilation in place, and the difference of two results.
+             */
+            template<typename V, typename Step, typename Difference>
+            void compose(std::vector<V> &data, MorphologyOp op, Step step, Difference difference) {
+                switch (op) {
+                    case MorphologyOp::DILATE:
+                        step(data, true);
+                        break;
+                    case MorphologyOp::ERODE:
+                        step(data, false);
+                        break;
+                    case MorphologyOp::OPEN:
+                        step(data, false);
+                        step(data, true);
+                        break;
+                    case MorphologyOp::CLOSE:
+                        step(data, true);
+                        step(data, false);
+                        break;
+                    case MorphologyOp::GRADIENT: {
+                        std::vector<V> eroded = data;
+
+                        step(data, true);
+                        step(eroded, false);
+
+                        for (size_t i = 0; i < data.size(); i++) {
+                            data[i] = difference(data[i], eroded[i]);
+                        }
+                        break;
+                    }
+                }
+            }
+
+            void checkRadius(int radius) {
+                if (radius < 0) {
+                    throw std::invalid_argument("Structuring element radius must be non-negative.");
+                }
+            }
+        }
+
+        StructuringElement StructuringElement::rectangle(int radiusX, int radiusY) {
+            checkRadius(radiusX);
+            checkRadius(radiusY);
+
+            StructuringElement ret;
+            ret.radiusX = radiusX;
+            ret.radiusY = radiusY;
+
+            return ret;
+        }
+
+        StructuringElement StructuringElement::line(int radius, LineDirection direction) {
+            checkRadius(radius);
+
+            switch (direction) {
+                case LineDirection::HORIZONTAL:
+                    return rectangle(radius, 0);
+                case LineDirection::VERTICAL:
+                    return rectangle(0, radius);
+                default:
+                    break;
+            }
+
+            StructuringElement ret;
+            ret.radius = radius;
+            ret.direction = direction;
+            ret.diagonal = true;
+
+            return ret;
+        }
+
+        int StructuringElement::getRadiusX() const {
+            return radiusX;
+        }
+
+        int StructuringElement::getRadiusY() const {
+            return radiusY;
+        }
+
+        bool StructuringElement::isDiagonal() const {
+            return diagonal;
+        }
+
+        int StructuringElement::getDiagonalRadius() const {
+            return radius;
+        }
+
+        LineDirection StructuringElement::getDiagonalDirection() const {
+            return direction;
+        }
+
+        Morphology::Morphology(MorphologyOp _op, StructuringElement _element) : op(_op), element(_element) {
+        }
+
+        MorphologyOp Morphology::getOp() const {
+            return op;
+        }
+
+        const StructuringElement &Morphology::getElement() const {
+            return element;
+        }
+
+        template<typename T>
+        void Morphology::morph(Pixmap<T> &map) const {
+            constexpr int C = ChannelTraits<T>::count;
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+
+            if (map.getArea() == 0) return;
+
+            std::vector<uint8_t> data = loadChannels<uint8_t>(map);
+
+            compose(data, op, [&](std::vector<uint8_t> &d, bool dilate) {
+                erodeOrDilateBytes(d, width, height, C, element, dilate);
+            }, [](uint8_t a, uint8_t b) {
+                return static_cast<uint8_t>(a - b);
+            });
+
+            storeChannels(map, data);
+        }
+
+        void Morphology::applyTo(Bitmap &map) {
+            if (element.isDiagonal()) {
+                morph(map);
+                return;
+            }
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+            int words = (width + 63) / 64;
+
+            if (map.getArea() == 0) return;
+
+            std::vector<uint64_t> bits(static_cast<size_t>(words) * height);
+            bool *pixels = map.getPixels();
+
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                for (int y = y1; y < y2; y++) {
+                    for (int x = 0; x < width; x++) {
+                        bits[static_cast<size_t>(y) * words + x / 64] |= uint64_t(pixels[y * width + x]) << (x % 64);
+                    }
+                }
+            });
+
+            compose(bits, op, [&](std::vector<uint64_t> &b, bool dilate) {
+                erodeOrDilateBits(b, width, height, element, dilate);
+            }, [](uint64_t a, uint64_t b) {
+                return a & ~b;
+            });
+
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                for (int y = y1; y < y2; y++) {
+                    for (int x = 0; x < width; x++) {
+                        pixels[y * width + x] = (bits[static_cast<size_t>(y) * words + x / 64] >> (x % 64)) & 1;
+                    }
+                }
+            });
+        }
+
+        void Morphology::applyTo(Graymap &map) {
+            morph(map);
+        }
+
+        void Morphology::applyTo(RGBMap &map) {
+            morph(map);
+        }
+
+        void Morphology::applyTo(RGBAMap &map) {
+            morph(map);
+        }
+
+        Dilate::Dilate(StructuringElement element) : Morphology(MorphologyOp::DILATE, element) {
+        }
+
+        Dilate::Dilate(int radiusX, int radiusY) : Dilate(StructuringElement::rectangle(radiusX, radiusY)) {
+        }
+
+        Erode::Erode(StructuringElement element) : Morphology(MorphologyOp::ERODE, element) {
+        }
+
+        Erode::Erode(int radiusX, int radiusY) : Erode(StructuringElement::rectangle(radiusX, radiusY)) {
+        }
+
+        Open::Open(StructuringElement element) : Morphology(MorphologyOp::OPEN, element) {
+        }
+
+        Open::Open(int radiusX, int radiusY) : Open(StructuringElement::rectangle(radiusX, radiusY)) {
+        }
+
+        Close::Close(StructuringElement element) : Morphology(MorphologyOp::CLOSE, element) {
+        }
+
+        Close::Close(int radiusX, int radiusY) : Close(StructuringElement::rectangle(radiusX, radiusY)) {
+        }
+
+        MorphologicalGradient::MorphologicalGradient(StructuringElement element)
+                : Morphology(MorphologyOp::GRADIENT, element) {
+        }
+
+        MorphologicalGradient::MorphologicalGradient(int radiusX, int radiusY)
+                : MorphologicalGradient(StructuringElement::rectangle(radiusX, radiusY)) {
+        }
+    }
+}
@@ -0,0 +1,249 @@
+#include "pipeline.h"
+#include "channels.h"
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        namespace {
+            /*
+             * Approximate size in bytes of the buffer of one stage for one strip.
+             */
+            const size_t STRIP_BYTES = 256 * 1024;
+
+            /*
+             * Minimum strip height, in multiples of the halo the stages add up to. Each strip recomputes up to twice
+             * the halo on top of its own rows, so this caps that overhead at a quarter.
+             */
+            const int MIN_HALO_STRIPS = 8;
+
+            /**
+             * A stage which is not pointwise, with the pointwise stages fused after it. The first unit of a run has
+             * no stage; it loads the source rows.
+             */
+            struct Unit {
+                const PipelineStage *stage = nullptr;
+                std::vector<const PipelineStage *> pointwise;
+            };
+
+            void applyPointwise(const Unit &unit, float *rows, size_t pixels, int channels) {
+                if (unit.pointwise.empty()) return;
+
+                for (size_t i = 0; i < pixels; i++) {
+                    for (const PipelineStage *stage : unit.pointwise) {
+                        stage->applyPixel(rows + i * channels, channels);
+                    }
+                }
+            }
+        }
+
+        bool PipelineStage::isPointwise() const {
+            return false;
+        }
+
+        int PipelineStage::halo() const {
+            return 0;
+        }
+
+        std::pair<int, int> PipelineStage::inputRows(int y1, int y2, int height) const {
+            return {std::max(y1 - halo(), 0), std::min(y2 + halo(), height)};
+        }
+
+        void PipelineStage::applyPixel(float *, int) const {
+        }
+
+        void PipelineStage::processRows(const std::function<const float *(int)> &input, int y1, int y2, int width,
+                                        int, int channels, float *out) const {
+            size_t stride = static_cast<size_t>(width) * channels;
+
+            for (int y = y1; y < y2; y++) {
+                std::copy_n(input(y), stride, out + (y - y1) * stride);
+            }
+        }
+
+        PointwiseStage::PointwiseStage(std::function<void(float *, int)> _func) : func(std::move(_func)) {
+        }
+
+        bool PointwiseStage::isPointwise() const {
+            return true;
+        }
+
+        void PointwiseStage::applyPixel(float *pixel, int channels) const {
+            func(pixel, channels);
+        }
+
+        ConvolutionStage::ConvolutionStage(std::vector<float> _horizontal, std::vector<float> _vertical,
+                                           EdgeMode _edge) : horizontal(std::move(_horizontal)),
+                                                             vertical(std::move(_vertical)), edge(_edge) {
+            if (horizontal.size() % 2 == 0 || vertical.size() % 2 == 0) {
+                throw std::invalid_argument("Convolution kernels must have odd length.");
+            }
+        }
+
+        int ConvolutionStage::halo() const {
+            return vertical.size() / 2;
+        }
+
+        std::pair<int, int> ConvolutionStage::inputRows(int y1, int y2, int height) const {
+            // Wrapping reads rows from the opposite side of the image
+            if (edge == EdgeMode::WRAP && (y1 - halo() < 0 || y2 + halo() > height)) {
+                return {0, height};
+            }
+
+            return PipelineStage::inputRows(y1, y2, height);
+        }
+
+        void ConvolutionStage::processRows(const std::function<const float *(int)> &input, int y1, int y2, int width,
+                                           int height, int channels, float *out) const {
+            convolveSeparableRows(input, y1, y2, width, height, channels, horizontal, vertical, edge, out);
+        }
+
+        FilterPipeline &FilterPipeline::add(std::shared_ptr<PipelineStage> stage) {
+            entries.push_back({std::move(stage), nullptr});
+            return *this;
+        }
+
+        FilterPipeline &FilterPipeline::add(std::shared_ptr<Filter> filter) {
+            entries.push_back({nullptr, std::move(filter)});
+            return *this;
+        }
+
+        FilterPipeline &FilterPipeline::addPointwise(std::function<void(float *, int)> func) {
+            return add(std::make_shared<PointwiseStage>(std::move(func)));
+        }
+
+        FilterPipeline &FilterPipeline::addConvolution(std::vector<float> horizontal, std::vector<float> vertical,
+                                                       EdgeMode edge) {
+            return add(std::make_shared<ConvolutionStage>(std::move(horizontal), std::move(vertical), edge));
+        }
+
+        size_t FilterPipeline::size() const {
+            return entries.size();
+        }
+
+        template<typename T>
+        void FilterPipeline::stream(Pixmap<T> &map, const std::vector<std::shared_ptr<PipelineStage>> &stages) {
+            constexpr int C = ChannelTraits<T>::count;
+
+            int width = map.getWidth();
+            int height = map.getHeight();
+            size_t stride = static_cast<size_t>(width) * C;
+
+            std::vector<Unit> units(1);
+
+            for (const auto &stage : stages) {
+                if (stage->isPointwise()) {
+                    units.back().pointwise.push_back(stage.get());
+                } else {
+                    units.emplace_back();
+                    units.back().stage = stage.get();
+                }
+            }
+
+            // Rows recomputed above and below every strip, through all the stages
+            int halo = 0;
+
+            for (const Unit &unit : units) {
+                if (unit.stage) halo += unit.stage->halo();
+            }
+
+            int stripRows = std::max<int>(STRIP_BYTES / (stride * sizeof(float)), 1);
+
+            // Wide images would get strips not much taller than their halo, recomputing it many times over
+            if (halo > 0) {
+                stripRows = std::max((stripRows + halo - 1) / halo, MIN_HALO_STRIPS) * halo;
+            }
+            int strips = (height + stripRows - 1) / stripRows;
+
+            // Strips read from the source and write to a separate result, so they never see each other's output
+            Pixmap<T> result(width, height);
+            const T *source = map.getPixels();
+            T *dest = result.getPixels();
+
+            Parallel::parallelFor(0, strips, [&](int strip) {
+                int y1 = strip * stripRows;
+                int y2 = std::min(y1 + stripRows, height);
+
+                // Work backwards to find the rows each unit must produce
+                std::vector<std::pair<int, int>> ranges(units.size());
+                ranges.back() = {y1, y2};
+
+                for (size_t u = units.size() - 1; u > 0; u--) {
+                    ranges[u - 1] = units[u].stage->inputRows(ranges[u].first, ranges[u].second, height);
+                }
+
+                std::vector<std::vector<float>> buffers(units.size());
+
+                for (size_t u = 0; u < units.size(); u++) {
+                    auto[lo, hi] = ranges[u];
+                    buffers[u].resize((hi - lo) * stride);
+
+                    if (u == 0) {
+                        for (size_t i = 0; i < buffers[0].size() / C; i++) {
+                            ChannelTraits<T>::load(source[lo * static_cast<size_t>(width) + i], &buffers[0][i * C]);
+                        }
+                    } else {
+                        const std::vector<float> &previous = buffers[u - 1];
+                        int previousLo = ranges[u - 1].first;
+
+                        units[u].stage->processRows([&](int y) {
+                            return &previous[(y - previousLo) * stride];
+                        }, lo, hi, width, height, C, buffers[u].data());
+
+                        buffers[u - 1].clear(); // No longer needed, free it while the remaining units run
+                        buffers[u - 1].shrink_to_fit();
+                    }
+
+                    applyPointwise(units[u], buffers[u].data(), (hi - lo) * static_cast<size_t>(width), C);
+                }
+
+                const std::vector<float> &last = buffers.back();
+
+                for (size_t i = 0; i < last.size() / C; i++) {
+                    dest[y1 * static_cast<size_t>(width) + i] = ChannelTraits<T>::store(&last[i * C]);
+                }
+            });
+
+            std::copy(dest, dest + result.getArea(), map.getPixels());
+        }
+
+        template<typename T>
+        void FilterPipeline::run(Pixmap<T> &map) {
+            if (map.getArea() == 0) return;
+
+            std::vector<std::shared_ptr<PipelineStage>> stages;
+
+            for (const Entry &entry : entries) {
+                if (entry.stage) {
+                    stages.push_back(entry.stage);
+                } else {
+                    if (!stages.empty()) {
+                        stream(map, stages);
+                        stages.clear();
+                    }
+
+                    entry.filter->applyTo(map);
+                }
+            }
+
+            if (!stages.empty()) {
+                stream(map, stages);
+            }
+        }
+
+        void FilterPipeline::applyTo(Bitmap &map) {
+            run(map);
+        }
+
+        void FilterPipeline::applyTo(Graymap &map) {
+            run(map);
+        }
+
+        void FilterPipeline::applyTo(RGBMap &map) {
+            run(map);
+        }
+
+        void FilterPipeline::applyTo(RGBAMap &map) {
+            run(map);
+        }
+    }
+}
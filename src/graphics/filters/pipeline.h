@@ -0,0 +1,190 @@
+#ifndef PIPELINE_DEFINED_
+#define PIPELINE_DEFINED_
+
+#include "filter.h"
+#include "convolution.h"
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Sine::Graphics {
+    namespace Filters {
+        /**
+         * One step of a FilterPipeline, working on rows of interleaved float channels on a 0 - 255 scale (1 channel
+         * for Bitmaps and Graymaps, 3 for RGBMaps, 4 for RGBAMaps).
+         */
+        class PipelineStage {
+        public:
+            virtual ~PipelineStage() = default;
+
+            /**
+             * Whether each output pixel depends only on the same input pixel. Pointwise stages are fused into the
+             * stage before them and never get a buffer of their own.
+             * @return Whether the stage is pointwise.
+             */
+            virtual bool isPointwise() const;
+
+            /**
+             * Number of input rows needed above and below each output row.
+             * @return Halo in rows.
+             */
+            virtual int halo() const;
+
+            /**
+             * Input rows needed to compute output rows [y1, y2).
+             * @param y1 First output row.
+             * @param y2 One past the last output row.
+             * @param height Image height.
+             * @return Half-open input row range, within [0, height).
+             */
+            virtual std::pair<int, int> inputRows(int y1, int y2, int height) const;
+
+            /**
+             * Transforms one pixel in place; called for pointwise stages.
+             * @param pixel Channels of the pixel.
+             * @param channels Number of channels.
+             */
+            virtual void applyPixel(float *pixel, int channels) const;
+
+            /**
+             * Computes output rows [y1, y2); called for stages which are not pointwise.
+             * @param input Returns a pointer to input row y, for every y in inputRows(y1, y2, height).
+             * @param y1 First output row.
+             * @param y2 One past the last output row.
+             * @param width Image width.
+             * @param height Image height.
+             * @param channels Number of channels.
+             * @param out Output rows, (y2 - y1) * width * channels floats.
+             */
+            virtual void processRows(const std::function<const float *(int)> &input, int y1, int y2, int width,
+                                     int height, int channels, float *out) const;
+        };
+
+        /**
+         * Pointwise stage calling a functor on every pixel.
+         */
+        class PointwiseStage : public PipelineStage {
+        private:
+            std::function<void(float *, int)> func;
+
+        public:
+            /**
+             * Constructor.
+             * @param func Functor called as func(pixel, channels), modifying the channels in place.
+             */
+            explicit PointwiseStage(std::function<void(float *, int)> func);
+
+            bool isPointwise() const override;
+
+            void applyPixel(float *pixel, int channels) const override;
+        };
+
+        /**
+         * Stage convolving with a separable kernel, like SeparableConvolution in float precision.
+         */
+        class ConvolutionStage : public PipelineStage {
+        private:
+            std::vector<float> horizontal;
+            std::vector<float> vertical;
+            EdgeMode edge;
+
+        public:
+            /**
+             * Constructor.
+             * @param horizontal Horizontal kernel of odd length.
+             * @param vertical Vertical kernel of odd length.
+             * @param edge Edge mode.
+             */
+            ConvolutionStage(std::vector<float> horizontal, std::vector<float> vertical,
+                             EdgeMode edge = EdgeMode::CLAMP);
+
+            int halo() const override;
+
+            std::pair<int, int> inputRows(int y1, int y2, int height) const override;
+
+            void processRows(const std::function<const float *(int)> &input, int y1, int y2, int width, int height,
+                             int channels, float *out) const override;
+        };
+
+        /**
+         * Chain of filters evaluated in one streaming pass.
+         *
+         * The image is cut into strips of rows sized to stay in cache, which are processed in parallel. Each strip is
+         * pushed through every stage, so intermediates only ever exist for one strip at a time. Rows a stage needs
+         * above and below its strip (its halo) are recomputed by the stages before it instead of being shared between
+         * strips, so strips are also made at least several times as tall as the total halo. Runs of pointwise stages
+         * are applied to the buffer of the preceding stage. Plain Filters can be added too; they run on the whole image
+         * and split the pipeline into separately streamed parts.
+         */
+        class FilterPipeline : public Filter {
+        private:
+            /**
+             * Either a streamed stage or a whole-image filter.
+             */
+            struct Entry {
+                std::shared_ptr<PipelineStage> stage;
+                std::shared_ptr<Filter> filter;
+            };
+
+            std::vector<Entry> entries;
+
+            template<typename T>
+            void run(Pixmap<T> &map);
+
+            /**
+             * Streams a run of stages over a map.
+             */
+            template<typename T>
+            void stream(Pixmap<T> &map, const std::vector<std::shared_ptr<PipelineStage>> &stages);
+
+        public:
+            /**
+             * Appends a stage.
+             * @param stage Stage instance.
+             * @return Reference to *this.
+             */
+            FilterPipeline &add(std::shared_ptr<PipelineStage> stage);
+
+            /**
+             * Appends a filter which runs on the whole image.
+             * @param filter Filter instance.
+             * @return Reference to *this.
+             */
+            FilterPipeline &add(std::shared_ptr<Filter> filter);
+
+            /**
+             * Appends a PointwiseStage.
+             * @param func Functor called as func(pixel, channels).
+             * @return Reference to *this.
+             */
+            FilterPipeline &addPointwise(std::function<void(float *, int)> func);
+
+            /**
+             * Appends a ConvolutionStage.
+             * @param horizontal Horizontal kernel of odd length.
+             * @param vertical Vertical kernel of odd length.
+             * @param edge Edge mode.
+             * @return Reference to *this.
+             */
+            FilterPipeline &addConvolution(std::vector<float> horizontal, std::vector<float> vertical,
+                                           EdgeMode edge = EdgeMode::CLAMP);
+
+            /**
+             * Number of stages and filters.
+             * @return Entry count.
+             */
+            size_t size() const;
+
+            void applyTo(Bitmap &map) override;
+
+            void applyTo(Graymap &map) override;
+
+            void applyTo(RGBMap &map) override;
+
+            void applyTo(RGBAMap &map) override;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,293 @@
+#include "gradient.h"
+#include "parallel.h"
+#include "filters/channels.h"
+#include "simd/kernels.h"
+#include "math/mathutils.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace {
+        /**
+         * Converts a row of an image to luma, padded with a copy of the border pixel at either end.
+         */
+        template<typename T>
+        void loadRow(const Pixmap<T> &image, int y, float *row) {
+            constexpr int C = Filters::ChannelTraits<T>::count;
+
+            int width = image.getWidth();
+            const T *pixels = image.getPixels() + static_cast<size_t>(std::min(std::max(y, 0),
+                                                                                image.getHeight() - 1)) * width;
+            float c[C];
+
+            for (int x = 0; x < width; x++) {
+                Filters::ChannelTraits<T>::load(pixels[x], c);
+                row[x + 1] = C >= 3 ? 0.299f * c[0] + 0.587f * c[1] + 0.114f * c[2] : c[0];
+            }
+
+            row[0] = row[1];
+            row[width + 1] = row[width];
+        }
+
+        /**
+         * Runs a 3x3 stencil over every row of an image in parallel bands. Each band keeps the rows above, at and
+         * below the current one in a ring, converting one new row per step.
+         * @param func Functor called as func(above, row, below, y), where pixel x of each row is at index x + 1.
+         */
+        template<typename T, typename Func>
+        void stencil(const Pixmap<T> &image, Func func) {
+            int width = image.getWidth();
+
+            Parallel::parallelBands(0, image.getHeight(), [&](int y1, int y2) {
+                std::vector<float> ring(3 * static_cast<size_t>(width + 2));
+                float *rows[3] = {&ring[0], &ring[width + 2], &ring[2 * static_cast<size_t>(width + 2)]};
+
+                loadRow(image, y1 - 1, rows[0]);
+                loadRow(image, y1, rows[1]);
+
+                for (int y = y1; y < y2; y++) {
+                    loadRow(image, y + 1, rows[2]);
+                    func(rows[0], rows[1], rows[2], y);
+
+                    std::swap(rows[0], rows[1]);
+                    std::swap(rows[1], rows[2]);
+                }
+            });
+        }
+    }
+
+    Gradient::Gradient(int _width, int _height)
+            : width(_width), height(_height), dx(static_cast<size_t>(_width) * _height),
+              dy(static_cast<size_t>(_width) * _height) {
+    }
+
+    template<typename T>
+    Gradient Gradient::of(const Pixmap<T> &image, GradientOperator op) {
+        Gradient ret(image.getWidth(), image.getHeight());
+
+        if (image.getArea() == 0) return ret;
+
+        // Outer and center weights across the derivative, and the normalization to levels per pixel
+        float outer = op == GradientOperator::SOBEL ? 1 : 3;
+        float center = op == GradientOperator::SOBEL ? 2 : 10;
+        float norm = 1 / (2 * (2 * outer + center));
+
+        int width = ret.width;
+        float a = outer * norm, b = center * norm;
+
+        const Simd::PixelKernels &kernels = Simd::pixelKernels();
+
+        stencil(image, [&](const float *above, const float *row, const float *below, int y) {
+            float *gx = &ret.dx[static_cast<size_t>(y) * width];
+            float *gy = &ret.dy[static_cast<size_t>(y) * width];
+
+            // Across the columns for x, and across the rows for y
+            kernels.derivative(gx, above + 2, above, row + 2, row, below + 2, below, a, b, width);
+            kernels.derivative(gy, below, above, below + 1, above + 1, below + 2, above + 2, a, b, width);
+        });
+
+        return ret;
+    }
+
+    template<typename T>
+    Graymap Gradient::laplacian(const Pixmap<T> &image, float scale) {
+        Graymap ret(image.getWidth(), image.getHeight());
+
+        if (image.getArea() == 0) return ret;
+
+        int width = image.getWidth();
+
+        stencil(image, [&](const float *above, const float *row, const float *below, int y) {
+            uint8_t *out = ret.getPixels() + static_cast<size_t>(y) * width;
+
+            for (int x = 0; x < width; x++) {
+                float response = above[x + 1] + below[x + 1] + row[x] + row[x + 2] - 4 * row[x + 1];
+                out[x] = Filters::toByte(std::abs(response) * scale);
+            }
+        });
+
+        return ret;
+    }
+
+    template<typename T>
+    Bitmap Gradient::canny(const Pixmap<T> &image, float low, float high) {
+        return of(image).edges(low, high);
+    }
+
+    int Gradient::getWidth() const {
+        return width;
+    }
+
+    int Gradient::getHeight() const {
+        return height;
+    }
+
+    float Gradient::getX(int x, int y) const {
+        return dx[static_cast<size_t>(y) * width + x];
+    }
+
+    float Gradient::getY(int x, int y) const {
+        return dy[static_cast<size_t>(y) * width + x];
+    }
+
+    float Gradient::magnitude(int x, int y) const {
+        return std::hypot(getX(x, y), getY(x, y));
+    }
+
+    float Gradient::direction(int x, int y) const {
+        return std::atan2(getY(x, y), getX(x, y));
+    }
+
+    std::vector<float> Gradient::magnitudes() const {
+        std::vector<float> ret(dx.size());
+
+        Parallel::parallelBands(0, ret.size(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) ret[i] = std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+        });
+
+        return ret;
+    }
+
+    std::vector<float> Gradient::directions() const {
+        std::vector<float> ret(dx.size());
+
+        Parallel::parallelBands(0, ret.size(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) ret[i] = std::atan2(dy[i], dx[i]);
+        });
+
+        return ret;
+    }
+
+    Graymap Gradient::magnitudeMap(float scale) const {
+        Graymap ret(width, height);
+        uint8_t *out = ret.getPixels();
+
+        Parallel::parallelBands(0, ret.getArea(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) out[i] = Filters::toByte(std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]) * scale);
+        });
+
+        return ret;
+    }
+
+    Graymap Gradient::directionMap() const {
+        Graymap ret(width, height);
+        uint8_t *out = ret.getPixels();
+
+        Parallel::parallelBands(0, ret.getArea(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) {
+                out[i] = Filters::toByte((std::atan2(dy[i], dx[i]) + static_cast<float>(Math::MathUtils::PI))
+                                         * static_cast<float>(255 / (2 * Math::MathUtils::PI)));
+            }
+        });
+
+        return ret;
+    }
+
+    Bitmap Gradient::edges(float low, float high) const {
+        if (!(low <= high)) {
+            throw std::invalid_argument("Canny low threshold must not exceed the high threshold.");
+        }
+
+        Bitmap ret(width, height);
+        if (ret.getArea() == 0) return ret;
+
+        enum : uint8_t {
+            NONE, WEAK, STRONG
+        };
+
+        std::vector<float> magnitude = magnitudes();
+        std::vector<uint8_t> state(magnitude.size());
+
+        auto at = [&](int x, int y) {
+            return x < 0 || y < 0 || x >= width || y >= height ? 0 : magnitude[static_cast<size_t>(y) * width + x];
+        };
+
+        // Non-maximum suppression across the edge, with the direction quantized to the nearest of four
+        const float tan22 = 0.41421356f;
+
+        Parallel::parallelBands(0, height, [&](int y1, int y2) {
+            for (int y = y1; y < y2; y++) {
+                for (int x = 0; x < width; x++) {
+                    size_t i = static_cast<size_t>(y) * width + x;
+                    float m = magnitude[i];
+
+                    if (m <= low) continue;
+
+                    float ax = std::abs(dx[i]), ay = std::abs(dy[i]);
+                    float before, after;
+
+                    if (ay <= ax * tan22) {
+                        before = at(x - 1, y), after = at(x + 1, y);
+                    } else if (ax <= ay * tan22) {
+                        before = at(x, y - 1), after = at(x, y + 1);
+                    } else if ((dx[i] > 0) == (dy[i] > 0)) {
+                        before = at(x - 1, y - 1), after = at(x + 1, y + 1);
+                    } else {
+                        before = at(x + 1, y - 1), after = at(x - 1, y + 1);
+                    }
+
+                    // Ties go to the first pixel of a plateau, keeping edges one pixel wide
+                    if (m > before && m >= after) state[i] = m > high ? STRONG : WEAK;
+                }
+            }
+        });
+
+        // Hysteresis: grow strong pixels through 8-connected weak ones
+        std::vector<size_t> stack;
+
+        for (size_t i = 0; i < state.size(); i++) {
+            if (state[i] == STRONG) stack.push_back(i);
+        }
+
+        while (!stack.empty()) {
+            size_t i = stack.back();
+            stack.pop_back();
+
+            int x = i % width, y = i / width;
+
+            for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ny++) {
+                for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++) {
+                    size_t j = static_cast<size_t>(ny) * width + nx;
+
+                    if (state[j] == WEAK) {
+                        state[j] = STRONG;
+                        stack.push_back(j);
+                    }
+                }
+            }
+        }
+
+        bool *out = ret.getPixels();
+
+        Parallel::parallelBands(0, ret.getArea(), [&](int i1, int i2) {
+            for (int i = i1; i < i2; i++) out[i] = state[i] == STRONG;
+        });
+
+        return ret;
+    }
+
+    // Explicit template instantiation
+    template Gradient Gradient::of(const Bitmap &, GradientOperator);
+
+    template Gradient Gradient::of(const Graymap &, GradientOperator);
+
+    template Gradient Gradient::of(const RGBMap &, GradientOperator);
+
+    template Gradient Gradient::of(const RGBAMap &, GradientOperator);
+
+    template Graymap Gradient::laplacian(const Bitmap &, float);
+
+    template Graymap Gradient::laplacian(const Graymap &, float);
+
+    template Graymap Gradient::laplacian(const RGBMap &, float);
+
+    template Graymap Gradient::laplacian(const RGBAMap &, float);
+
+    template Bitmap Gradient::canny(const Bitmap &, float, float);
+
+    template Bitmap Gradient::canny(const Graymap &, float, float);
+
+    template Bitmap Gradient::canny(const RGBMap &, float, float);
+
+    template Bitmap Gradient::canny(const RGBAMap &, float, float);
+}
@@ -0,0 +1,146 @@
+#ifndef VISUALIZATION_GRADIENT_H
+#define VISUALIZATION_GRADIENT_H
+
+#include "pixmap.h"
+#include <vector>
+
+namespace Sine::Graphics {
+    /**
+     * 3x3 derivative operators.
+     */
+    enum class GradientOperator {
+        SOBEL, ///< Weights 1 2 1 across the derivative
+        SCHARR ///< Weights 3 10 3, closer to rotation invariant
+    };
+
+    /**
+     * Brightness gradient of an image, and the edge detectors built on it.
+     *
+     * Gradients are taken on the luma of colors, or on the value of Graymaps, normalized to levels per pixel so
+     * thresholds do not depend on the operator. Each thread processes a band of rows, keeping the three rows under
+     * the stencil in a ring of padded float rows, so every row is converted once. The Sobel and Scharr stencils then
+     * run as one Simd::PixelKernels call per row and direction, over those contiguous padded rows.
+     */
+    class Gradient {
+    private:
+        int width;
+        int height;
+        std::vector<float> dx;
+        std::vector<float> dy;
+
+        Gradient(int width, int height);
+
+    public:
+        /**
+         * Computes the gradient of an image, reading past the border as the border pixel.
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param op Derivative operator.
+         * @return Gradient.
+         */
+        template<typename T>
+        static Gradient of(const Pixmap<T> &image, GradientOperator op = GradientOperator::SOBEL);
+
+        /**
+         * Absolute value of the 4-neighbor Laplacian of an image, an isotropic second derivative which responds to
+         * edges and fine detail alike.
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param scale Output levels per level of response.
+         * @return Graymap of the scaled response, clamped to 0 - 255.
+         */
+        template<typename T>
+        static Graymap laplacian(const Pixmap<T> &image, float scale = 1);
+
+        /**
+         * Canny edge detection of an image with the Sobel operator. Noisy images should be blurred beforehand.
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param low Gradient magnitude above which pixels connected to an edge are edges.
+         * @param high Gradient magnitude above which pixels are edges.
+         * @return Edge pixels, one pixel wide.
+         */
+        template<typename T>
+        static Bitmap canny(const Pixmap<T> &image, float low, float high);
+
+        /**
+         * Getter for width.
+         * @return Width in pixels.
+         */
+        int getWidth() const;
+
+        /**
+         * Getter for height.
+         * @return Height in pixels.
+         */
+        int getHeight() const;
+
+        /**
+         * Horizontal derivative at a pixel, without bounds checking.
+         * @param x x coordinate.
+         * @param y y coordinate.
+         * @return Levels per pixel, increasing to the right.
+         */
+        float getX(int x, int y) const;
+
+        /**
+         * Vertical derivative at a pixel, without bounds checking.
+         * @param x x coordinate.
+         * @param y y coordinate.
+         * @return Levels per pixel, increasing downwards.
+         */
+        float getY(int x, int y) const;
+
+        /**
+         * Magnitude of the gradient at a pixel, without bounds checking.
+         * @param x x coordinate.
+         * @param y y coordinate.
+         * @return Levels per pixel.
+         */
+        float magnitude(int x, int y) const;
+
+        /**
+         * Direction of the gradient at a pixel, without bounds checking.
+         * @param x x coordinate.
+         * @param y y coordinate.
+         * @return Angle in radians from -pi to pi, clockwise from the x axis since y points down.
+         */
+        float direction(int x, int y) const;
+
+        /**
+         * Magnitude of every pixel.
+         * @return Row-major magnitudes.
+         */
+        std::vector<float> magnitudes() const;
+
+        /**
+         * Direction of every pixel.
+         * @return Row-major angles in radians.
+         */
+        std::vector<float> directions() const;
+
+        /**
+         * Converts the magnitudes to a Graymap.
+         * @param scale Output levels per level per pixel.
+         * @return Graymap of the scaled magnitudes, clamped to 0 - 255.
+         */
+        Graymap magnitudeMap(float scale = 1) const;
+
+        /**
+         * Converts the directions to a Graymap, mapping -pi to pi onto 0 - 255.
+         * @return Graymap.
+         */
+        Graymap directionMap() const;
+
+        /**
+         * Canny edges of the gradient: pixels whose magnitude is a maximum across the edge, above the high threshold
+         * or connected through pixels above the low threshold to one which is.
+         * @param low Low threshold in levels per pixel.
+         * @param high High threshold in levels per pixel.
+         * @return Edge pixels.
+         */
+        Bitmap edges(float low, float high) const;
+    };
+}
+
+#endif //VISUALIZATION_GRADIENT_H
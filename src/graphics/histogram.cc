@@ -0,0 +1,200 @@
+#include "histogram.h"
+#include "filters/channels.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace {
+        /*
+         * Interleaved copies of the bins each thread counts into.
+         */
+        const int COPIES = 4;
+
+        /**
+         * Counts values extracted from every pixel into histograms, in parallel bands.
+         * @tparam N Number of values per pixel.
+         * @param extract Functor called as extract(pixel, values), writing N values.
+         */
+        template<int N, typename T, typename Extract>
+        Histogram count(const Pixmap<T> &image, unsigned int threads, Extract extract) {
+            Histogram ret(N);
+
+            long area = image.getArea();
+            if (area == 0) return ret;
+
+            const T *pixels = image.getPixels();
+            int bands = std::max<int>(std::min<long>(std::max(threads, 1U), area), 1);
+
+            // Bands never exceed 2^32 pixels in practice, so 32-bit bins are enough and halve the cache footprint
+            std::vector<std::vector<uint32_t>> local(bands);
+
+            Parallel::parallelFor(0, bands, [&](int band) {
+                std::vector<uint32_t> &bins = local[band];
+                bins.assign(static_cast<size_t>(N) * COPIES * Histogram::BINS, 0);
+
+                long i1 = area * band / bands;
+                long i2 = area * (band + 1) / bands;
+                uint8_t values[N];
+
+                for (long i = i1; i < i2; i++) {
+                    extract(pixels[i], values);
+
+                    uint32_t *copy = &bins[(i & (COPIES - 1)) * N * Histogram::BINS];
+
+                    for (int c = 0; c < N; c++) {
+                        copy[c * Histogram::BINS + values[c]]++;
+                    }
+                }
+            }, threads);
+
+            for (int c = 0; c < N; c++) {
+                Histogram::Bins &out = ret.getBins(c);
+
+                for (const std::vector<uint32_t> &bins : local) {
+                    for (int copy = 0; copy < COPIES; copy++) {
+                        const uint32_t *in = &bins[(copy * N + c) * Histogram::BINS];
+
+                        for (int v = 0; v < Histogram::BINS; v++) {
+                            out[v] += in[v];
+                        }
+                    }
+                }
+            }
+
+            return ret;
+        }
+    }
+
+    template<typename T>
+    Histogram Histogram::ofChannels(const Pixmap<T> &image, unsigned int threads) {
+        constexpr int C = Filters::ChannelTraits<T>::count;
+
+        return count<C>(image, threads, [](const T &p, uint8_t *values) {
+            Filters::ChannelTraits<T>::load(p, values);
+        });
+    }
+
+    template<typename T>
+    Histogram Histogram::ofLuminance(const Pixmap<T> &image, unsigned int threads) {
+        constexpr int C = Filters::ChannelTraits<T>::count;
+
+        return count<1>(image, threads, [](const T &p, uint8_t *values) {
+            uint8_t c[C];
+            Filters::ChannelTraits<T>::load(p, c);
+
+            values[0] = C >= 3 ? luma(c[0], c[1], c[2]) : c[0];
+        });
+    }
+
+    Histogram::Histogram(int channelCount) {
+        if (channelCount < 1) {
+            throw std::invalid_argument("Histogram needs at least one channel.");
+        }
+
+        channels.resize(channelCount);
+
+        for (Bins &bins : channels) {
+            bins.fill(0);
+        }
+    }
+
+    int Histogram::getChannelCount() const {
+        return channels.size();
+    }
+
+    const Histogram::Bins &Histogram::getBins(int channel) const {
+        return channels.at(channel);
+    }
+
+    Histogram::Bins &Histogram::getBins(int channel) {
+        return channels.at(channel);
+    }
+
+    uint64_t Histogram::getTotal(int channel) const {
+        uint64_t total = 0;
+
+        for (uint64_t bin : getBins(channel)) {
+            total += bin;
+        }
+
+        return total;
+    }
+
+    double Histogram::mean(int channel) const {
+        const Bins &bins = getBins(channel);
+        uint64_t total = 0;
+        double sum = 0;
+
+        for (int v = 0; v < BINS; v++) {
+            total += bins[v];
+            sum += static_cast<double>(bins[v]) * v;
+        }
+
+        return total ? sum / total : 0;
+    }
+
+    uint8_t Histogram::percentile(double fraction, int channel) const {
+        const Bins &bins = getBins(channel);
+        double target = std::min(std::max(fraction, 0.0), 1.0) * getTotal(channel);
+        uint64_t cumulative = 0;
+
+        for (int v = 0; v < BINS; v++) {
+            cumulative += bins[v];
+
+            if (cumulative > 0 && cumulative >= target) return v;
+        }
+
+        return BINS - 1;
+    }
+
+    std::array<uint8_t, Histogram::BINS> Histogram::equalization(int channel) const {
+        const Bins &bins = getBins(channel);
+        uint64_t total = getTotal(channel);
+
+        std::array<uint8_t, BINS> ret;
+        uint64_t cumulative = 0;
+        uint64_t first = 0; // Count of the lowest occupied bin, which maps to 0
+
+        for (int v = 0; v < BINS; v++) {
+            if (cumulative == 0) first = bins[v];
+            cumulative += bins[v];
+
+            ret[v] = total > first ? static_cast<uint8_t>(std::lround((cumulative > first ? cumulative - first : 0)
+                                                                        * 255.0 / (total - first)))
+                                   : v;
+        }
+
+        return ret;
+    }
+
+    Histogram Histogram::pooled(int first, int count) const {
+        Histogram ret(1);
+
+        for (int c = first; c < first + count; c++) {
+            const Bins &bins = getBins(c);
+
+            for (int v = 0; v < BINS; v++) {
+                ret.channels[0][v] += bins[v];
+            }
+        }
+
+        return ret;
+    }
+
+    // Explicit template instantiation
+    template Histogram Histogram::ofChannels(const Bitmap &, unsigned int);
+
+    template Histogram Histogram::ofChannels(const Graymap &, unsigned int);
+
+    template Histogram Histogram::ofChannels(const RGBMap &, unsigned int);
+
+    template Histogram Histogram::ofChannels(const RGBAMap &, unsigned int);
+
+    template Histogram Histogram::ofLuminance(const Bitmap &, unsigned int);
+
+    template Histogram Histogram::ofLuminance(const Graymap &, unsigned int);
+
+    template Histogram Histogram::ofLuminance(const RGBMap &, unsigned int);
+
+    template Histogram Histogram::ofLuminance(const RGBAMap &, unsigned int);
+}
@@ -0,0 +1,124 @@
+#ifndef VISUALIZATION_HISTOGRAM_H
+#define VISUALIZATION_HISTOGRAM_H
+
+#include "pixmap.h"
+#include "parallel.h"
+#include <array>
+#include <vector>
+
+namespace Sine::Graphics {
+    /**
+     * 256-bin histograms of the channels or the luminance of a Pixmap.
+     *
+     * Counting splits the image into bands, one per thread. Each band counts into its own bins, spread over four
+     * interleaved copies so consecutive pixels of equal value do not wait on each other's increments, and the copies
+     * are merged at the end.
+     */
+    class Histogram {
+    public:
+        static constexpr int BINS = 256;
+
+        using Bins = std::array<uint64_t, BINS>;
+
+    private:
+        std::vector<Bins> channels;
+
+    public:
+        /**
+         * Luma of a color with Rec. 601 weights, in integer arithmetic.
+         * @param r Red channel.
+         * @param g Green channel.
+         * @param b Blue channel.
+         * @return Luma.
+         */
+        static uint8_t luma(uint8_t r, uint8_t g, uint8_t b) {
+            return static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+        }
+
+        /**
+         * Histograms of every channel, as given by Filters::ChannelTraits (RGBAMaps include alpha).
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param threads Maximum number of threads to use.
+         * @return Histogram with one channel per image channel.
+         */
+        template<typename T>
+        static Histogram ofChannels(const Pixmap<T> &image, unsigned int threads = Parallel::threadCount());
+
+        /**
+         * Histogram of the luma of the color of every pixel; for Bitmaps and Graymaps, of the value itself.
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param threads Maximum number of threads to use.
+         * @return Histogram with a single channel.
+         */
+        template<typename T>
+        static Histogram ofLuminance(const Pixmap<T> &image, unsigned int threads = Parallel::threadCount());
+
+        /**
+         * Constructor for an empty histogram.
+         * @param channelCount Number of channels.
+         */
+        explicit Histogram(int channelCount = 1);
+
+        /**
+         * Getter for channel count.
+         * @return Number of channels.
+         */
+        int getChannelCount() const;
+
+        /**
+         * Getter for the bins of a channel.
+         * @param channel Channel index.
+         * @return Bins.
+         */
+        const Bins &getBins(int channel = 0) const;
+
+        /**
+         * Mutable access to the bins of a channel.
+         * @param channel Channel index.
+         * @return Bins.
+         */
+        Bins &getBins(int channel = 0);
+
+        /**
+         * Total count of a channel.
+         * @param channel Channel index.
+         * @return Number of values counted.
+         */
+        uint64_t getTotal(int channel = 0) const;
+
+        /**
+         * Mean value of a channel.
+         * @param channel Channel index.
+         * @return Mean, 0 if the histogram is empty.
+         */
+        double mean(int channel = 0) const;
+
+        /**
+         * Smallest value at or below which at least a fraction of the values of a channel lie.
+         * @param fraction Fraction from 0 to 1.
+         * @param channel Channel index.
+         * @return Value.
+         */
+        uint8_t percentile(double fraction, int channel = 0) const;
+
+        /**
+         * Table mapping each value to its position in the cumulative distribution of a channel, spread over 0 - 255,
+         * which flattens the histogram.
+         * @param channel Channel index.
+         * @return Lookup table.
+         */
+        std::array<uint8_t, BINS> equalization(int channel = 0) const;
+
+        /**
+         * Sum of several channels into one.
+         * @param first First channel.
+         * @param count Number of channels.
+         * @return Histogram with a single channel.
+         */
+        Histogram pooled(int first, int count) const;
+    };
+}
+
+#endif //VISUALIZATION_HISTOGRAM_H
@@ -3,194 +3,125 @@
 //
 
 #include "imageloader.h"
+#include "netpbm.h"
+#include "filters/channels.h"
+#include <climits>
 
 namespace Sine::Graphics {
+    namespace {
+        /**
+         * Takes over pixels decoded by stbi_image with as many channels as the pixel type has bytes, without copying.
+         * @param data Buffer from stbi_load, freed by the returned Pixmap.
+         */
+        template<typename T>
+        Pixmap<T> adopt(unsigned char *data, int x, int y) {
+            return Pixmap<T>(x, y, reinterpret_cast<T *>(data), [](T *p) { stbi_image_free(p); });
+        }
 
-    template<typename P>
-    P ImageLoader<P>::load(const std::string &filename) {
-        int x, y, n;
+        /**
+         * Gray bytes are not valid bools, so Bitmaps threshold them into new pixels, by the rule Netpbm reads and the
+         * filters use.
+         */
+        template<>
+        Pixmap<bool> adopt<bool>(unsigned char *data, int x, int y) {
+            Pixmap<bool> ret(x, y);
 
-        unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, 0); /// Interface to stbi_load
-        if (data == nullptr) { // If data is invalid, throw an error
-            throw std::runtime_error("Image does not exist or is inaccessible.");
-        }
+            for (long index = 0; index < ret.getArea(); index++) {
+                ret.getPixels()[index] = Filters::ChannelTraits<bool>::store(&data[index]);
+            }
 
-        P p(x, y);
+            stbi_image_free(data);
 
-        if (p.ColorSize == n) {
-            p.setPixelPointer(static_cast<void *>(data)); // Set pointer of Pixmap to correct location
-            return p;
-        } else {
-            throw std::runtime_error("Invalid data type length for image.");
+            return ret;
         }
     }
 
-    template<>
-    Bitmap ImageLoader<Bitmap>::loadAny(const std::string &filename) {
-        typedef Bitmap P;
+    template<typename P>
+    P ImageLoader<P>::load(const std::string &filename) {
         int x, y, n;
 
-        unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, 0);
-        if (data == nullptr) {
+        unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, 0); /// Interface to stbi_load
+        if (data == nullptr) { // If data is invalid, throw an error
             throw std::runtime_error("Image does not exist or is inaccessible.");
         }
 
-        if (Bitmap::ColorSize == n) {
-            Bitmap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-
-            return temp;
-        } else if (Graymap::ColorSize == n) {
-            Graymap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
-
-            return conv.convert(temp);
-        } else if (RGBMap::ColorSize == n) {
-            RGBMap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
-
-            return conv.convert(temp);
-        } else if (RGBAMap::ColorSize == n) {
-            RGBAMap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
-
-            return conv.convert(temp);
-        } else {
+        if (P::ColorSize != n) {
+            stbi_image_free(data);
             throw std::runtime_error("Invalid data type length for image.");
         }
+
+        return adopt<typename P::PixelType>(data, x, y);
     }
 
-    template<>
-    Graymap ImageLoader<Graymap>::loadAny(const std::string &filename) {
-        typedef Graymap P;
+    template<typename P>
+    P ImageLoader<P>::loadAny(const std::string &filename) {
+        using T = typename P::PixelType;
+
+        if (Netpbm::isNetpbm(filename)) return Netpbm::read<T>(filename);
+
         int x, y, n;
 
-        unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, 0);
+        // stbi_image converts to the channel count of the pixel type itself, straight into the buffer adopted
+        unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, P::ColorSize);
         if (data == nullptr) {
             throw std::runtime_error("Image does not exist or is inaccessible.");
         }
 
-        if (Bitmap::ColorSize == n) {
-            Bitmap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
-
-            return conv.convert(temp);
-        } else if (Graymap::ColorSize == n) {
-            Graymap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-
-            return temp;
-        } else if (RGBMap::ColorSize == n) {
-            RGBMap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
+        return adopt<T>(data, x, y);
+    }
 
-            return conv.convert(temp);
-        } else if (RGBAMap::ColorSize == n) {
-            RGBAMap temp(x, y);
+    template<typename P>
+    P ImageLoader<P>::loadFromMemory(const uint8_t *data, size_t size) {
+        using T = typename P::PixelType;
 
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
+        if (Netpbm::isNetpbm(data, size)) return Netpbm::decode<T>(data, size);
 
-            return conv.convert(temp);
-        } else {
-            throw std::runtime_error("Invalid data type length for image.");
+        if (size > static_cast<size_t>(INT_MAX)) {
+            throw std::invalid_argument("Encoded image is too large.");
         }
-    }
 
-    template<>
-    RGBMap ImageLoader<RGBMap>::loadAny(const std::string &filename) {
-        typedef RGBMap P;
         int x, y, n;
 
-        unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, 0);
-        if (data == nullptr) {
-            throw std::runtime_error("Image does not exist or is inaccessible.");
+        unsigned char *pixels = stbi_load_from_memory(data, static_cast<int>(size), &x, &y, &n, P::ColorSize);
+        if (pixels == nullptr) {
+            throw std::runtime_error(std::string("Could not decode image: ") + stbi_failure_reason() + ".");
         }
 
-        if (Bitmap::ColorSize == n) {
-            Bitmap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
-
-            return conv.convert(temp);
-        } else if (Graymap::ColorSize == n) {
-            Graymap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
-
-            return conv.convert(temp);
-        } else if (RGBMap::ColorSize == n) {
-            RGBMap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-
-            return temp;
-        } else if (RGBAMap::ColorSize == n) {
-            RGBAMap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
+        return adopt<T>(pixels, x, y);
+    }
 
-            return conv.convert(temp);
-        } else {
-            throw std::runtime_error("Invalid data type length for image.");
-        }
+    template<typename P>
+    P ImageLoader<P>::loadFromMemory(const std::vector<uint8_t> &data) {
+        return loadFromMemory(data.data(), data.size());
     }
 
-    template<>
-    RGBAMap ImageLoader<RGBAMap>::loadAny(const std::string &filename) {
-        typedef RGBAMap P;
-        int x, y, n;
+    template<typename P>
+    ImageInfo ImageLoader<P>::probe(const std::string &filename) {
+        // Enough for any Netpbm header short of pages of comments
+        uint8_t head[4096];
+        std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
 
-        unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, 0);
-        if (data == nullptr) {
+        if (!file) {
             throw std::runtime_error("Image does not exist or is inaccessible.");
         }
 
-        if (Bitmap::ColorSize == n) {
-            Bitmap temp(x, y);
+        file.read(reinterpret_cast<char *>(head), sizeof(head));
+        size_t size = file.gcount();
 
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
+        ImageType type = detectImageType(head, size);
 
-            return conv.convert(temp);
-        } else if (Graymap::ColorSize == n) {
-            Graymap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
-
-            return conv.convert(temp);
-        } else if (RGBMap::ColorSize == n) {
-            RGBMap temp(x, y);
-
-            temp.setPixelPointer(static_cast<void *>(data));
-            ImageConverter<P> conv;
-
-            return conv.convert(temp);
-        } else if (RGBAMap::ColorSize == n) {
-            RGBAMap temp(x, y);
+        // stbi_image only knows binary PGM and PPM
+        if (type == ImageType::PBM || type == ImageType::PGM || type == ImageType::PPM) {
+            return Netpbm::probe(head, size);
+        }
 
-            temp.setPixelPointer(static_cast<void *>(data));
+        ImageInfo ret{0, 0, 0, type};
 
-            return temp;
-        } else {
-            throw std::runtime_error("Invalid data type length for image.");
+        if (!stbi_info(filename.c_str(), &ret.width, &ret.height, &ret.channels)) {
+            throw std::runtime_error(std::string("Could not probe image: ") + stbi_failure_reason() + ".");
         }
+
+        return ret;
     }
 
     // Explicit instantiation to make linker happy
@@ -202,4 +133,4 @@ namespace Sine::Graphics {
     struct ImageLoader<RGBMap>;
     template
     struct ImageLoader<RGBAMap>;
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 
 #include "stb_image.h"
 #include "imageconverter.h"
+#include <vector>
 
 #ifndef IMAGE_LOADER_DEFINED_
 #define IMAGE_LOADER_DEFINED_
@@ -11,6 +12,9 @@
 namespace Sine::Graphics {
     /**
      * Loads a P, given a file.
+     *
+     * stbi_image decodes straight into the channel layout of P, and the Pixmap adopts its buffer rather than copying
+     * it; Bitmaps, whose bools cannot alias gray bytes, are the exception.
      * @tparam P Pixmap type.
      */
     template<class P>
@@ -29,6 +33,28 @@ namespace Sine::Graphics {
          * @return A Pixmap.
          */
         static P loadAny(const std::string &filename);
+
+        /**
+         * Load an encoded image of any type from memory, converting if necessary.
+         * @param data Encoded image, e.g. the contents of a file.
+         * @param size Size of the encoded image in bytes.
+         * @return A Pixmap.
+         */
+        static P loadFromMemory(const uint8_t *data, size_t size);
+
+        /**
+         * Load an encoded image of any type from memory, converting if necessary.
+         * @param data Encoded image, e.g. the contents of a file.
+         * @return A Pixmap.
+         */
+        static P loadFromMemory(const std::vector<uint8_t> &data);
+
+        /**
+         * Read the dimensions, channel count and type of a file from its header, without decoding any pixels.
+         * @param filename File location.
+         * @return Information about the image.
+         */
+        static ImageInfo probe(const std::string &filename);
     };
 }
 
@@ -46,6 +46,42 @@ namespace Sine::Graphics {
         return ImageType::UNKNOWN;
     }
 
+    ImageType detectImageType(const uint8_t *data, size_t size) noexcept {
+        if (size >= 4 && data[0] == 0x89 && data[1] == 'P' && data[2] == 'N' && data[3] == 'G') {
+            return ImageType::PNG;
+        }
+
+        if (size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff) {
+            return ImageType::JPEG;
+        }
+
+        if (size >= 4 && data[0] == 'G' && data[1] == 'I' && data[2] == 'F' && data[3] == '8') {
+            return ImageType::GIF;
+        }
+
+        if (size >= 2 && data[0] == 'B' && data[1] == 'M') {
+            return ImageType::BMP;
+        }
+
+        if (size >= 2 && data[0] == 'P') {
+            switch (data[1]) {
+                case '1':
+                case '4':
+                    return ImageType::PBM;
+                case '2':
+                case '5':
+                    return ImageType::PGM;
+                case '3':
+                case '6':
+                    return ImageType::PPM;
+                default:
+                    break;
+            }
+        }
+
+        return ImageType::UNKNOWN;
+    }
+
     bool fileExists(const char *filename) {
         std::ifstream infile(filename);
         return infile.good();
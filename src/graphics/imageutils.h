@@ -1,6 +1,8 @@
 #ifndef IMAGE_UTILS_DEFINED_
 #define IMAGE_UTILS_DEFINED_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <fstream>
 
@@ -29,6 +31,24 @@ namespace Sine::Graphics {
      */
     ImageType extractImageType(std::string filename) noexcept;
 
+    /**
+     * Detect the type of an image from the magic number at the start of its data.
+     * @param data Start of the file.
+     * @param size Number of bytes available.
+     * @return Enum of file type, or ImageType::UNKNOWN.
+     */
+    ImageType detectImageType(const uint8_t *data, size_t size) noexcept;
+
+    /**
+     * What an image file holds, as found from its header alone.
+     */
+    struct ImageInfo {
+        int width;
+        int height;
+        int channels; ///< Channels stored in the file, 1 to 4
+        ImageType type;
+    };
+
 
     /**
      * Check if a file exists.
@@ -0,0 +1,219 @@
+#include "integralimage.h"
+#include "parallel.h"
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    template<typename T>
+    IntegralImage<T>::IntegralImage(const Pixmap<T> &image, bool withSquares)
+            : width(image.getWidth()), height(image.getHeight()) {
+        size_t size = static_cast<size_t>(width + 1) * channels * (height + 1);
+
+        if (withSquares) squares.assign(size, 0);
+
+        // 32-bit sums wrap past 2^32, which the whole image stays under if every pixel has fewer
+        if (static_cast<uint64_t>(width) * height * 255 < (static_cast<uint64_t>(1) << 32)) {
+            sums.assign(size, 0);
+            build(image, sums);
+        } else {
+            wideSums.assign(size, 0);
+            build(image, wideSums);
+        }
+    }
+
+    template<typename T>
+    template<typename S>
+    void IntegralImage<T>::build(const Pixmap<T> &image, std::vector<S> &table) {
+        size_t rowLength = static_cast<size_t>(width + 1) * channels;
+        bool withSquares = !squares.empty();
+        const T *pixels = image.getPixels();
+
+        // Prefix sums along each row
+        Parallel::parallelBands(0, height, [&](int y1, int y2) {
+            for (int y = y1; y < y2; y++) {
+                S sum[channels] = {};
+                uint64_t square[channels] = {};
+                uint8_t values[channels];
+
+                for (int x = 0; x < width; x++) {
+                    Filters::ChannelTraits<T>::load(pixels[static_cast<size_t>(y) * width + x], values);
+
+                    for (int c = 0; c < channels; c++) {
+                        sum[c] += values[c];
+                        table[index(x + 1, y + 1, c)] = sum[c];
+
+                        if (withSquares) {
+                            square[c] += values[c] * values[c];
+                            squares[index(x + 1, y + 1, c)] = square[c];
+                        }
+                    }
+                }
+            }
+        });
+
+        // Then down each column, a row at a time so threads sweep contiguous bands of columns
+        Parallel::parallelBands(0, rowLength, [&](int i1, int i2) {
+            for (int y = 1; y <= height; y++) {
+                S *row = &table[y * rowLength];
+
+                for (int i = i1; i < i2; i++) {
+                    row[i] += row[i - rowLength];
+                }
+
+                if (withSquares) {
+                    uint64_t *squareRow = &squares[y * rowLength];
+
+                    for (int i = i1; i < i2; i++) {
+                        squareRow[i] += squareRow[i - rowLength];
+                    }
+                }
+            }
+        });
+    }
+
+    template<typename T>
+    bool IntegralImage<T>::clip(int &x1, int &y1, int &x2, int &y2) const {
+        x1 = std::max(x1, 0);
+        y1 = std::max(y1, 0);
+        x2 = std::min(x2, width);
+        y2 = std::min(y2, height);
+
+        return x1 < x2 && y1 < y2;
+    }
+
+    template<typename T>
+    void IntegralImage<T>::checkChannel(int channel) const {
+        if (channel < 0 || channel >= channels) {
+            throw std::invalid_argument("Channel " + std::to_string(channel) + " out of range.");
+        }
+    }
+
+    template<typename T>
+    int IntegralImage<T>::getWidth() const {
+        return width;
+    }
+
+    template<typename T>
+    int IntegralImage<T>::getHeight() const {
+        return height;
+    }
+
+    template<typename T>
+    bool IntegralImage<T>::hasSquares() const {
+        return !squares.empty();
+    }
+
+    template<typename T>
+    uint64_t IntegralImage<T>::sum(int x1, int y1, int x2, int y2, int channel) const {
+        checkChannel(channel);
+        if (!clip(x1, y1, x2, y2)) return 0;
+
+        return wideSums.empty() ? rectangle(sums, x1, y1, x2, y2, channel)
+                                : rectangle(wideSums, x1, y1, x2, y2, channel);
+    }
+
+    template<typename T>
+    double IntegralImage<T>::mean(int x1, int y1, int x2, int y2, int channel) const {
+        return statistics(x1, y1, x2, y2, channel).mean;
+    }
+
+    template<typename T>
+    double IntegralImage<T>::variance(int x1, int y1, int x2, int y2, int channel) const {
+        if (!hasSquares()) {
+            throw std::logic_error("Variance requires an IntegralImage built with squares.");
+        }
+
+        return statistics(x1, y1, x2, y2, channel).variance;
+    }
+
+    template<typename T>
+    RegionStatistics IntegralImage<T>::statistics(int x1, int y1, int x2, int y2, int channel) const {
+        checkChannel(channel);
+
+        RegionStatistics ret;
+        if (!clip(x1, y1, x2, y2)) return ret;
+
+        ret.area = static_cast<long>(x2 - x1) * (y2 - y1);
+        ret.sum = sum(x1, y1, x2, y2, channel);
+        ret.mean = static_cast<double>(ret.sum) / ret.area;
+
+        if (!squares.empty()) {
+            uint64_t square = rectangle(squares, x1, y1, x2, y2, channel);
+
+            ret.variance = std::max(static_cast<double>(square) / ret.area - ret.mean * ret.mean, 0.0);
+        }
+
+        return ret;
+    }
+
+    template<typename T>
+    Pixmap<T> IntegralImage<T>::boxBlur(int radiusX, int radiusY) const {
+        if (radiusX < 0 || radiusY < 0) {
+            throw std::invalid_argument("Box blur radius must be nonnegative.");
+        }
+
+        Pixmap<T> ret(width, height);
+        T *pixels = ret.getPixels();
+
+        Parallel::parallelBands(0, height, [&](int y1, int y2) {
+            float values[channels];
+
+            for (int y = y1; y < y2; y++) {
+                int top = std::max(y - radiusY, 0), bottom = std::min(y + radiusY + 1, height);
+
+                for (int x = 0; x < width; x++) {
+                    int left = std::max(x - radiusX, 0), right = std::min(x + radiusX + 1, width);
+                    float area = static_cast<float>(right - left) * (bottom - top);
+
+                    for (int c = 0; c < channels; c++) {
+                        values[c] = sum(left, top, right, bottom, c) / area;
+                    }
+
+                    pixels[static_cast<size_t>(y) * width + x] = Filters::ChannelTraits<T>::store(values);
+                }
+            }
+        });
+
+        return ret;
+    }
+
+    template<typename T>
+    Bitmap IntegralImage<T>::adaptiveThreshold(int radius, double offset, int channel) const {
+        checkChannel(channel);
+
+        if (radius < 0) {
+            throw std::invalid_argument("Threshold radius must be nonnegative.");
+        }
+
+        Bitmap ret(width, height);
+        bool *pixels = ret.getPixels();
+
+        Parallel::parallelBands(0, height, [&](int y1, int y2) {
+            for (int y = y1; y < y2; y++) {
+                int top = std::max(y - radius, 0), bottom = std::min(y + radius + 1, height);
+
+                for (int x = 0; x < width; x++) {
+                    int left = std::max(x - radius, 0), right = std::min(x + radius + 1, width);
+                    double local = static_cast<double>(sum(left, top, right, bottom, channel))
+                                   / ((right - left) * (bottom - top));
+
+                    pixels[static_cast<size_t>(y) * width + x] = sum(x, y, x + 1, y + 1, channel) > local + offset;
+                }
+            }
+        });
+
+        return ret;
+    }
+
+    // Explicit template instantiation
+    template
+    class IntegralImage<bool>;
+
+    template
+    class IntegralImage<uint8_t>;
+
+    template
+    class IntegralImage<RGB>;
+
+    template
+    class IntegralImage<RGBA>;
+}
@@ -0,0 +1,169 @@
+#ifndef VISUALIZATION_INTEGRALIMAGE_H
+#define VISUALIZATION_INTEGRALIMAGE_H
+
+#include "pixmap.h"
+#include "filters/channels.h"
+#include <vector>
+
+namespace Sine::Graphics {
+    /**
+     * Statistics of one channel over a rectangle.
+     */
+    struct RegionStatistics {
+        long area = 0; ///< Number of pixels in the clipped rectangle
+        uint64_t sum = 0; ///< Sum of values
+        double mean = 0; ///< Mean value, 0 for empty rectangles
+        double variance = 0; ///< Population variance, 0 for empty rectangles
+    };
+
+    /**
+     * Summed-area table of a Pixmap, answering sums, means and variances over any rectangle in constant time.
+     *
+     * Channels are those of Filters::ChannelTraits, on a 0 - 255 scale. Sums are kept in 32-bit accumulators, which
+     * stay exact under wraparound as long as no rectangle sums past 2^32, for images under 2^32 / 255 (about 16.8
+     * million) pixels; larger images get 64-bit accumulators instead. Squared sums, for variances, are always 64-bit.
+     * Tables are built with a parallel prefix sum along rows, then down columns.
+     * @tparam T Pixel type of the source Pixmap.
+     */
+    template<typename T>
+    class IntegralImage {
+    public:
+        /**
+         * Number of channels per pixel.
+         */
+        static constexpr int channels = Filters::ChannelTraits<T>::count;
+
+    private:
+        int width;
+        int height;
+
+        /*
+         * (width + 1) x (height + 1) entries per channel with a leading row and column of zeros.
+         */
+        std::vector<uint32_t> sums; ///< Empty for images too large for 32-bit sums
+        std::vector<uint64_t> wideSums; ///< Used instead of sums for those
+        std::vector<uint64_t> squares;
+
+        size_t index(int x, int y, int channel) const {
+            return (static_cast<size_t>(y) * (width + 1) + x) * channels + channel;
+        }
+
+        /**
+         * Fills a sum table, and the squared-sum table if it is allocated.
+         * @tparam S Accumulator type.
+         */
+        template<typename S>
+        void build(const Pixmap<T> &image, std::vector<S> &table);
+
+        /**
+         * Sum of a table over a rectangle, within the image.
+         */
+        template<typename S>
+        S rectangle(const std::vector<S> &table, int x1, int y1, int x2, int y2, int channel) const {
+            // Unsigned wraparound cancels out as long as the true sum fits
+            return table[index(x2, y2, channel)] - table[index(x1, y2, channel)] - table[index(x2, y1, channel)]
+                   + table[index(x1, y1, channel)];
+        }
+
+        /**
+         * Clips a rectangle to the image.
+         * @return Whether the clipped rectangle is non-empty.
+         */
+        bool clip(int &x1, int &y1, int &x2, int &y2) const;
+
+        void checkChannel(int channel) const;
+
+    public:
+        /**
+         * Constructor.
+         * @param image Source image.
+         * @param withSquares Whether to build the squared-sum table needed for variances.
+         */
+        explicit IntegralImage(const Pixmap<T> &image, bool withSquares = true);
+
+        /**
+         * Getter for width.
+         * @return Width of the source image.
+         */
+        int getWidth() const;
+
+        /**
+         * Getter for height.
+         * @return Height of the source image.
+         */
+        int getHeight() const;
+
+        /**
+         * Whether variances can be queried.
+         * @return Whether the squared-sum table was built.
+         */
+        bool hasSquares() const;
+
+        /**
+         * Sum of a channel over the rectangle [x1, x2) x [y1, y2), clipped to the image.
+         * @param x1 Left edge, inclusive.
+         * @param y1 Top edge, inclusive.
+         * @param x2 Right edge, exclusive.
+         * @param y2 Bottom edge, exclusive.
+         * @param channel Channel index.
+         * @return Sum of values.
+         */
+        uint64_t sum(int x1, int y1, int x2, int y2, int channel = 0) const;
+
+        /**
+         * Mean of a channel over the rectangle [x1, x2) x [y1, y2), clipped to the image.
+         * @param x1 Left edge, inclusive.
+         * @param y1 Top edge, inclusive.
+         * @param x2 Right edge, exclusive.
+         * @param y2 Bottom edge, exclusive.
+         * @param channel Channel index.
+         * @return Mean value, 0 for empty rectangles.
+         */
+        double mean(int x1, int y1, int x2, int y2, int channel = 0) const;
+
+        /**
+         * Population variance of a channel over the rectangle [x1, x2) x [y1, y2), clipped to the image.
+         * @param x1 Left edge, inclusive.
+         * @param y1 Top edge, inclusive.
+         * @param x2 Right edge, exclusive.
+         * @param y2 Bottom edge, exclusive.
+         * @param channel Channel index.
+         * @return Variance, 0 for empty rectangles.
+         * @throws std::logic_error If the squared-sum table was not built.
+         */
+        double variance(int x1, int y1, int x2, int y2, int channel = 0) const;
+
+        /**
+         * Area, sum, mean and variance of a channel over the rectangle [x1, x2) x [y1, y2), clipped to the image.
+         * The variance is left at 0 without a squared-sum table.
+         * @param x1 Left edge, inclusive.
+         * @param y1 Top edge, inclusive.
+         * @param x2 Right edge, exclusive.
+         * @param y2 Bottom edge, exclusive.
+         * @param channel Channel index.
+         * @return Statistics of the region.
+         */
+        RegionStatistics statistics(int x1, int y1, int x2, int y2, int channel = 0) const;
+
+        /**
+         * Box blur: every pixel becomes the mean of the window of (2 * radiusX + 1) x (2 * radiusY + 1) pixels
+         * around it, clipped to the image.
+         * @param radiusX Horizontal radius.
+         * @param radiusY Vertical radius.
+         * @return Blurred image.
+         */
+        Pixmap<T> boxBlur(int radiusX, int radiusY) const;
+
+        /**
+         * Adaptive threshold: a pixel is set when its value exceeds the mean of the window of (2 * radius + 1)
+         * pixels a side around it, clipped to the image, by more than offset.
+         * @param radius Radius of the window.
+         * @param offset Margin above the local mean, on the 0 - 255 scale; negative values admit pixels below it.
+         * @param channel Channel index.
+         * @return Thresholded image.
+         */
+        Bitmap adaptiveThreshold(int radius, double offset = 0, int channel = 0) const;
+    };
+}
+
+#endif //VISUALIZATION_INTEGRALIMAGE_H
@@ -0,0 +1,140 @@
+#include "lazypixmap.h"
+#include <vector>
+
+namespace Sine::Graphics {
+    namespace {
+        /*
+         * State shared by all LazyPixmaps. The mutex guards it and the pixels, bytes and position of every LazyPixmap.
+         */
+        std::mutex registryMutex;
+        std::list<LazyPixmapBase *> recentlyUsed; ///< Loaded images, most recently used first
+        size_t memoryUsed = 0;
+        size_t memoryBudget = 0;
+    }
+
+    LazyPixmapBase::~LazyPixmapBase() {
+        unload();
+    }
+
+    std::shared_ptr<const void> LazyPixmapBase::acquire() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        if (pixels) recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, position);
+
+        return pixels;
+    }
+
+    void LazyPixmapBase::store(std::shared_ptr<const void> loaded, size_t size) {
+        // Freed after the lock is released, in case this held the last reference
+        std::vector<std::shared_ptr<const void>> evicted;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        pixels = std::move(loaded);
+        bytes = size;
+        memoryUsed += size;
+        position = recentlyUsed.insert(recentlyUsed.begin(), this);
+
+        // The image just loaded stays, even if it alone is over the budget
+        while (memoryBudget > 0 && memoryUsed > memoryBudget && recentlyUsed.back() != this) {
+            LazyPixmapBase *victim = recentlyUsed.back();
+            recentlyUsed.pop_back();
+
+            evicted.push_back(std::move(victim->pixels));
+            victim->pixels = nullptr;
+            memoryUsed -= victim->bytes;
+            victim->bytes = 0;
+        }
+    }
+
+    bool LazyPixmapBase::isLoaded() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        return pixels != nullptr;
+    }
+
+    void LazyPixmapBase::unload() {
+        std::shared_ptr<const void> dropped;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        if (!pixels) return;
+
+        recentlyUsed.erase(position);
+        dropped = std::move(pixels);
+        pixels = nullptr;
+        memoryUsed -= bytes;
+        bytes = 0;
+    }
+
+    void LazyPixmapBase::setMemoryBudget(size_t budget) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        memoryBudget = budget;
+    }
+
+    size_t LazyPixmapBase::getMemoryBudget() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        return memoryBudget;
+    }
+
+    size_t LazyPixmapBase::getMemoryUsed() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        return memoryUsed;
+    }
+
+    template<class P>
+    LazyPixmap<P>::LazyPixmap(std::string _path) : path(std::move(_path)) {
+    }
+
+    template<class P>
+    const std::string &LazyPixmap<P>::getPath() const {
+        return path;
+    }
+
+    template<class P>
+    ImageInfo LazyPixmap<P>::getInfo() {
+        std::lock_guard<std::mutex> lock(loadMutex);
+
+        if (!info) info = ImageLoader<P>::probe(path);
+
+        return *info;
+    }
+
+    template<class P>
+    int LazyPixmap<P>::getWidth() {
+        return getInfo().width;
+    }
+
+    template<class P>
+    int LazyPixmap<P>::getHeight() {
+        return getInfo().height;
+    }
+
+    template<class P>
+    std::shared_ptr<const P> LazyPixmap<P>::get() {
+        if (auto loaded = acquire()) return std::static_pointer_cast<const P>(loaded);
+
+        // Only one thread decodes; the others find its pixels once it is done
+        std::lock_guard<std::mutex> lock(loadMutex);
+
+        if (auto loaded = acquire()) return std::static_pointer_cast<const P>(loaded);
+
+        auto image = std::make_shared<const P>(ImageLoader<P>::loadAny(path));
+        store(image, image->getArea() * sizeof(typename P::PixelType));
+
+        return image;
+    }
+
+    // Explicit template instantiation
+    template
+    class LazyPixmap<Bitmap>;
+
+    template
+    class LazyPixmap<Graymap>;
+
+    template
+    class LazyPixmap<RGBMap>;
+
+    template
+    class LazyPixmap<RGBAMap>;
+}
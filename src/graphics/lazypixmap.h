@@ -0,0 +1,132 @@
+#ifndef VISUALIZATION_LAZYPIXMAP_H
+#define VISUALIZATION_LAZYPIXMAP_H
+
+#include "imageloader.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace Sine::Graphics {
+    /**
+     * Bookkeeping shared by every LazyPixmap, whatever its pixel type: the bytes of pixels loaded and the order in
+     * which they were last used.
+     */
+    class LazyPixmapBase {
+    private:
+        std::list<LazyPixmapBase *>::iterator position; ///< Place in the least recently used list, if loaded
+
+    protected:
+        std::shared_ptr<const void> pixels; ///< Loaded Pixmap, or nullptr
+        size_t bytes = 0; ///< Size of the loaded pixels
+
+        std::mutex loadMutex; ///< Held while probing or decoding this image
+
+        LazyPixmapBase() = default;
+
+        ~LazyPixmapBase();
+
+        /**
+         * Returns the loaded pixels, marking them as just used.
+         * @return Pixels, or nullptr if not loaded.
+         */
+        std::shared_ptr<const void> acquire();
+
+        /**
+         * Records freshly decoded pixels, unloading the least recently used images while over the budget.
+         * @param loaded Pixels.
+         * @param size Bytes of pixels.
+         */
+        void store(std::shared_ptr<const void> loaded, size_t size);
+
+    public:
+        LazyPixmapBase(const LazyPixmapBase &) = delete;
+
+        LazyPixmapBase &operator=(const LazyPixmapBase &) = delete;
+
+        /**
+         * Whether the pixels are in memory.
+         * @return Whether the image is loaded.
+         */
+        bool isLoaded();
+
+        /**
+         * Drops the pixels, to be decoded again on next access. Pixmaps already returned by get() stay valid.
+         */
+        void unload();
+
+        /**
+         * Sets how many bytes of pixels all LazyPixmaps may hold together; past it, the least recently used are
+         * unloaded. 0, the default, means no limit.
+         * @param budget Budget in bytes.
+         */
+        static void setMemoryBudget(size_t budget);
+
+        /**
+         * Getter for memory budget.
+         * @return Budget in bytes, or 0 for no limit.
+         */
+        static size_t getMemoryBudget();
+
+        /**
+         * Getter for memory used.
+         * @return Bytes of pixels held by all LazyPixmaps.
+         */
+        static size_t getMemoryUsed();
+    };
+
+    /**
+     * Handle to an image file which reads the header only when the dimensions are asked for, and decodes the pixels
+     * only on first access.
+     *
+     * get() returns a shared pointer, so pixels unloaded by unload() or by the memory budget stay alive for as long as
+     * someone still uses them.
+     * @tparam P Pixmap type.
+     */
+    template<class P>
+    class LazyPixmap : public LazyPixmapBase {
+    private:
+        std::string path;
+        std::optional<ImageInfo> info;
+
+    public:
+        /**
+         * Constructor, which does not touch the file.
+         * @param path Path of the file.
+         */
+        explicit LazyPixmap(std::string path);
+
+        /**
+         * Getter for path.
+         * @return Path of the file.
+         */
+        const std::string &getPath() const;
+
+        /**
+         * Getter for info, probing the file the first time.
+         * @return Dimensions, channel count and type of the file.
+         */
+        ImageInfo getInfo();
+
+        /**
+         * Getter for width, probing the file the first time.
+         * @return Width in pixels.
+         */
+        int getWidth();
+
+        /**
+         * Getter for height, probing the file the first time.
+         * @return Height in pixels.
+         */
+        int getHeight();
+
+        /**
+         * Getter for the pixels, decoding the file if they are not loaded.
+         * @return The image, converted as ImageLoader::loadAny converts.
+         */
+        std::shared_ptr<const P> get();
+    };
+}
+
+#endif //VISUALIZATION_LAZYPIXMAP_H
@@ -0,0 +1,571 @@
+#include "netpbm.h"
+#include "histogram.h"
+#include "parallel.h"
+#include "filters/channels.h"
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace Sine::Graphics {
+    namespace {
+        /*
+         * Bytes converted per write when pixels need converting.
+         */
+        const size_t WRITE_BUFFER = 1 << 20;
+
+        /**
+         * File contents, mapped into memory where possible. Mappings are private and writable, so pages written to
+         * are copied rather than changing the file.
+         */
+        class MappedFile {
+        private:
+            void *map = MAP_FAILED;
+            std::vector<uint8_t> fallback;
+
+        public:
+            const uint8_t *data = nullptr;
+            size_t size = 0;
+
+            explicit MappedFile(const std::string &path) {
+                int fd = open(path.c_str(), O_RDONLY);
+
+                if (fd < 0) {
+                    throw std::runtime_error("Image does not exist or is inaccessible.");
+                }
+
+                struct stat info{};
+
+                if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+                    size = info.st_size;
+                    map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+                    if (map != MAP_FAILED) {
+                        madvise(map, size, MADV_SEQUENTIAL);
+                        data = static_cast<const uint8_t *>(map);
+                    }
+                }
+
+                // Pipes and the like
+                if (map == MAP_FAILED) {
+                    uint8_t buffer[1 << 16];
+                    ssize_t n;
+
+                    while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+                        fallback.insert(fallback.end(), buffer, buffer + n);
+                    }
+
+                    data = fallback.data();
+                    size = fallback.size();
+                }
+
+                close(fd);
+            }
+
+            MappedFile(const MappedFile &) = delete;
+
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            ~MappedFile() {
+                if (map != MAP_FAILED) munmap(map, size);
+            }
+
+            /**
+             * Whether the contents are a mapping of the file, rather than a copy.
+             */
+            bool isMapped() const {
+                return map != MAP_FAILED;
+            }
+
+            /**
+             * Hands over the mapping, which the caller must unmap.
+             * @return Start of the mapping.
+             */
+            void *release() {
+                void *ret = map;
+                map = MAP_FAILED;
+
+                // Pixels are no longer read once front to back
+                madvise(ret, size, MADV_NORMAL);
+
+                return ret;
+            }
+        };
+
+        struct Header {
+            int format; ///< Digit of the magic number
+            int width;
+            int height;
+            int maxval;
+            size_t offset; ///< Start of the pixel data
+        };
+
+        /**
+         * Reads Netpbm header tokens: integers separated by whitespace and comments.
+         */
+        class Tokenizer {
+        private:
+            const uint8_t *data;
+            size_t size;
+
+        public:
+            size_t position = 0;
+
+            Tokenizer(const uint8_t *_data, size_t _size, size_t start) : data(_data), size(_size), position(start) {
+            }
+
+            void skip() {
+                while (position < size) {
+                    if (data[position] == '#') {
+                        while (position < size && data[position] != '\n') position++;
+                    } else if (std::isspace(data[position])) {
+                        position++;
+                    } else {
+                        break;
+                    }
+                }
+            }
+
+            int next() {
+                skip();
+
+                if (position >= size || !std::isdigit(data[position])) {
+                    throw std::runtime_error("Invalid Netpbm image.");
+                }
+
+                long value = 0;
+
+                while (position < size && std::isdigit(data[position])) {
+                    value = value * 10 + (data[position++] - '0');
+
+                    if (value > 0x7fffffff) throw std::runtime_error("Invalid Netpbm image.");
+                }
+
+                return value;
+            }
+
+            /**
+             * Next digit of a plain PBM, whose bits need not be separated.
+             */
+            int nextBit() {
+                skip();
+
+                if (position >= size || (data[position] != '0' && data[position] != '1')) {
+                    throw std::runtime_error("Truncated Netpbm image.");
+                }
+
+                return data[position++] - '0';
+            }
+        };
+
+        Header parseHeader(const uint8_t *data, size_t size) {
+            if (!Netpbm::isNetpbm(data, size)) {
+                throw std::runtime_error("Not a Netpbm image.");
+            }
+
+            Header ret{};
+            ret.format = data[1] - '0';
+
+            Tokenizer tokens(data, size, 2);
+            ret.width = tokens.next();
+            ret.height = tokens.next();
+            ret.maxval = ret.format == 1 || ret.format == 4 ? 1 : tokens.next();
+
+            if (ret.width <= 0 || ret.height <= 0 || ret.maxval <= 0 || ret.maxval > 65535) {
+                throw std::runtime_error("Invalid Netpbm image.");
+            }
+
+            // Exactly one whitespace byte separates the header from binary data
+            ret.offset = tokens.position + 1;
+
+            return ret;
+        }
+
+        inline int channelsOf(int format) {
+            return format == 3 || format == 6 ? 3 : 1;
+        }
+
+        /**
+         * Reads a plain format into binary samples from 0 to 255, with set PBM bits made black.
+         */
+        std::vector<uint8_t> readPlain(const uint8_t *data, size_t size, const Header &header, size_t start) {
+            Tokenizer tokens(data, size, start);
+            size_t samplesPerRow = static_cast<size_t>(header.width) * channelsOf(header.format);
+
+            // Every sample takes at least one byte, which bounds the dimensions before anything is allocated
+            if (start > size || (size - start) / samplesPerRow < static_cast<size_t>(header.height)) {
+                throw std::runtime_error("Truncated Netpbm image.");
+            }
+
+            size_t count = samplesPerRow * header.height;
+            std::vector<uint8_t> ret(count);
+
+            for (size_t i = 0; i < count; i++) {
+                if (header.format == 1) {
+                    ret[i] = tokens.nextBit() ? 0 : 255;
+                } else {
+                    ret[i] = (std::min(tokens.next(), header.maxval) * 255 + header.maxval / 2) / header.maxval;
+                }
+            }
+
+            return ret;
+        }
+
+        /**
+         * Converts a row of binary data to samples from 0 to 255, gray or RGB.
+         */
+        void decodeRow(const Header &header, const uint8_t *in, uint8_t *out) {
+            int width = header.width;
+
+            if (header.format == 4) {
+                for (int x = 0; x < width; x++) out[x] = (in[x >> 3] >> (7 - (x & 7))) & 1 ? 0 : 255;
+                return;
+            }
+
+            size_t n = static_cast<size_t>(width) * channelsOf(header.format);
+            int maxval = header.maxval;
+
+            if (maxval > 255) {
+                for (size_t i = 0; i < n; i++) {
+                    int v = std::min((in[2 * i] << 8) | in[2 * i + 1], maxval);
+                    out[i] = (v * 255 + maxval / 2) / maxval;
+                }
+            } else if (maxval < 255) {
+                for (size_t i = 0; i < n; i++) out[i] = (std::min<int>(in[i], maxval) * 255 + maxval / 2) / maxval;
+            } else {
+                std::memcpy(out, in, n);
+            }
+        }
+
+        /**
+         * Stores a row of gray or RGB samples as pixels.
+         */
+        template<typename T>
+        void storeRow(const uint8_t *samples, int channels, int width, T *out) {
+            constexpr int C = Filters::ChannelTraits<T>::count;
+            uint8_t c[4] = {0, 0, 0, 255};
+
+            for (int x = 0; x < width; x++) {
+                const uint8_t *s = samples + static_cast<size_t>(x) * channels;
+
+                if (C >= 3) {
+                    c[0] = s[0];
+                    c[1] = s[channels == 3 ? 1 : 0];
+                    c[2] = s[channels == 3 ? 2 : 0];
+                } else {
+                    c[0] = channels == 3 ? Histogram::luma(s[0], s[1], s[2]) : s[0];
+                }
+
+                out[x] = Filters::ChannelTraits<T>::store(c);
+            }
+        }
+
+        /**
+         * Whether rows of a format are stored exactly as rows of pixels of a type.
+         */
+        template<typename T>
+        bool sameLayout(int format, int maxval) {
+            if (maxval != 255) return false;
+
+            return (std::is_same<T, uint8_t>::value && format == 5) || (std::is_same<T, RGB>::value && format == 6);
+        }
+
+        void writeFully(int fd, struct iovec *vectors, int count) {
+            while (count > 0) {
+                ssize_t n = writev(fd, vectors, count);
+
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+
+                    throw std::runtime_error("Could not write image.");
+                }
+
+                // Skip what was written, which may end partway through a vector
+                while (count > 0 && static_cast<size_t>(n) >= vectors->iov_len) {
+                    n -= vectors->iov_len;
+                    vectors++;
+                    count--;
+                }
+
+                if (count > 0) {
+                    vectors->iov_base = static_cast<char *>(vectors->iov_base) + n;
+                    vectors->iov_len -= n;
+                }
+            }
+        }
+
+        /**
+         * Converts a row of pixels to the data of a binary format.
+         */
+        template<typename T>
+        void encodeRow(const T *row, int width, ImageType type, uint8_t *out) {
+            constexpr int C = Filters::ChannelTraits<T>::count;
+            uint8_t c[C];
+
+            if (type == ImageType::PBM) {
+                std::memset(out, 0, (width + 7) / 8);
+            }
+
+            for (int x = 0; x < width; x++) {
+                Filters::ChannelTraits<T>::load(row[x], c);
+
+                if (type == ImageType::PPM) {
+                    out[3 * x] = c[0];
+                    out[3 * x + 1] = c[C >= 3 ? 1 : 0];
+                    out[3 * x + 2] = c[C >= 3 ? 2 : 0];
+                    continue;
+                }
+
+                uint8_t gray = C >= 3 ? Histogram::luma(c[0], c[1], c[2]) : c[0];
+
+                if (type == ImageType::PGM) {
+                    out[x] = gray;
+                } else if (gray < 128) {
+                    out[x >> 3] |= 0x80 >> (x & 7);
+                }
+            }
+        }
+
+        /**
+         * Header of a binary format.
+         * @param rowBytes Set to the bytes of data per row.
+         */
+        std::string formatHeader(ImageType type, int width, int height, size_t &rowBytes) {
+            std::string size = std::to_string(width) + ' ' + std::to_string(height) + '\n';
+
+            switch (type) {
+                case ImageType::PBM:
+                    rowBytes = (width + 7) / 8;
+                    return "P4\n" + size;
+                case ImageType::PGM:
+                    rowBytes = width;
+                    return "P5\n" + size + "255\n";
+                case ImageType::PPM:
+                    rowBytes = 3 * static_cast<size_t>(width);
+                    return "P6\n" + size + "255\n";
+                default:
+                    throw std::invalid_argument("Netpbm images are PBM, PGM or PPM.");
+            }
+        }
+
+        template<typename T>
+        bool sameLayout(ImageType type) {
+            return sameLayout<T>(type == ImageType::PGM ? 5 : type == ImageType::PPM ? 6 : 4, 255);
+        }
+
+        /**
+         * Converts the rows of an image in parallel, a buffer at a time.
+         * @param emit Called as emit(data, length) for each filled buffer, in order.
+         */
+        template<typename T, typename Emit>
+        void encodeRows(const Pixmap<T> &image, ImageType type, size_t rowBytes, Emit emit) {
+            int width = image.getWidth(), height = image.getHeight();
+            int batch = std::max<int>(WRITE_BUFFER / std::max<size_t>(rowBytes, 1), 1);
+            std::vector<uint8_t> buffer(rowBytes * std::min(batch, height));
+
+            for (int y1 = 0; y1 < height; y1 += batch) {
+                int y2 = std::min(y1 + batch, height);
+
+                Parallel::parallelBands(y1, y2, [&](int r1, int r2) {
+                    for (int y = r1; y < r2; y++) {
+                        encodeRow(image.getPixels() + static_cast<size_t>(y) * width, width, type,
+                                  &buffer[(y - y1) * rowBytes]);
+                    }
+                });
+
+                emit(buffer.data(), (y2 - y1) * rowBytes);
+            }
+        }
+    }
+
+    template<typename T>
+    void Netpbm::write(const Pixmap<T> &image, const std::string &path, ImageType type) {
+        size_t rowBytes;
+        std::string header = formatHeader(type, image.getWidth(), image.getHeight(), rowBytes);
+
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0) {
+            throw std::runtime_error("Could not open image for writing.");
+        }
+
+        try {
+            struct iovec vectors[2];
+            vectors[0].iov_base = &header[0];
+            vectors[0].iov_len = header.size();
+
+            if (sameLayout<T>(type)) {
+                // Pixels are the data as is
+                vectors[1].iov_base = image.getPixels();
+                vectors[1].iov_len = rowBytes * image.getHeight();
+
+                writeFully(fd, vectors, 2);
+            } else {
+                writeFully(fd, vectors, 1);
+
+                encodeRows(image, type, rowBytes, [&](const uint8_t *data, size_t length) {
+                    vectors[0].iov_base = const_cast<uint8_t *>(data);
+                    vectors[0].iov_len = length;
+
+                    writeFully(fd, vectors, 1);
+                });
+            }
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+
+        if (close(fd) != 0) {
+            throw std::runtime_error("Could not write image.");
+        }
+    }
+
+    template<typename T>
+    void Netpbm::write(const Pixmap<T> &image, std::ostream &out, ImageType type) {
+        size_t rowBytes;
+        std::string header = formatHeader(type, image.getWidth(), image.getHeight(), rowBytes);
+
+        out.write(header.data(), header.size());
+
+        if (sameLayout<T>(type)) {
+            out.write(reinterpret_cast<const char *>(image.getPixels()), rowBytes * image.getHeight());
+        } else {
+            encodeRows(image, type, rowBytes, [&](const uint8_t *data, size_t length) {
+                out.write(reinterpret_cast<const char *>(data), length);
+            });
+        }
+
+        if (!out) {
+            throw std::runtime_error("Could not write image.");
+        }
+    }
+
+    template<typename T>
+    Pixmap<T> Netpbm::read(const std::string &path) {
+        MappedFile file(path);
+
+        if (file.isMapped()) {
+            Header header = parseHeader(file.data, file.size);
+            size_t rowBytes = static_cast<size_t>(header.width) * channelsOf(header.format);
+
+            // Pixels stored as the Pixmap stores them are used in place, and unmapped with the Pixmap
+            if (sameLayout<T>(header.format, header.maxval) && header.offset <= file.size
+                && (file.size - header.offset) / rowBytes >= static_cast<size_t>(header.height)) {
+                size_t length = file.size;
+                auto *base = static_cast<uint8_t *>(file.release());
+
+                return Pixmap<T>(header.width, header.height, reinterpret_cast<T *>(base + header.offset),
+                                 [base, length](T *) { munmap(base, length); });
+            }
+        }
+
+        return decode<T>(file.data, file.size);
+    }
+
+    template<typename T>
+    Pixmap<T> Netpbm::decode(const uint8_t *buffer, size_t size) {
+        Header header = parseHeader(buffer, size);
+
+        int width = header.width, height = header.height;
+        int channels = channelsOf(header.format);
+
+        // Plain formats are parsed into binary samples first
+        std::vector<uint8_t> plain;
+        const uint8_t *data;
+        size_t rowBytes;
+
+        if (header.format <= 3) {
+            plain = readPlain(buffer, size, header, header.offset - 1);
+            data = plain.data();
+            rowBytes = static_cast<size_t>(width) * channels;
+            header.maxval = 255;
+            header.format = header.format == 1 ? 5 : header.format + 3; // Plain PBM bits are now gray samples
+        } else {
+            int bytesPerSample = header.maxval > 255 ? 2 : 1;
+
+            data = buffer + header.offset;
+            rowBytes = header.format == 4 ? (width + 7) / 8 : static_cast<size_t>(width) * channels * bytesPerSample;
+
+            // Divided rather than multiplied, so huge dimensions cannot overflow past the check
+            if (header.offset > size || (size - header.offset) / rowBytes < static_cast<size_t>(height)) {
+                throw std::runtime_error("Truncated Netpbm image.");
+            }
+        }
+
+        // Allocated only once the data is known to hold every row
+        Pixmap<T> ret(width, height);
+        T *pixels = ret.getPixels();
+
+        if (sameLayout<T>(header.format, header.maxval)) {
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                std::memcpy(pixels + static_cast<size_t>(y1) * width, data + y1 * rowBytes, (y2 - y1) * rowBytes);
+            });
+        } else {
+            Parallel::parallelBands(0, height, [&](int y1, int y2) {
+                std::vector<uint8_t> samples(static_cast<size_t>(width) * channels);
+
+                for (int y = y1; y < y2; y++) {
+                    decodeRow(header, data + y * rowBytes, samples.data());
+                    storeRow(samples.data(), channels, width, pixels + static_cast<size_t>(y) * width);
+                }
+            });
+        }
+
+        return ret;
+    }
+
+    ImageInfo Netpbm::probe(const uint8_t *data, size_t size) {
+        Header header = parseHeader(data, size);
+
+        return {header.width, header.height, channelsOf(header.format), detectImageType(data, size)};
+    }
+
+    bool Netpbm::isNetpbm(const std::string &path) {
+        ImageType type = extractImageType(path);
+
+        return type == ImageType::PBM || type == ImageType::PGM || type == ImageType::PPM;
+    }
+
+    bool Netpbm::isNetpbm(const uint8_t *data, size_t size) {
+        return size >= 2 && data[0] == 'P' && data[1] >= '1' && data[1] <= '6';
+    }
+
+    // Explicit template instantiation
+    template void Netpbm::write(const Bitmap &, const std::string &, ImageType);
+
+    template void Netpbm::write(const Graymap &, const std::string &, ImageType);
+
+    template void Netpbm::write(const RGBMap &, const std::string &, ImageType);
+
+    template void Netpbm::write(const RGBAMap &, const std::string &, ImageType);
+
+    template void Netpbm::write(const Bitmap &, std::ostream &, ImageType);
+
+    template void Netpbm::write(const Graymap &, std::ostream &, ImageType);
+
+    template void Netpbm::write(const RGBMap &, std::ostream &, ImageType);
+
+    template void Netpbm::write(const RGBAMap &, std::ostream &, ImageType);
+
+    template Bitmap Netpbm::read(const std::string &);
+
+    template Graymap Netpbm::read(const std::string &);
+
+    template RGBMap Netpbm::read(const std::string &);
+
+    template RGBAMap Netpbm::read(const std::string &);
+
+    template Bitmap Netpbm::decode(const uint8_t *, size_t);
+
+    template Graymap Netpbm::decode(const uint8_t *, size_t);
+
+    template RGBMap Netpbm::decode(const uint8_t *, size_t);
+
+    template RGBAMap Netpbm::decode(const uint8_t *, size_t);
+}
@@ -0,0 +1,88 @@
+#ifndef VISUALIZATION_NETPBM_H
+#define VISUALIZATION_NETPBM_H
+
+#include "imageutils.h"
+#include "pixmap.h"
+#include <ostream>
+#include <string>
+
+namespace Sine::Graphics {
+    /**
+     * Reads and writes Netpbm images (PBM, PGM and PPM) in bulk.
+     *
+     * Writing sends the header and the pixels in one writev when the pixels are already laid out as the format
+     * stores them (Graymaps as PGM, RGBMaps as PPM), and otherwise converts rows in parallel into a buffer written a
+     * megabyte at a time. Reading maps the file into memory, privately so writes to the pixels never reach the file.
+     * A Graymap read from a PGM or an RGBMap from a PPM, of maxval 255, takes the mapping as its pixels without a
+     * copy; other reads convert whole rows from the mapping, in parallel. Files which cannot be mapped are read
+     * whole. Binary (P4 - P6) and plain (P1 - P3) formats are read, and binary formats are written.
+     *
+     * Conversions between formats follow the file formats' own conventions: set Bitmap pixels are white, which PBM
+     * stores as 0; colors become gray by Rec. 601 luma; and gray becomes a Bitmap by thresholding, with 128 and up set.
+     */
+    struct Netpbm {
+        /**
+         * Writes an image, converting it to the format.
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param path Path of the file.
+         * @param type ImageType::PBM, ImageType::PGM or ImageType::PPM.
+         */
+        template<typename T>
+        static void write(const Pixmap<T> &image, const std::string &path, ImageType type);
+
+        /**
+         * Writes an image to a stream, converting it to the format.
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param out Stream.
+         * @param type ImageType::PBM, ImageType::PGM or ImageType::PPM.
+         */
+        template<typename T>
+        static void write(const Pixmap<T> &image, std::ostream &out, ImageType type);
+
+        /**
+         * Reads an image of any Netpbm format, converting it to the pixel type.
+         * @tparam T Pixel type.
+         * @param path Path of the file.
+         * @return Image.
+         */
+        template<typename T>
+        static Pixmap<T> read(const std::string &path);
+
+        /**
+         * Reads an image of any Netpbm format from memory, converting it to the pixel type.
+         * @tparam T Pixel type.
+         * @param data Contents of the file.
+         * @param size Size of the file in bytes.
+         * @return Image.
+         */
+        template<typename T>
+        static Pixmap<T> decode(const uint8_t *data, size_t size);
+
+        /**
+         * Reads the size and channel count of a Netpbm image from its header.
+         * @param data Start of the file, through the end of the header.
+         * @param size Number of bytes available.
+         * @return Information about the image.
+         */
+        static ImageInfo probe(const uint8_t *data, size_t size);
+
+        /**
+         * Whether a file name has a Netpbm extension.
+         * @param path Path of the file.
+         * @return Whether the file is PBM, PGM or PPM by name.
+         */
+        static bool isNetpbm(const std::string &path);
+
+        /**
+         * Whether data starts with a Netpbm magic number.
+         * @param data Contents of the file.
+         * @param size Size of the file in bytes.
+         * @return Whether the data is PBM, PGM or PPM.
+         */
+        static bool isNetpbm(const uint8_t *data, size_t size);
+    };
+}
+
+#endif //VISUALIZATION_NETPBM_H
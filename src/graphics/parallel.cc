@@ -0,0 +1,21 @@
+#include "parallel.h"
+
+namespace Sine::Graphics::Parallel {
+    namespace {
+        std::atomic<unsigned int> threadOverride{0};
+    }
+
+    unsigned int threadCount() {
+        unsigned int count = threadOverride;
+
+        if (count == 0) {
+            count = std::thread::hardware_concurrency();
+        }
+
+        return std::max(count, 1U);
+    }
+
+    void setThreadCount(unsigned int count) {
+        threadOverride = count;
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef VISUALIZATION_PARALLEL_H
+#define VISUALIZATION_PARALLEL_H
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+namespace Sine::Graphics {
+    /**
+     * Small helpers for splitting pixel work across threads.
+     */
+    namespace Parallel {
+        /**
+         * Number of threads used by default, which is the hardware concurrency unless overridden.
+         * @return Thread count, at least 1.
+         */
+        unsigned int threadCount();
+
+        /**
+         * Override the default thread count; 0 restores the hardware concurrency.
+         * @param count New thread count.
+         */
+        void setThreadCount(unsigned int count);
+
+        /**
+         * Calls func(i) for every i in [begin, end), handing out indices dynamically so uneven work balances out.
+         *
+         * The calling thread participates, and the first exception thrown by func is rethrown after all threads join.
+         * @tparam Func Type of functor.
+         * @param begin First index.
+         * @param end One past the last index.
+         * @param func Functor called as func(i).
+         * @param threads Maximum number of threads to use.
+         */
+        template<typename Func>
+        inline void parallelFor(int begin, int end, Func func, unsigned int threads = threadCount()) {
+            if (end <= begin) return;
+
+            unsigned int count = std::min<unsigned int>(std::max(threads, 1U), end - begin);
+
+            if (count == 1) {
+                for (int i = begin; i < end; i++) {
+                    func(i);
+                }
+                return;
+            }
+
+            std::atomic<int> next{begin};
+            std::exception_ptr error = nullptr;
+            std::atomic_flag errorSet = ATOMIC_FLAG_INIT;
+
+            auto worker = [&]() {
+                try {
+                    for (int i = next++; i < end; i = next++) {
+                        func(i);
+                    }
+                } catch (...) {
+                    if (!errorSet.test_and_set()) {
+                        error = std::current_exception();
+                    }
+                    next = end; // Stop handing out work
+                }
+            };
+
+            std::vector<std::thread> pool;
+            pool.reserve(count - 1);
+
+            for (unsigned int i = 1; i < count; i++) {
+                pool.emplace_back(worker);
+            }
+
+            worker();
+
+            for (auto &t : pool) {
+                t.join();
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        /**
+         * Splits [begin, end) into contiguous bands, one per thread, and calls func(band_begin, band_end) for each.
+         * @tparam Func Type of functor.
+         * @param begin First index.
+         * @param end One past the last index.
+         * @param func Functor called as func(band_begin, band_end).
+         * @param threads Maximum number of bands.
+         */
+        template<typename Func>
+        inline void parallelBands(int begin, int end, Func func, unsigned int threads = threadCount()) {
+            int length = end - begin;
+            if (length <= 0) return;
+
+            int bands = std::min<int>(std::max(threads, 1U), length);
+
+            parallelFor(0, bands, [&](int band) {
+                func(begin + static_cast<int>(static_cast<long>(length) * band / bands),
+                     begin + static_cast<int>(static_cast<long>(length) * (band + 1) / bands));
+            }, bands);
+        }
+    }
+}
+
+#endif //VISUALIZATION_PARALLEL_H
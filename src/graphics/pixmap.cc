@@ -2,9 +2,64 @@
 // Created by Timothy Herchen on 2/3/18.
 //
 
+#include "netpbm.h"
 #include "pixmap.h"
+#include "pngwriter.h"
+#include "resampler.h"
 
 namespace Sine::Graphics {
+    namespace {
+        /**
+         * Stream buffer appending to a vector, so encoders writing to streams can encode to memory without a copy.
+         */
+        class VectorBuffer : public std::streambuf {
+        private:
+            std::vector<uint8_t> &bytes;
+
+        protected:
+            int_type overflow(int_type c) override {
+                if (c != traits_type::eof()) bytes.push_back(static_cast<uint8_t>(c));
+
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(const char *s, std::streamsize n) override {
+                bytes.insert(bytes.end(), s, s + n);
+
+                return n;
+            }
+
+        public:
+            explicit VectorBuffer(std::vector<uint8_t> &_bytes) : bytes(_bytes) {
+            }
+        };
+
+        /**
+         * Callback for the stbi_write_*_to_func functions.
+         */
+        void writeToStream(void *context, void *data, int size) {
+            static_cast<std::ostream *>(context)->write(static_cast<const char *>(data), size);
+        }
+
+        /**
+         * Pixels as stbi_image_write takes them, which for Bitmaps means converting to gray.
+         */
+        template<typename PixelColor>
+        const void *stbPixels(const Pixmap<PixelColor> &image, std::vector<uint8_t> &) {
+            return image.getPixels();
+        }
+
+        const void *stbPixels(const Pixmap<bool> &image, std::vector<uint8_t> &gray) {
+            gray.resize(image.getArea());
+
+            for (long index = 0; index < image.getArea(); index++) {
+                gray[index] = image.getPixels()[index] ? 255 : 0;
+            }
+
+            return gray.data();
+        }
+    }
+
 
     template<typename PixelColor>
     Pixmap<PixelColor>::Pixmap(int w, int h) {
@@ -14,6 +69,11 @@ namespace Sine::Graphics {
         area = (width * height);
     }
 
+    template<typename PixelColor>
+    Pixmap<PixelColor>::Pixmap(int w, int h, PixelColor *p, std::function<void(PixelColor *)> d)
+            : pixels(p), deleter(std::move(d)), width(w), height(h), area(static_cast<long>(w) * h) {
+    }
+
     template<typename PixelColor>
     Pixmap<PixelColor>::Pixmap(const Pixmap<PixelColor> &p) {
         pixels = new PixelColor[p.width * p.height];
@@ -39,7 +99,9 @@ namespace Sine::Graphics {
     template<typename PixelColor>
     Pixmap<PixelColor>::Pixmap(Pixmap<PixelColor> &&p) noexcept {
         pixels = p.pixels;
+        deleter = std::move(p.deleter);
         p.pixels = nullptr;
+        p.deleter = nullptr;
 
         width = p.getWidth();
         height = p.getHeight();
@@ -49,21 +111,35 @@ namespace Sine::Graphics {
     template<typename PixelColor>
     Pixmap<PixelColor> &Pixmap<PixelColor>::operator=(Pixmap<PixelColor> &&p) noexcept {
         if (this != &p) {
-            delete[] pixels;
+            releasePixels();
 
             pixels = p.getPixels();
+            deleter = std::move(p.deleter);
             width = p.getWidth();
             height = p.getHeight();
             area = p.getArea();
 
             p.pixels = nullptr;
+            p.deleter = nullptr;
         }
         return *this;
     }
 
     template<typename PixelColor>
     Pixmap<PixelColor>::~Pixmap() {
-        delete[] pixels;
+        releasePixels();
+    }
+
+    template<typename PixelColor>
+    void Pixmap<PixelColor>::releasePixels() {
+        if (deleter) {
+            deleter(pixels);
+        } else {
+            delete[] pixels;
+        }
+
+        pixels = nullptr;
+        deleter = nullptr;
     }
 
     template<typename PixelColor>
@@ -83,7 +159,21 @@ namespace Sine::Graphics {
 
     template<typename PixelColor>
     void Pixmap<PixelColor>::setPixelPointer(void *p) {
-        pixels = static_cast<PixelColor *>(p);
+        setPixelPointer(static_cast<PixelColor *>(p), nullptr);
+    }
+
+    template<typename PixelColor>
+    void Pixmap<PixelColor>::setPixelPointer(PixelColor *p, std::function<void(PixelColor *)> d) {
+        // Same buffer: only its ownership changes, and freeing it would leave the Pixmap dangling
+        if (p == pixels) {
+            deleter = std::move(d);
+            return;
+        }
+
+        releasePixels();
+
+        pixels = p;
+        deleter = std::move(d);
     }
 
     template<typename PixelColor>
@@ -136,24 +226,7 @@ namespace Sine::Graphics {
 
     template<typename PixelColor>
     Pixmap<PixelColor> Pixmap<PixelColor>::sample(double b) const {
-
-        int newWidth = width * b;
-        int newHeight = height * b;
-
-        Pixmap<PixelColor> ret(newWidth, newHeight);
-
-        if (newWidth == width && newHeight == height) {
-            ret.copyFrom(*this);
-            return ret;
-        }
-
-        for (int i = 0; i < newWidth; i++) {
-            for (int j = 0; j < newHeight; j++) {
-                ret.setPixelUnsafe(i, j, getPixel(i / b, j / b));
-            }
-        }
-
-        return ret;
+        return Resampler::scale(*this, b, ResampleFilter::NEAREST);
     }
 
     template<typename PixelColor>
@@ -270,16 +343,73 @@ namespace Sine::Graphics {
         return true;
     }
 
+    template<typename PixelColor>
+    void Pixmap<PixelColor>::encodeTo(std::ostream &out, ImageType type, int quality) const {
+        std::vector<uint8_t> scratch;
+        int written = 1;
+
+        switch (type) {
+            case ImageType::BMP:
+                if (ColorSize == 4) {
+                    throw std::logic_error("BMP output is not implemented for RGBAMaps.");
+                }
+
+                written = stbi_write_bmp_to_func(writeToStream, &out, getWidth(), getHeight(), ColorSize,
+                                                 stbPixels(*this, scratch));
+                break;
+
+            case ImageType::JPEG:
+                written = stbi_write_jpg_to_func(writeToStream, &out, getWidth(), getHeight(), ColorSize,
+                                                 stbPixels(*this, scratch), quality);
+                break;
+
+            case ImageType::PNG:
+                PNGWriter::write(*this, out);
+                break;
+
+            case ImageType::PBM:
+            case ImageType::PGM:
+            case ImageType::PPM:
+                Netpbm::write(*this, out, type);
+                break;
+
+            case ImageType::GIF:
+                throw std::logic_error("GIF output is not implemented.");
+
+            default:
+                throw std::invalid_argument("Unknown image type.");
+        }
+
+        if (!written || !out) {
+            throw std::runtime_error("Could not encode image.");
+        }
+    }
+
+    template<typename PixelColor>
+    std::vector<uint8_t> Pixmap<PixelColor>::encode(ImageType type, int quality) const {
+        std::vector<uint8_t> ret;
+        VectorBuffer buffer(ret);
+        std::ostream out(&buffer);
+
+        encodeTo(out, type, quality);
+
+        return ret;
+    }
+
     template<>
     void Pixmap<uint8_t>::exportToBMP(std::string path) {
-        stbi_write_bmp(path.c_str(), getWidth(), getHeight(), 1,
-                       static_cast<const void *>(getPixels()));
+        if (!stbi_write_bmp(path.c_str(), getWidth(), getHeight(), 1,
+                            static_cast<const void *>(getPixels()))) {
+            throw std::runtime_error("Could not write image.");
+        }
     }
 
     template<>
     void Pixmap<uint8_t>::exportToJPEG(std::string path, int quality) {
-        stbi_write_jpg(path.c_str(), getWidth(), getHeight(), 1,
-                       static_cast<const void *>(getPixels()), quality);
+        if (!stbi_write_jpg(path.c_str(), getWidth(), getHeight(), 1,
+                            static_cast<const void *>(getPixels()), quality)) {
+            throw std::runtime_error("Could not write image.");
+        }
     }
 
     template<>
@@ -289,88 +419,22 @@ namespace Sine::Graphics {
 
     template<>
     void Pixmap<uint8_t>::exportToPNG(std::string file) {
-        stbi_write_png(file.c_str(), getWidth(), getHeight(), 1,
-                       static_cast<const void *>(getPixels()), getWidth());
+        PNGWriter::write(*this, file);
     }
 
     template<>
     void Pixmap<uint8_t>::exportToPBM(std::string path) {
-        std::ofstream file;
-        file.open(path, std::ios_base::out | std::ios_base::binary);
-
-        file << "P4\n";
-        file << std::to_string(getWidth()) << ' ' << std::to_string(getHeight())
-             << '\n';
-
-        uint8_t byteOut;
-        int bitCount;
-
-        int width = getWidth();
-
-        for (int i = 0; i < getHeight(); i++) {
-            bitCount = 0;
-            byteOut = 0;
-
-            for (int j = 0; j < width; j++) {
-                if (bitCount > 7) {
-                    file << byteOut;
-
-                    bitCount = 0;
-                    byteOut = 0;
-                }
-
-                if (getPixel(i, j) < 128) {
-                    byteOut |= 1U << (7 - bitCount);
-                }
-
-                bitCount++;
-            }
-
-            if (bitCount != 0) {
-                file << byteOut;
-            }
-        }
-
-        file.close();
+        Netpbm::write(*this, path, ImageType::PBM);
     }
 
     template<>
     void Pixmap<uint8_t>::exportToPGM(std::string path) {
-        std::ofstream file;
-        file.open(path, std::ios_base::out | std::ios_base::binary);
-
-        file << "P5\n";
-        file << std::to_string(getWidth()) << ' ' << std::to_string(getHeight())
-             << '\n';
-        file << "255";
-        file << '\n';
-
-        for (int index = 0; index < getArea(); index++) {
-            file << getPixel(index);
-        }
-
-        file.close();
+        Netpbm::write(*this, path, ImageType::PGM);
     }
 
     template<>
     void Pixmap<uint8_t>::exportToPPM(std::string path) {
-        std::ofstream file;
-        file.open(path, std::ios_base::out | std::ios_base::binary);
-
-        file << "P6\n";
-        file << std::to_string(getWidth()) << ' ' << std::to_string(getHeight())
-             << '\n';
-        file << "255";
-        file << '\n';
-
-        uint8_t c_out;
-
-        for (int index = 0; index < getArea(); index++) {
-            c_out = getPixel(index);
-            file << c_out << c_out << c_out;
-        }
-
-        file.close();
+        Netpbm::write(*this, path, ImageType::PPM);
     }
 
     template<>
@@ -402,105 +466,38 @@ namespace Sine::Graphics {
 
     template<>
     void Pixmap<bool>::exportToPNG(std::string path) {
-        Pixmap<uint8_t> temp = Pixmap<uint8_t>(getWidth(), getHeight());
-
-        for (int index = 0; index < getArea(); index++) {
-            temp.setPixel(index, (getPixelUnsafe(index) ? 255 : 0));
-        }
-
-        temp.exportToPNG(path);
+        PNGWriter::write(*this, path);
     }
 
     template<>
     void Pixmap<bool>::exportToPBM(std::string path) {
-        std::ofstream file;
-        file.open(path, std::ios_base::out | std::ios_base::binary);
-
-        file << "P4\n";
-        file << std::to_string(getWidth()) << ' ' << std::to_string(getHeight())
-             << '\n';
-
-        uint8_t byteOut;
-        int bitCount;
-
-        int width = getWidth();
-
-        for (int i = 0; i < getHeight(); i++) {
-            bitCount = 0;
-            byteOut = 0;
-
-            for (int j = 0; j < width; j++) {
-                if (bitCount > 7) {
-                    file << byteOut;
-
-                    bitCount = 0;
-                    byteOut = 0;
-                }
-
-                if (!getPixel(j, i)) {
-                    byteOut |= 1U << (7 - bitCount);
-                }
-
-                bitCount++;
-            }
-
-            if (bitCount != 0) {
-                file << byteOut;
-            }
-        }
-
-        file.close();
+        Netpbm::write(*this, path, ImageType::PBM);
     }
 
     template<>
     void Pixmap<bool>::exportToPGM(std::string path) {
-        std::ofstream file;
-        file.open(path, std::ios_base::out | std::ios_base::binary);
-
-        file << "P5\n";
-        file << std::to_string(getWidth()) << ' ' << std::to_string(getHeight())
-             << '\n';
-        file << "255";
-        file << '\n';
-
-        for (size_t index = 0; index < getArea(); index++) {
-            file << static_cast<uint8_t>(getPixel(index, false) ? 255 : 0);
-        }
-
-        file.close();
+        Netpbm::write(*this, path, ImageType::PGM);
     }
 
     template<>
     void Pixmap<bool>::exportToPPM(std::string path) {
-        std::ofstream file;
-        file.open(path, std::ios_base::out | std::ios_base::binary);
-
-        file << "P6\n";
-        file << std::to_string(getWidth()) << ' ' << std::to_string(getHeight())
-             << '\n';
-        file << "255";
-        file << '\n';
-
-        uint8_t c_out;
-
-        for (size_t index = 0; index < getArea(); index++) {
-            c_out = static_cast<uint8_t>(getPixel(index, false) ? 255 : 0);
-            file << c_out << c_out << c_out;
-        }
-
-        file.close();
+        Netpbm::write(*this, path, ImageType::PPM);
     }
 
     template<>
     void Pixmap<RGB>::exportToBMP(std::string path) {
-        stbi_write_bmp(path.c_str(), getWidth(), getHeight(), 3,
-                       static_cast<void *>(getPixels()));
+        if (!stbi_write_bmp(path.c_str(), getWidth(), getHeight(), 3,
+                            static_cast<void *>(getPixels()))) {
+            throw std::runtime_error("Could not write image.");
+        }
     }
 
     template<>
     void Pixmap<RGB>::exportToJPEG(std::string path, int quality) {
-        stbi_write_jpg(path.c_str(), getWidth(), getHeight(), 3,
-                       static_cast<void *>(getPixels()), quality);
+        if (!stbi_write_jpg(path.c_str(), getWidth(), getHeight(), 3,
+                            static_cast<void *>(getPixels()), quality)) {
+            throw std::runtime_error("Could not write image.");
+        }
     }
 
     template<>
@@ -510,39 +507,22 @@ namespace Sine::Graphics {
 
     template<>
     void Pixmap<RGB>::exportToPNG(std::string file) {
-        stbi_write_png(file.c_str(), getWidth(), getHeight(), 3,
-                       static_cast<void *>(getPixels()), 3 * getWidth());
+        PNGWriter::write(*this, file);
     }
 
     template<>
     void Pixmap<RGB>::exportToPBM(std::string path) {
-        throw std::logic_error("PBM output is not implemented for RGBMaps.");
+        Netpbm::write(*this, path, ImageType::PBM);
     }
 
     template<>
     void Pixmap<RGB>::exportToPGM(std::string path) {
-        throw std::logic_error("PGM output is not implemented for RGBMaps.");
+        Netpbm::write(*this, path, ImageType::PGM);
     }
 
     template<>
     void Pixmap<RGB>::exportToPPM(std::string path) {
-        std::ofstream file;
-        file.open(path, std::ios_base::out | std::ios_base::binary);
-
-        file << "P6\n";
-        file << std::to_string(getWidth()) << ' ' << std::to_string(getHeight())
-             << '\n';
-        file << "255";
-        file << '\n';
-
-        RGB c_out(0, 0, 0);
-
-        for (int index = 0; index < getArea(); index++) {
-            c_out = getPixel(index);
-            file << c_out.r << c_out.g << c_out.b;
-        }
-
-        file.close();
+        Netpbm::write(*this, path, ImageType::PPM);
     }
 
     template<>
@@ -552,8 +532,10 @@ namespace Sine::Graphics {
 
     template<>
     void Pixmap<RGBA>::exportToJPEG(std::string path, int quality) {
-        stbi_write_jpg(path.c_str(), getWidth(), getHeight(), 4,
-                       static_cast<void *>(getPixels()), quality);
+        if (!stbi_write_jpg(path.c_str(), getWidth(), getHeight(), 4,
+                            static_cast<void *>(getPixels()), quality)) {
+            throw std::runtime_error("Could not write image.");
+        }
     }
 
     template<>
@@ -563,23 +545,22 @@ namespace Sine::Graphics {
 
     template<>
     void Pixmap<RGBA>::exportToPNG(std::string file) {
-        stbi_write_png(file.c_str(), getWidth(), getHeight(), 4,
-                       static_cast<void *>(getPixels()), 4 * getWidth());
+        PNGWriter::write(*this, file);
     }
 
     template<>
     void Pixmap<RGBA>::exportToPBM(std::string path) {
-        throw std::logic_error("PBM output is not implemented for RGBAMaps.");
+        Netpbm::write(*this, path, ImageType::PBM);
     }
 
     template<>
     void Pixmap<RGBA>::exportToPGM(std::string path) {
-        throw std::logic_error("PGM output is not implemented for RGBAMaps.");
+        Netpbm::write(*this, path, ImageType::PGM);
     }
 
     template<>
     void Pixmap<RGBA>::exportToPPM(std::string path) {
-        throw std::logic_error("PPM output is not implemented for RGBAMaps.");
+        Netpbm::write(*this, path, ImageType::PPM);
     }
 
     template<typename PixelColor>
@@ -16,6 +16,7 @@
 
 #include <cmath>
 #include <functional>
+#include <vector>
 
 namespace Sine::Graphics {
     namespace {
@@ -206,6 +207,16 @@ namespace Sine::Graphics {
          */
         PixelColor *pixels;
 
+        /*
+         * Frees pixels which were not allocated with new[]; empty when delete[] frees them.
+         */
+        std::function<void(PixelColor *)> deleter;
+
+        /**
+         * Frees the pixels, with the deleter if there is one, and leaves the Pixmap without any.
+         */
+        void releasePixels();
+
         /*
          * Width of pixmap.
          */
@@ -236,6 +247,16 @@ namespace Sine::Graphics {
          */
         Pixmap(int width, int height);
 
+        /**
+         * Pixmap constructor adopting pixels allocated elsewhere, such as a buffer decoded by stbi_image, without
+         * copying them.
+         * @param width Pixmap width.
+         * @param height Pixmap height.
+         * @param pixels width * height pixels, owned by the Pixmap from now on.
+         * @param deleter Called with pixels once the Pixmap no longer needs them.
+         */
+        Pixmap(int width, int height, PixelColor *pixels, std::function<void(PixelColor *)> deleter);
+
         /**
          * Pixmap copy constructor.
          * @param pixmap Copied Pixmap instance.
@@ -268,7 +289,7 @@ namespace Sine::Graphics {
         PixelColor *end();
 
         /**
-         * Destructor which delete[]s pixels.
+         * Destructor which frees pixels.
          */
         ~Pixmap();
 
@@ -310,11 +331,19 @@ namespace Sine::Graphics {
         long getArea() const;
 
         /**
-         * Sets raw pixel pointer for stbi interfacing.
-         * @param p New pixel pointer.
+         * Replaces the pixels with ones allocated with new[], freeing the current ones.
+         * @param p New pixel pointer, owned by the Pixmap from now on.
          */
         void setPixelPointer(void *p);
 
+        /**
+         * Replaces the pixels with ones allocated elsewhere, freeing the current ones. Passing the current pointer
+         * keeps the pixels and only replaces the deleter.
+         * @param p New pixel pointer, owned by the Pixmap from now on.
+         * @param deleter Called with p once the Pixmap no longer needs it.
+         */
+        void setPixelPointer(PixelColor *p, std::function<void(PixelColor *)> deleter);
+
         /**
          * Returns whether an index is contained in the Pixmap.
          * @param index Checked index.
@@ -517,7 +546,23 @@ namespace Sine::Graphics {
                           ImageType type = ImageType::UNKNOWN);
 
         /**
-         * Subsample the Pixmap and return a new Pixmap.
+         * Encode to a stream, as exportToFile would write a file. Bitmaps are encoded as gray, except as PBM.
+         * @param out Stream receiving the encoded image.
+         * @param type Type of image.
+         * @param quality Quality of JPEG output as a percentage; ignored by other types.
+         */
+        void encodeTo(std::ostream &out, ImageType type, int quality = 90) const;
+
+        /**
+         * Encode to memory, as exportToFile would write a file.
+         * @param type Type of image.
+         * @param quality Quality of JPEG output as a percentage; ignored by other types.
+         * @return Encoded image.
+         */
+        std::vector<uint8_t> encode(ImageType type, int quality = 90) const;
+
+        /**
+         * Resample the Pixmap with nearest-neighbor filtering and return a new Pixmap; see Resampler for other filters.
          * @param x Factor to subsample by.
          * @return Subsampled Pixmap.
          */
@@ -0,0 +1,312 @@
+#include "pngwriter.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace Sine::Graphics {
+    namespace {
+        /*
+         * Bytes of filtered data deflated as one piece, as in pigz.
+         */
+        const size_t PIECE = 128 * 1024;
+
+        const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+        void putBigEndian(uint8_t *out, uint32_t value) {
+            out[0] = value >> 24;
+            out[1] = value >> 16;
+            out[2] = value >> 8;
+            out[3] = value;
+        }
+
+        inline uint8_t paeth(int a, int b, int c) {
+            int p = a + b - c;
+            int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+
+            return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+        }
+
+        /**
+         * Applies one of the five PNG filters to a row.
+         * @param row Row to filter.
+         * @param prior Row above, zeros for the first row.
+         * @param bpp Bytes per pixel.
+         * @param out n filtered bytes.
+         */
+        void filterRow(int type, const uint8_t *row, const uint8_t *prior, size_t n, int bpp, uint8_t *out) {
+            switch (type) {
+                case 0:
+                    std::memcpy(out, row, n);
+                    break;
+
+                case 1:
+                    for (size_t i = 0; i < n; i++) out[i] = row[i] - (i >= static_cast<size_t>(bpp) ? row[i - bpp] : 0);
+                    break;
+
+                case 2:
+                    for (size_t i = 0; i < n; i++) out[i] = row[i] - prior[i];
+                    break;
+
+                case 3:
+                    for (size_t i = 0; i < n; i++) {
+                        int left = i >= static_cast<size_t>(bpp) ? row[i - bpp] : 0;
+                        out[i] = row[i] - ((left + prior[i]) >> 1);
+                    }
+                    break;
+
+                default:
+                    for (size_t i = 0; i < n; i++) {
+                        bool hasLeft = i >= static_cast<size_t>(bpp);
+                        out[i] = row[i] - paeth(hasLeft ? row[i - bpp] : 0, prior[i], hasLeft ? prior[i - bpp] : 0);
+                    }
+            }
+        }
+
+        /**
+         * Sum of filtered bytes read as signed, the usual estimate of how well a row compresses.
+         */
+        uint64_t cost(const uint8_t *filtered, size_t n) {
+            uint64_t sum = 0;
+
+            for (size_t i = 0; i < n; i++) sum += std::abs(static_cast<int8_t>(filtered[i]));
+
+            return sum;
+        }
+    }
+
+    PNGWriter::PNGWriter(const std::string &path, int _width, int _height, int _channels, Deflate::Level _level,
+                         unsigned int _threads)
+            : file(path, std::ios_base::out | std::ios_base::binary), out(&file), width(_width), height(_height),
+              channels(_channels), level(_level), threads(std::max(_threads, 1U)) {
+        if (!file) {
+            throw std::runtime_error("Could not open PNG file for writing.");
+        }
+
+        writeHeader();
+    }
+
+    PNGWriter::PNGWriter(std::ostream &_out, int _width, int _height, int _channels, Deflate::Level _level,
+                         unsigned int _threads)
+            : out(&_out), width(_width), height(_height), channels(_channels), level(_level),
+              threads(std::max(_threads, 1U)) {
+        writeHeader();
+    }
+
+    PNGWriter::~PNGWriter() {
+        if (finished || rowsWritten != height) return;
+
+        try {
+            finish();
+        } catch (...) {
+        }
+    }
+
+    void PNGWriter::writeHeader() {
+        if (width <= 0 || height <= 0) {
+            throw std::invalid_argument("PNG dimensions must be positive.");
+        }
+
+        if (channels < 1 || channels > 4) {
+            throw std::invalid_argument("PNG images have 1 to 4 channels.");
+        }
+
+        rowBytes = static_cast<size_t>(width) * channels;
+        previousRow.assign(rowBytes, 0);
+
+        static const uint8_t COLOR_TYPES[4] = {0, 4, 2, 6};
+
+        uint8_t header[13];
+        putBigEndian(header, width);
+        putBigEndian(header + 4, height);
+        header[8] = 8;
+        header[9] = COLOR_TYPES[channels - 1];
+        header[10] = header[11] = header[12] = 0;
+
+        out->write(reinterpret_cast<const char *>(SIGNATURE), sizeof(SIGNATURE));
+        writeChunk("IHDR", header, sizeof(header));
+    }
+
+    void PNGWriter::writeChunk(const char *type, const uint8_t *data, size_t length) {
+        uint8_t prefix[8];
+        putBigEndian(prefix, length);
+        std::memcpy(prefix + 4, type, 4);
+
+        uint8_t crc[4];
+        putBigEndian(crc, Deflate::crc32(data, length, Deflate::crc32(prefix + 4, 4)));
+
+        out->write(reinterpret_cast<const char *>(prefix), 8);
+        out->write(reinterpret_cast<const char *>(data), length);
+        out->write(reinterpret_cast<const char *>(crc), 4);
+
+        if (!*out) {
+            throw std::runtime_error("Could not write PNG.");
+        }
+    }
+
+    void PNGWriter::writeRow(const uint8_t *row) {
+        if (finished || rowsWritten >= height) {
+            throw std::logic_error("All rows of the PNG were already written.");
+        }
+
+        rows.insert(rows.end(), row, row + rowBytes);
+        rowsWritten++;
+
+        if (rows.size() >= threads * PIECE) flush(false);
+    }
+
+    void PNGWriter::writeRows(const uint8_t *data, int count) {
+        for (int i = 0; i < count; i++) writeRow(data + i * rowBytes);
+    }
+
+    void PNGWriter::flush(bool last) {
+        size_t count = rows.size() / rowBytes;
+        size_t stride = rowBytes + 1;
+        size_t start = history.size();
+
+        // The filtered rows follow the history, so every piece finds its history right before it
+        std::vector<uint8_t> filtered(start + count * stride);
+        std::copy(history.begin(), history.end(), filtered.begin());
+
+        Parallel::parallelBands(0, count, [&](int r1, int r2) {
+            std::vector<uint8_t> candidate(rowBytes);
+
+            for (int r = r1; r < r2; r++) {
+                const uint8_t *row = &rows[r * rowBytes];
+                const uint8_t *prior = r > 0 ? row - rowBytes : previousRow.data();
+                uint8_t *outRow = &filtered[start + r * stride];
+
+                int best = 0;
+
+                if (level != Deflate::Level::STORE) {
+                    uint64_t bestCost = UINT64_MAX;
+
+                    for (int type = 0; type < 5; type++) {
+                        filterRow(type, row, prior, rowBytes, channels, candidate.data());
+                        uint64_t c = cost(candidate.data(), rowBytes);
+
+                        if (c < bestCost) {
+                            bestCost = c;
+                            best = type;
+                            std::copy(candidate.begin(), candidate.end(), outRow + 1);
+                        }
+                    }
+                } else {
+                    std::copy(row, row + rowBytes, outRow + 1);
+                }
+
+                outRow[0] = best;
+            }
+        }, threads);
+
+        size_t length = count * stride;
+        size_t pieces = (length + PIECE - 1) / PIECE;
+
+        std::vector<std::vector<uint8_t>> compressed(pieces);
+        std::vector<uint32_t> checksums(pieces);
+
+        Parallel::parallelFor(0, pieces, [&](int p) {
+            size_t offset = start + p * PIECE;
+            size_t n = std::min(PIECE, length - p * PIECE);
+
+            Deflate::compress(&filtered[offset], n, std::min(offset, Deflate::WINDOW), level, compressed[p]);
+            checksums[p] = Deflate::adler32(&filtered[offset], n);
+        }, threads);
+
+        std::vector<uint8_t> data;
+
+        if (!started) {
+            data = Deflate::zlibHeader(level);
+            started = true;
+        }
+
+        for (size_t p = 0; p < pieces; p++) {
+            data.insert(data.end(), compressed[p].begin(), compressed[p].end());
+            adler = Deflate::adler32Combine(adler, checksums[p], std::min(PIECE, length - p * PIECE));
+        }
+
+        if (last) {
+            Deflate::finish(data);
+
+            uint8_t trailer[4];
+            putBigEndian(trailer, adler);
+            data.insert(data.end(), trailer, trailer + 4);
+        }
+
+        if (!data.empty()) writeChunk("IDAT", data.data(), data.size());
+
+        // Keep what the next batch needs
+        size_t kept = std::min(filtered.size(), Deflate::WINDOW);
+        history.assign(filtered.end() - kept, filtered.end());
+
+        if (count > 0) previousRow.assign(rows.end() - rowBytes, rows.end());
+        rows.clear();
+    }
+
+    void PNGWriter::finish() {
+        if (finished) return;
+
+        if (rowsWritten != height) {
+            throw std::logic_error("Not every row of the PNG was written.");
+        }
+
+        flush(true);
+        writeChunk("IEND", nullptr, 0);
+        out->flush();
+
+        finished = true;
+    }
+
+    int PNGWriter::getRowsWritten() const {
+        return rowsWritten;
+    }
+
+    template<typename T>
+    void PNGWriter::write(const Pixmap<T> &image, const std::string &path, Deflate::Level level) {
+        std::ofstream file(path, std::ios_base::out | std::ios_base::binary);
+
+        if (!file) {
+            throw std::runtime_error("Could not open PNG file for writing.");
+        }
+
+        write(image, file, level);
+    }
+
+    template<typename T>
+    void PNGWriter::write(const Pixmap<T> &image, std::ostream &out, Deflate::Level level) {
+        PNGWriter writer(out, image.getWidth(), image.getHeight(), sizeof(T), level);
+
+        writer.writeRows(reinterpret_cast<const uint8_t *>(image.getPixels()), image.getHeight());
+        writer.finish();
+    }
+
+    template<>
+    void PNGWriter::write(const Pixmap<bool> &image, std::ostream &out, Deflate::Level level) {
+        PNGWriter writer(out, image.getWidth(), image.getHeight(), 1, level);
+        std::vector<uint8_t> row(image.getWidth());
+
+        for (int y = 0; y < image.getHeight(); y++) {
+            const bool *in = image.getPixels() + static_cast<size_t>(y) * image.getWidth();
+
+            for (int x = 0; x < image.getWidth(); x++) row[x] = in[x] ? 255 : 0;
+
+            writer.writeRow(row.data());
+        }
+
+        writer.finish();
+    }
+
+    // Explicit template instantiation
+    template void PNGWriter::write(const Pixmap<bool> &, const std::string &, Deflate::Level);
+
+    template void PNGWriter::write(const Pixmap<uint8_t> &, const std::string &, Deflate::Level);
+
+    template void PNGWriter::write(const Pixmap<RGB> &, const std::string &, Deflate::Level);
+
+    template void PNGWriter::write(const Pixmap<RGBA> &, const std::string &, Deflate::Level);
+
+    template void PNGWriter::write(const Pixmap<uint8_t> &, std::ostream &, Deflate::Level);
+
+    template void PNGWriter::write(const Pixmap<RGB> &, std::ostream &, Deflate::Level);
+
+    template void PNGWriter::write(const Pixmap<RGBA> &, std::ostream &, Deflate::Level);
+}
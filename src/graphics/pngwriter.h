@@ -0,0 +1,136 @@
+#ifndef VISUALIZATION_PNGWRITER_H
+#define VISUALIZATION_PNGWRITER_H
+
+#include "deflate.h"
+#include "pixmap.h"
+#include "parallel.h"
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Sine::Graphics {
+    /**
+     * PNG encoder which takes rows incrementally, so images never need to be held whole.
+     *
+     * Rows are buffered until there are enough to keep every thread busy. Each batch is then filtered in parallel,
+     * choosing for every row the PNG filter with the smallest sum of absolute filtered values, and cut into pieces
+     * which are deflated in parallel, each seeing the 32 KiB before it as history so little compression is lost. The
+     * pieces form one IDAT chunk per batch, written before the next batch is buffered.
+     */
+    class PNGWriter {
+    private:
+        std::ofstream file;
+        std::ostream *out;
+
+        int width;
+        int height;
+        int channels;
+        Deflate::Level level;
+        unsigned int threads;
+
+        int rowsWritten = 0;
+        bool started = false; ///< Whether the zlib header was written
+        bool finished = false;
+
+        size_t rowBytes;
+        std::vector<uint8_t> rows; ///< Unfiltered rows of the current batch
+        std::vector<uint8_t> previousRow; ///< Last row of the previous batch, which the first row is filtered against
+        std::vector<uint8_t> history; ///< Last filtered bytes of the previous batch
+        uint32_t adler = 1;
+
+        void writeHeader();
+
+        void writeChunk(const char *type, const uint8_t *data, size_t length);
+
+        /**
+         * Filters and compresses the buffered rows, and writes them as an IDAT chunk.
+         * @param last Whether this ends the image.
+         */
+        void flush(bool last);
+
+    public:
+        /**
+         * Constructor writing to a file.
+         * @param path Path of the file.
+         * @param width Width in pixels.
+         * @param height Height in pixels.
+         * @param channels 1 for gray, 2 for gray and alpha, 3 for RGB or 4 for RGBA, 8 bits each.
+         * @param level Compression effort.
+         * @param threads Maximum number of threads to compress with.
+         */
+        PNGWriter(const std::string &path, int width, int height, int channels,
+                  Deflate::Level level = Deflate::Level::DEFAULT, unsigned int threads = Parallel::threadCount());
+
+        /**
+         * Constructor writing to a stream, which must outlive the writer.
+         * @param out Stream.
+         * @param width Width in pixels.
+         * @param height Height in pixels.
+         * @param channels 1 for gray, 2 for gray and alpha, 3 for RGB or 4 for RGBA, 8 bits each.
+         * @param level Compression effort.
+         * @param threads Maximum number of threads to compress with.
+         */
+        PNGWriter(std::ostream &out, int width, int height, int channels,
+                  Deflate::Level level = Deflate::Level::DEFAULT, unsigned int threads = Parallel::threadCount());
+
+        PNGWriter(const PNGWriter &) = delete;
+
+        PNGWriter &operator=(const PNGWriter &) = delete;
+
+        /**
+         * Destructor, which finishes the image if every row was written. Errors are lost; call finish() to see them.
+         */
+        ~PNGWriter();
+
+        /**
+         * Writes the next row.
+         * @param row width * channels bytes.
+         */
+        void writeRow(const uint8_t *row);
+
+        /**
+         * Writes the next rows.
+         * @param data count rows of width * channels bytes each, one after another.
+         * @param count Number of rows.
+         */
+        void writeRows(const uint8_t *data, int count);
+
+        /**
+         * Writes the last batch and the end of the image. Every row must have been written.
+         */
+        void finish();
+
+        /**
+         * Getter for rows written.
+         * @return Number of rows written so far.
+         */
+        int getRowsWritten() const;
+
+        /**
+         * Writes a whole Pixmap to a file. Bitmaps are written as gray.
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param path Path of the file.
+         * @param level Compression effort.
+         */
+        template<typename T>
+        static void write(const Pixmap<T> &image, const std::string &path,
+                          Deflate::Level level = Deflate::Level::DEFAULT);
+
+        /**
+         * Writes a whole Pixmap to a stream. Bitmaps are written as gray.
+         * @tparam T Pixel type.
+         * @param image Image.
+         * @param out Stream.
+         * @param level Compression effort.
+         */
+        template<typename T>
+        static void write(const Pixmap<T> &image, std::ostream &out, Deflate::Level level = Deflate::Level::DEFAULT);
+    };
+
+    template<>
+    void PNGWriter::write(const Pixmap<bool> &image, std::ostream &out, Deflate::Level level);
+}
+
+#endif //VISUALIZATION_PNGWRITER_H
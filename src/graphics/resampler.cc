@@ -0,0 +1,270 @@
+#include "resampler.h"
+#include "filters/channels.h"
+#include "simd/kernels.h"
+#include "math/mathutils.h"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace Sine::Graphics {
+    namespace {
+        /**
+         * Channels pixels are filtered in: those of Filters::ChannelTraits, except for RGBA.
+         */
+        template<typename T>
+        struct Channels : Filters::ChannelTraits<T> {
+        };
+
+        /**
+         * RGBA is filtered premultiplied, so the color of transparent pixels does not bleed into their neighbors. The
+         * straight channels are filtered too, for areas that end up fully transparent.
+         */
+        template<>
+        struct Channels<RGBA> {
+            // Premultiplied r, g, b, then straight r, g, b, a
+            static constexpr int count = 7;
+
+            static void load(const RGBA &p, float *c) {
+                Filters::ChannelTraits<RGBA>::load(p, c + 3);
+
+                float a = p.a / 255.0f;
+
+                c[0] = c[3] * a;
+                c[1] = c[4] * a;
+                c[2] = c[5] * a;
+            }
+
+            static RGBA store(const float *c) {
+                if (Filters::toByte(c[6]) == 0) {
+                    return Filters::ChannelTraits<RGBA>::store(c + 3);
+                }
+
+                float f = 255.0f / c[6];
+                float straight[4] = {c[0] * f, c[1] * f, c[2] * f, c[6]};
+
+                return Filters::ChannelTraits<RGBA>::store(straight);
+            }
+        };
+
+        /**
+         * Filter weights along one axis: destination pixel i is the sum over k < taps of
+         * weights[i * taps + k] * source[starts[i] + k].
+         */
+        struct Weights {
+            std::vector<int> starts;
+            std::vector<float> weights;
+            int taps;
+        };
+
+        float sinc(float x) {
+            if (x == 0) return 1;
+
+            x *= static_cast<float>(Math::MathUtils::PI);
+            return std::sin(x) / x;
+        }
+
+        /**
+         * Evaluates a filter kernel.
+         * @param filter Filter kind, other than NEAREST and BOX.
+         * @param x Distance from the center in source pixels, unscaled.
+         * @return Kernel value.
+         */
+        float kernel(ResampleFilter filter, float x) {
+            x = std::abs(x);
+
+            switch (filter) {
+                case ResampleFilter::BILINEAR:
+                    return std::max(1 - x, 0.0f);
+                case ResampleFilter::BICUBIC: // Catmull-Rom, a = -0.5
+                    if (x < 1) return (1.5f * x - 2.5f) * x * x + 1;
+                    if (x < 2) return ((-0.5f * x + 2.5f) * x - 4) * x + 2;
+                    return 0;
+                case ResampleFilter::LANCZOS3:
+                    return x < 3 ? sinc(x) * sinc(x / 3) : 0;
+                default:
+                    return 0;
+            }
+        }
+
+        float radius(ResampleFilter filter) {
+            switch (filter) {
+                case ResampleFilter::BILINEAR:
+                    return 1;
+                case ResampleFilter::BICUBIC:
+                    return 2;
+                case ResampleFilter::LANCZOS3:
+                    return 3;
+                default:
+                    return 0.5f;
+            }
+        }
+
+        Weights computeWeights(int sourceSize, int size, ResampleFilter filter) {
+            double ratio = static_cast<double>(sourceSize) / size;
+
+            // Widen the filter when downscaling so it covers every source pixel
+            float filterScale = std::max(ratio, 1.0);
+            float support = radius(filter) * filterScale;
+
+            Weights w;
+            w.taps = static_cast<int>(std::ceil(support * 2)) + 2;
+            w.starts.resize(size);
+            w.weights.assign(static_cast<size_t>(size) * w.taps, 0);
+
+            for (int i = 0; i < size; i++) {
+                float center = (i + 0.5) * ratio;
+
+                int start = std::max(static_cast<int>(std::floor(center - support)), 0);
+                int end = std::min(static_cast<int>(std::ceil(center + support)), sourceSize);
+                end = std::min(end, start + w.taps);
+
+                float *weights = &w.weights[static_cast<size_t>(i) * w.taps];
+                float total = 0;
+
+                for (int j = start; j < end; j++) {
+                    float weight;
+
+                    if (filter == ResampleFilter::BOX) { // Exact overlap of [j, j + 1) with the covered area
+                        weight = std::max(std::min(j + 1.0f, center + support) - std::max<float>(j, center - support),
+                                          0.0f);
+                    } else {
+                        weight = kernel(filter, (j + 0.5f - center) / filterScale);
+                    }
+
+                    weights[j - start] = weight;
+                    total += weight;
+                }
+
+                if (total != 0) {
+                    for (int k = 0; k < end - start; k++) {
+                        weights[k] /= total;
+                    }
+                }
+
+                // Keep every tap inside the source, the trailing zero weights then read valid pixels
+                w.starts[i] = std::max(std::min(start, sourceSize - w.taps), 0);
+
+                if (w.starts[i] != start) {
+                    std::rotate(weights, weights + (w.taps - (start - w.starts[i])), weights + w.taps);
+                }
+            }
+
+            return w;
+        }
+    }
+
+    template<typename T>
+    Pixmap<T> Resampler::resample(const Pixmap<T> &image, int width, int height, ResampleFilter filter,
+                                  unsigned int threads) {
+        if (width < 0 || height < 0) {
+            throw std::invalid_argument("Resampled dimensions must be nonnegative.");
+        }
+
+        Pixmap<T> ret(width, height);
+
+        int sourceWidth = image.getWidth();
+        int sourceHeight = image.getHeight();
+
+        if (ret.getArea() == 0 || image.getArea() == 0) return ret;
+
+        const T *source = image.getPixels();
+        T *dest = ret.getPixels();
+
+        if (filter == ResampleFilter::NEAREST) {
+            std::vector<int> columns(width);
+
+            for (int i = 0; i < width; i++) {
+                columns[i] = std::min(static_cast<int>((i + 0.5) * sourceWidth / width), sourceWidth - 1);
+            }
+
+            Parallel::parallelFor(0, height, [&](int j) {
+                int row = std::min(static_cast<int>((j + 0.5) * sourceHeight / height), sourceHeight - 1);
+
+                for (int i = 0; i < width; i++) {
+                    dest[j * width + i] = source[image.pairToIndex(columns[i], row)];
+                }
+            }, threads);
+
+            return ret;
+        }
+
+        constexpr int C = Channels<T>::count;
+
+        Weights horizontal = computeWeights(sourceWidth, width, filter);
+        Weights vertical = computeWeights(sourceHeight, height, filter);
+
+        // Horizontal pass: every source row is narrowed to the destination width
+        std::vector<float> narrowed(static_cast<size_t>(sourceHeight) * width * C);
+
+        Parallel::parallelFor(0, sourceHeight, [&](int y) {
+            // Padded to the tap count, since the taps of an image narrower than the filter run past its edge
+            std::vector<float> row(static_cast<size_t>(std::max(sourceWidth, horizontal.taps)) * C, 0);
+
+            for (int x = 0; x < sourceWidth; x++) {
+                Channels<T>::load(source[image.pairToIndex(x, y)], &row[static_cast<size_t>(x) * C]);
+            }
+
+            float *out = &narrowed[static_cast<size_t>(y) * width * C];
+
+            for (int i = 0; i < width; i++) {
+                const float *weights = &horizontal.weights[static_cast<size_t>(i) * horizontal.taps];
+                const float *in = &row[static_cast<size_t>(horizontal.starts[i]) * C];
+
+                float sum[C] = {};
+
+                for (int k = 0; k < horizontal.taps; k++) {
+                    for (int c = 0; c < C; c++) {
+                        sum[c] += weights[k] * in[k * C + c];
+                    }
+                }
+
+                std::copy(sum, sum + C, out + static_cast<size_t>(i) * C);
+            }
+        }, threads);
+
+        // Vertical pass: rows are accumulated whole, so the inner loop runs along contiguous memory
+        const Simd::PixelKernels &kernels = Simd::pixelKernels();
+
+        Parallel::parallelFor(0, height, [&](int j) {
+            std::vector<float> sum(static_cast<size_t>(width) * C, 0);
+            const float *weights = &vertical.weights[static_cast<size_t>(j) * vertical.taps];
+
+            for (int k = 0; k < vertical.taps; k++) {
+                float weight = weights[k];
+                if (weight == 0) continue;
+
+                kernels.accumulate(sum.data(), &narrowed[static_cast<size_t>(vertical.starts[j] + k) * width * C],
+                                   weight, sum.size());
+            }
+
+            for (int i = 0; i < width; i++) {
+                dest[j * width + i] = Channels<T>::store(&sum[static_cast<size_t>(i) * C]);
+            }
+        }, threads);
+
+        return ret;
+    }
+
+    template<typename T>
+    Pixmap<T> Resampler::scale(const Pixmap<T> &image, double factor, ResampleFilter filter, unsigned int threads) {
+        return resample(image, static_cast<int>(image.getWidth() * factor),
+                        static_cast<int>(image.getHeight() * factor), filter, threads);
+    }
+
+    // Explicit template instantiation
+    template Bitmap Resampler::resample(const Bitmap &, int, int, ResampleFilter, unsigned int);
+
+    template Graymap Resampler::resample(const Graymap &, int, int, ResampleFilter, unsigned int);
+
+    template RGBMap Resampler::resample(const RGBMap &, int, int, ResampleFilter, unsigned int);
+
+    template RGBAMap Resampler::resample(const RGBAMap &, int, int, ResampleFilter, unsigned int);
+
+    template Bitmap Resampler::scale(const Bitmap &, double, ResampleFilter, unsigned int);
+
+    template Graymap Resampler::scale(const Graymap &, double, ResampleFilter, unsigned int);
+
+    template RGBMap Resampler::scale(const RGBMap &, double, ResampleFilter, unsigned int);
+
+    template RGBAMap Resampler::scale(const RGBAMap &, double, ResampleFilter, unsigned int);
+}
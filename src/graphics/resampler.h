@@ -0,0 +1,58 @@
+#ifndef VISUALIZATION_RESAMPLER_H
+#define VISUALIZATION_RESAMPLER_H
+
+#include "pixmap.h"
+#include "parallel.h"
+
+namespace Sine::Graphics {
+    /**
+     * Reconstruction filter used when resampling.
+     */
+    enum class ResampleFilter {
+        NEAREST, ///< Copy the closest source pixel
+        BOX, ///< Average the source area covered by each destination pixel
+        BILINEAR, ///< Triangle filter, radius 1
+        BICUBIC, ///< Catmull-Rom cubic, radius 2
+        LANCZOS3 ///< Windowed sinc, radius 3
+    };
+
+    /**
+     * Separable image resampler.
+     *
+     * The filter weights of every destination column and row are computed once up front; the image is then filtered
+     * horizontally and vertically in two passes, each spread across threads. When downscaling, the filters are
+     * widened by the scale factor so every source pixel contributes. RGBAMaps are filtered in premultiplied alpha.
+     */
+    class Resampler {
+    public:
+        /**
+         * Resamples a Pixmap to given dimensions.
+         * @tparam T Pixel type of Pixmap.
+         * @param image Source image.
+         * @param width Destination width.
+         * @param height Destination height.
+         * @param filter Reconstruction filter.
+         * @param threads Maximum number of threads to use.
+         * @return Resampled Pixmap.
+         */
+        template<typename T>
+        static Pixmap<T> resample(const Pixmap<T> &image, int width, int height,
+                                  ResampleFilter filter = ResampleFilter::BOX,
+                                  unsigned int threads = Parallel::threadCount());
+
+        /**
+         * Resamples a Pixmap by a scale factor, truncating the new dimensions.
+         * @tparam T Pixel type of Pixmap.
+         * @param image Source image.
+         * @param factor Scale factor.
+         * @param filter Reconstruction filter.
+         * @param threads Maximum number of threads to use.
+         * @return Resampled Pixmap.
+         */
+        template<typename T>
+        static Pixmap<T> scale(const Pixmap<T> &image, double factor, ResampleFilter filter = ResampleFilter::BOX,
+                               unsigned int threads = Parallel::threadCount());
+    };
+}
+
+#endif //VISUALIZATION_RESAMPLER_H
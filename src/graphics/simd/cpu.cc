@@ -0,0 +1,90 @@
+#include "cpu.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define SINE_SIMD_X86
+#endif
+
+namespace Sine::Graphics {
+    namespace Simd {
+        namespace {
+            const char *NAMES[LEVEL_COUNT] = {"scalar", "sse2", "sse4.1", "avx2", "avx512"};
+
+#ifdef SINE_SIMD_X86
+            /**
+             * Register state the operating system saves on context switches, which vector registers need.
+             */
+            uint64_t xgetbv() {
+                uint32_t eax, edx;
+                __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+
+                return (static_cast<uint64_t>(edx) << 32) | eax;
+            }
+#endif
+
+            Level detect() {
+#ifdef SINE_SIMD_X86
+                unsigned int eax, ebx, ecx, edx;
+
+                if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & bit_SSE2)) return Level::SCALAR;
+                if (!(ecx & bit_SSE4_1)) return Level::SSE2;
+
+                // AVX state must be enabled by the operating system, not just present
+                bool osAVX = (ecx & bit_OSXSAVE) && (ecx & bit_AVX) && (xgetbv() & 0x6) == 0x6;
+
+                if (!osAVX || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2)) {
+                    return Level::SSE41;
+                }
+
+                // Also opmask and upper ZMM state
+                if ((ebx & bit_AVX512F) && (ebx & bit_AVX512BW) && (xgetbv() & 0xe6) == 0xe6) return Level::AVX512;
+
+                return Level::AVX2;
+#else
+                return Level::SCALAR;
+#endif
+            }
+
+            Level initialLevel() {
+                Level level = detectedLevel();
+                const char *forced = std::getenv("SINE_SIMD");
+
+                if (!forced || !*forced) return level;
+
+                for (int i = 0; i < LEVEL_COUNT; i++) {
+                    if (std::strcmp(forced, NAMES[i]) == 0) return std::min(static_cast<Level>(i), level);
+                }
+
+                throw std::invalid_argument("SINE_SIMD must be scalar, sse2, sse4.1, avx2 or avx512.");
+            }
+
+            std::atomic<Level> &active() {
+                static std::atomic<Level> level(initialLevel());
+                return level;
+            }
+        }
+
+        Level detectedLevel() {
+            static const Level level = detect();
+            return level;
+        }
+
+        Level activeLevel() {
+            return active().load(std::memory_order_relaxed);
+        }
+
+        void setActiveLevel(Level level) {
+            active().store(std::min(level, detectedLevel()), std::memory_order_relaxed);
+        }
+
+        const char *levelName(Level level) {
+            return NAMES[static_cast<int>(level)];
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef VISUALIZATION_CPU_H
+#define VISUALIZATION_CPU_H
+
+namespace Sine::Graphics {
+    namespace Simd {
+        /**
+         * Instruction set levels kernels are compiled for, in increasing order. Each level implies the ones below.
+         */
+        enum class Level {
+            SCALAR, ///< No vector instructions
+            SSE2,
+            SSE41, ///< SSE4.1
+            AVX2,
+            AVX512 ///< AVX-512 F and BW
+        };
+
+        /**
+         * Number of levels.
+         */
+        const int LEVEL_COUNT = 5;
+
+        /**
+         * Highest level the processor and operating system support, detected with cpuid on first use.
+         * @return Detected level.
+         */
+        Level detectedLevel();
+
+        /**
+         * Level kernels are dispatched for. Defaults to the detected level, or to the level named by the SINE_SIMD
+         * environment variable (scalar, sse2, sse4.1, avx2 or avx512) if it is lower. The variable is read on first
+         * use; any other non-empty value is an error, so a mistyped level does not silently test the detected one.
+         * @return Active level.
+         * @throws std::invalid_argument If SINE_SIMD names no level.
+         */
+        Level activeLevel();
+
+        /**
+         * Overrides the level kernels are dispatched for, e.g. to test every level on one machine. Levels above the
+         * detected one are lowered to it.
+         * @param level Level.
+         */
+        void setActiveLevel(Level level);
+
+        /**
+         * Name of a level, as accepted by SINE_SIMD.
+         * @param level Level.
+         * @return Name.
+         */
+        const char *levelName(Level level);
+    }
+}
+
+#endif //VISUALIZATION_CPU_H
@@ -0,0 +1,29 @@
+#include "kernels.h"
+
+namespace Sine::Graphics {
+    namespace Simd {
+        // Defined by the per-level translation units
+        extern const PixelKernels *const PIXEL_KERNELS_SCALAR;
+        extern const PixelKernels *const PIXEL_KERNELS_SSE2;
+        extern const PixelKernels *const PIXEL_KERNELS_SSE41;
+        extern const PixelKernels *const PIXEL_KERNELS_AVX2;
+        extern const PixelKernels *const PIXEL_KERNELS_AVX512;
+
+        namespace {
+            const Dispatch<PixelKernels> &pixelDispatch() {
+                static const Dispatch<PixelKernels> dispatch(PIXEL_KERNELS_SCALAR, PIXEL_KERNELS_SSE2,
+                                                             PIXEL_KERNELS_SSE41, PIXEL_KERNELS_AVX2,
+                                                             PIXEL_KERNELS_AVX512);
+                return dispatch;
+            }
+        }
+
+        const PixelKernels &pixelKernels() {
+            return pixelDispatch().get();
+        }
+
+        const PixelKernels &pixelKernels(Level level) {
+            return pixelDispatch().at(level);
+        }
+    }
+}
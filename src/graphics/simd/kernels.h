@@ -0,0 +1,103 @@
+#ifndef VISUALIZATION_KERNELS_H
+#define VISUALIZATION_KERNELS_H
+
+#include "cpu.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Sine::Graphics {
+    namespace Simd {
+        /**
+         * Function table of one kernel family for each level. Levels the build did not compile a table for are
+         * null, and resolve to the next level down.
+         * @tparam Table Struct of function pointers.
+         */
+        template<typename Table>
+        class Dispatch {
+        private:
+            const Table *tables[LEVEL_COUNT];
+
+        public:
+            /**
+             * Constructor.
+             * @param scalar Scalar table, which must not be null.
+             * @param sse2 SSE2 table.
+             * @param sse41 SSE4.1 table.
+             * @param avx2 AVX2 table.
+             * @param avx512 AVX-512 table.
+             */
+            Dispatch(const Table *scalar, const Table *sse2, const Table *sse41, const Table *avx2,
+                     const Table *avx512) : tables{scalar, sse2, sse41, avx2, avx512} {
+            }
+
+            /**
+             * Table for a level.
+             * @param level Level.
+             * @return Table of the highest compiled level not above it.
+             */
+            const Table &at(Level level) const {
+                int i = static_cast<int>(level);
+                while (!tables[i]) i--;
+
+                return *tables[i];
+            }
+
+            /**
+             * Table for the active level.
+             * @return Table.
+             */
+            const Table &get() const {
+                return at(activeLevel());
+            }
+        };
+
+        /**
+         * Inner loops of the convolution filters and the gradient operators.
+         */
+        struct PixelKernels {
+            /**
+             * sum[i] += weight * in[i] for i below n.
+             */
+            void (*accumulate)(float *sum, const float *in, float weight, size_t n);
+
+            /**
+             * sum[i] += weight * in[i] for i below n, on bytes with fixed point weights.
+             */
+            void (*accumulateFixed)(int32_t *sum, const uint8_t *in, int32_t weight, size_t n);
+
+            /**
+             * sum[i] += weight * in[i] for i below n, on signed 16-bit fixed point intermediates.
+             */
+            void (*accumulateFixed16)(int32_t *sum, const int16_t *in, int32_t weight, size_t n);
+
+            /**
+             * Splits n interleaved RGBA pixels into planar rows of premultiplied r, g and b, each c * a - 32768 so it
+             * fits in 16 bits, and of alpha.
+             */
+            void (*premultiply)(int16_t *r, int16_t *g, int16_t *b, int16_t *a, const uint8_t *rgba, size_t n);
+
+            /**
+             * out[i] = outer * (plus0[i] - minus0[i]) + center * (plus1[i] - minus1[i])
+             * + outer * (plus2[i] - minus2[i]) for i below n, a 3x3 derivative stencil.
+             */
+            void (*derivative)(float *out, const float *plus0, const float *minus0, const float *plus1,
+                               const float *minus1, const float *plus2, const float *minus2, float outer, float center,
+                               size_t n);
+        };
+
+        /**
+         * Pixel kernels for the active level.
+         * @return Function table.
+         */
+        const PixelKernels &pixelKernels();
+
+        /**
+         * Pixel kernels for a level.
+         * @param level Level.
+         * @return Function table of the highest compiled level not above it.
+         */
+        const PixelKernels &pixelKernels(Level level);
+    }
+}
+
+#endif //VISUALIZATION_KERNELS_H
@@ -0,0 +1,16 @@
+#include "kernels.h"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include "kernels_impl.h"
+#endif
+
+namespace Sine::Graphics {
+    namespace Simd {
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+        extern const PixelKernels *const PIXEL_KERNELS_AVX512 = &PIXEL_KERNELS;
+#else
+        // Not compiled for this level
+        extern const PixelKernels *const PIXEL_KERNELS_AVX512 = nullptr;
+#endif
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef VISUALIZATION_KERNELS_IMPL_H
+#define VISUALIZATION_KERNELS_IMPL_H
+
+/*
+ * Portable definitions of the pixel kernels, included by each per-level translation unit and compiled there with that
+ * level's instruction set flags, so the compiler vectorizes the same loops to each vector width. Everything here has
+ * internal linkage, so the copies never collide. FMA is left out of every level so results match exactly across them;
+ * the build compiles these files with -ffp-contract=off, since AVX-512 flags would otherwise let the compiler fuse
+ * multiplies and adds.
+ */
+
+#include "kernels.h"
+
+namespace Sine::Graphics {
+    namespace Simd {
+        namespace {
+            void accumulate(float *__restrict__ sum, const float *__restrict__ in, float weight, size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    sum[i] += weight * in[i];
+                }
+            }
+
+            void accumulateFixed(int32_t *__restrict__ sum, const uint8_t *__restrict__ in, int32_t weight,
+                                 size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    sum[i] += weight * in[i];
+                }
+            }
+
+            void accumulateFixed16(int32_t *__restrict__ sum, const int16_t *__restrict__ in, int32_t weight,
+                                   size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    sum[i] += weight * in[i];
+                }
+            }
+
+            void derivative(float *__restrict__ out, const float *__restrict__ plus0, const float *__restrict__ minus0,
+                            const float *__restrict__ plus1, const float *__restrict__ minus1,
+                            const float *__restrict__ plus2, const float *__restrict__ minus2, float outer,
+                            float center, size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    out[i] = outer * (plus0[i] - minus0[i]) + center * (plus1[i] - minus1[i])
+                             + outer * (plus2[i] - minus2[i]);
+                }
+            }
+
+            void premultiply(int16_t *__restrict__ r, int16_t *__restrict__ g, int16_t *__restrict__ b,
+                             int16_t *__restrict__ a, const uint8_t *__restrict__ rgba, size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    const uint8_t *p = rgba + 4 * i;
+
+                    r[i] = static_cast<int16_t>(p[0] * p[3] - 32768);
+                    g[i] = static_cast<int16_t>(p[1] * p[3] - 32768);
+                    b[i] = static_cast<int16_t>(p[2] * p[3] - 32768);
+                    a[i] = p[3];
+                }
+            }
+
+            const PixelKernels PIXEL_KERNELS = {accumulate, accumulateFixed, accumulateFixed16, premultiply,
+                                                derivative};
+        }
+    }
+}
+
+#endif //VISUALIZATION_KERNELS_IMPL_H
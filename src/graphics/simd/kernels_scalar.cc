@@ -0,0 +1,7 @@
+#include "kernels_impl.h"
+
+namespace Sine::Graphics {
+    namespace Simd {
+        extern const PixelKernels *const PIXEL_KERNELS_SCALAR = &PIXEL_KERNELS;
+    }
+}
@@ -0,0 +1,16 @@
+#include "kernels.h"
+
+#if defined(__SSE2__)
+#include "kernels_impl.h"
+#endif
+
+namespace Sine::Graphics {
+    namespace Simd {
+#if defined(__SSE2__)
+        extern const PixelKernels *const PIXEL_KERNELS_SSE2 = &PIXEL_KERNELS;
+#else
+        // Not compiled for this level
+        extern const PixelKernels *const PIXEL_KERNELS_SSE2 = nullptr;
+#endif
+    }
+}
@@ -0,0 +1,147 @@
+#include <graphics/algorithms/circle.h>
+#include <graphics/algorithms/thickener.h>
+#include "supersampledcanvas.h"
+#include "graphics/algorithms/bezier.h"
+
+namespace Sine::Graphics {
+    SupersampledCanvas::SupersampledCanvas(int width, int height, int _factor) : Canvas(width * _factor,
+                                                                                         height * _factor) {
+        if (_factor < 1) {
+            throw std::invalid_argument("Supersampling factor must be positive.");
+        }
+
+        factor = _factor;
+        logicalWidth = width;
+        logicalHeight = height;
+    }
+
+    float SupersampledCanvas::scale(float v) const {
+        // Integer coordinates address pixel centers, so map the center of a logical pixel to the center of its block
+        return (v + 0.5f) * factor - 0.5f;
+    }
+
+    int SupersampledCanvas::getFactor() const {
+        return factor;
+    }
+
+    int SupersampledCanvas::getLogicalWidth() const {
+        return logicalWidth;
+    }
+
+    int SupersampledCanvas::getLogicalHeight() const {
+        return logicalHeight;
+    }
+
+    Canvas SupersampledCanvas::resolve() const {
+        return spatialAntialias(factor);
+    }
+
+    void SupersampledCanvas::resolveInto(Canvas &target) const {
+        if (target.getWidth() != logicalWidth || target.getHeight() != logicalHeight) {
+            throw std::invalid_argument("Target dimensions do not match logical dimensions.");
+        }
+
+        boxDownsample(target, factor);
+        target.markAllDirty();
+    }
+
+    void SupersampledCanvas::resolveInto(RGBMap &target, const RGB &background) const {
+        if (target.getWidth() != logicalWidth || target.getHeight() != logicalHeight) {
+            throw std::invalid_argument("Target dimensions do not match logical dimensions.");
+        }
+
+        boxDownsample(target, factor, background);
+    }
+
+    void SupersampledCanvas::exportResolved(const std::string &path, ImageType type, const RGB &background) const {
+        if (type == ImageType::UNKNOWN) type = extractImageType(path);
+
+        if (type == ImageType::UNKNOWN) {
+            throw std::invalid_argument("Unknown image type for " + path + ".");
+        }
+
+        if (type == ImageType::PNG) {
+            resolve().exportToFile(path, type);
+            return;
+        }
+
+        RGBMap opaque(logicalWidth, logicalHeight);
+        resolveInto(opaque, background);
+
+        opaque.exportToFile(path, type);
+    }
+
+    void SupersampledCanvas::drawLineAliased(float x1, float y1, float x2, float y2, const RGBA &color) {
+        Canvas::drawThickLineAliased(scale(x1), scale(y1), scale(x2), scale(y2), factor, color);
+    }
+
+    void SupersampledCanvas::drawLineAntialiased(float x1, float y1, float x2, float y2, const RGBA &color) {
+        drawLineAliased(x1, y1, x2, y2, color);
+    }
+
+    void SupersampledCanvas::drawThickLineAliased(float x1, float y1, float x2, float y2, float thickness,
+                                                  const RGBA &color) {
+        Canvas::drawThickLineAliased(scale(x1), scale(y1), scale(x2), scale(y2), thickness * factor, color);
+    }
+
+    void SupersampledCanvas::drawThickLineAntialiased(float x1, float y1, float x2, float y2, float thickness,
+                                                      const RGBA &color) {
+        drawThickLineAliased(x1, y1, x2, y2, thickness, color);
+    }
+
+    void SupersampledCanvas::drawQuadraticBezierAliased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                                        const RGBA &color) {
+        auto plot = [&](int x, int y) {
+            mergePixelNoThrow(x, y, color);
+        };
+
+        // A brush of radius factor / 2 keeps the curve about one logical pixel wide
+        if (factor > 1) {
+            Algorithms::drawQuadraticBezier(scale(x1), scale(y1), scale(x2), scale(y2), scale(x3), scale(y3),
+                                            Algorithms::thickenForwardAliasedDraw(plot, factor / 2));
+        } else {
+            Algorithms::drawQuadraticBezier(x1, y1, x2, y2, x3, y3, plot);
+        }
+    }
+
+    void SupersampledCanvas::drawQuadraticBezierAntialiased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                                            const RGBA &color) {
+        drawQuadraticBezierAliased(x1, y1, x2, y2, x3, y3, color);
+    }
+
+    void SupersampledCanvas::drawCircleAliased(float x1, float y1, int r, const RGBA &color) {
+        if (factor > 1) {
+            Canvas::drawThickCircleAliased(scale(x1), scale(y1), r * factor, factor / 2, color);
+        } else {
+            Canvas::drawCircleAliased(x1, y1, r, color);
+        }
+    }
+
+    void SupersampledCanvas::drawCircleAntialiased(float x1, float y1, float r, const RGBA &color) {
+        drawCircleAliased(x1, y1, std::lround(r), color);
+    }
+
+    void SupersampledCanvas::drawThickCircleAliased(float x1, float y1, int r, float thickness, const RGBA &color) {
+        Canvas::drawThickCircleAliased(scale(x1), scale(y1), r * factor, thickness * factor, color);
+    }
+
+    void SupersampledCanvas::drawFilledCircle(float x1, float y1, int r, const RGBA &color) {
+        Canvas::drawFilledCircle(scale(x1), scale(y1), r * factor, color);
+    }
+
+    void SupersampledCanvas::fillRect(int x1, int y1, int x2, int y2, const RGBA &color) {
+        Canvas::fillRect(x1 * factor, y1 * factor, x2 * factor, y2 * factor, color);
+    }
+
+    void SupersampledCanvas::fillPolygon(const std::vector<std::pair<float, float>> &points, const RGBA &color) {
+        std::vector<std::pair<float, float>> scaled;
+        scaled.reserve(points.size());
+
+        // Polygons sample continuous coordinates, so they scale without a pixel center offset
+        for (const auto &p : points) {
+            scaled.emplace_back(p.first * factor, p.second * factor);
+        }
+
+        Canvas::fillPolygon(scaled, color);
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef VISUALIZATION_SUPERSAMPLEDCANVAS_H
+#define VISUALIZATION_SUPERSAMPLEDCANVAS_H
+
+#include "canvas.h"
+
+namespace Sine::Graphics {
+    /**
+     * Canvas which renders at an integer multiple of its logical resolution and is box-filtered down by resolve().
+     *
+     * Drawing calls take logical coordinates and are scaled internally; every primitive is rasterized with the aliased
+     * algorithms, the supersampling providing the antialiasing. Lines and curves are widened by the factor so they
+     * keep their logical width. The Pixmap interface (getWidth, getPixel, mixImage, ...) works on the internal,
+     * supersampled pixels.
+     */
+    class SupersampledCanvas : public Canvas {
+    private:
+        int factor;
+
+        /*
+         * Logical dimensions.
+         */
+        int logicalWidth;
+        int logicalHeight;
+
+        /**
+         * Scales a logical coordinate to the center of the corresponding internal block.
+         */
+        float scale(float v) const;
+
+    public:
+        /**
+         * Constructor initializing blank SupersampledCanvas with logical dimensions width x height.
+         * @param width Logical width.
+         * @param height Logical height.
+         * @param factor Supersampling factor, e.g. 2 or 4.
+         */
+        SupersampledCanvas(int width, int height, int factor = 2);
+
+        /**
+         * Getter for supersampling factor.
+         * @return Supersampling factor.
+         */
+        int getFactor() const;
+
+        /**
+         * Getter for logical width.
+         * @return Width of the resolved canvas.
+         */
+        int getLogicalWidth() const;
+
+        /**
+         * Getter for logical height.
+         * @return Height of the resolved canvas.
+         */
+        int getLogicalHeight() const;
+
+        /**
+         * Downsamples to the logical resolution.
+         * @return Antialiased canvas.
+         */
+        Canvas resolve() const;
+
+        /**
+         * Downsamples to the logical resolution into an existing canvas, avoiding an allocation per frame.
+         * @param target Canvas of logical dimensions.
+         */
+        void resolveInto(Canvas &target) const;
+
+        /**
+         * Downsamples to the logical resolution and composites over a background in one pass, producing pixels
+         * ready for formats without alpha.
+         * @param target RGBMap of logical dimensions.
+         * @param background Color showing through transparent areas.
+         */
+        void resolveInto(RGBMap &target, const RGB &background = RGB(255, 255, 255)) const;
+
+        /**
+         * Downsamples to the logical resolution and exports the result. Formats without alpha (BMP, JPEG and the
+         * Netpbm formats) are resolved straight into opaque RGB over the background, skipping the intermediate RGBA
+         * canvas and its conversion; PNG keeps the alpha.
+         * @param path Path of the file.
+         * @param type Format, or ImageType::UNKNOWN to use the extension of the path.
+         * @param background Color showing through transparent areas in formats without alpha.
+         */
+        void exportResolved(const std::string &path, ImageType type = ImageType::UNKNOWN,
+                            const RGB &background = RGB(255, 255, 255)) const;
+
+        void drawLineAliased(float x1, float y1, float x2, float y2, const RGBA &color = Colors::BLACK) override;
+
+        void drawLineAntialiased(float x1, float y1, float x2, float y2, const RGBA &color = Colors::BLACK) override;
+
+        void drawThickLineAliased(float x1, float y1, float x2, float y2, float thickness,
+                                  const RGBA &color = Colors::BLACK) override;
+
+        void drawThickLineAntialiased(float x1, float y1, float x2, float y2, float thickness,
+                                      const RGBA &color = Colors::BLACK) override;
+
+        void drawQuadraticBezierAliased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                        const RGBA &color = Colors::BLACK) override;
+
+        void drawQuadraticBezierAntialiased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                            const RGBA &color = Colors::BLACK) override;
+
+        void drawCircleAliased(float x1, float y1, int r, const RGBA &color = Colors::BLACK) override;
+
+        void drawCircleAntialiased(float x1, float y1, float r, const RGBA &color = Colors::BLACK) override;
+
+        void drawThickCircleAliased(float x1, float y1, int r, float thickness, const RGBA &color) override;
+
+        void drawFilledCircle(float x1, float y1, int r, const RGBA &color = Colors::BLACK) override;
+
+        void fillRect(int x1, int y1, int x2, int y2, const RGBA &color) override;
+
+        void fillPolygon(const std::vector<std::pair<float, float>> &points, const RGBA &color) override;
+    };
+}
+
+#endif //VISUALIZATION_SUPERSAMPLEDCANVAS_H
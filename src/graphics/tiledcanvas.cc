@@ -0,0 +1,390 @@
+#include <graphics/algorithms/circle.h>
+#include <graphics/algorithms/thickener.h>
+#include <graphics/algorithms/polygon.h>
+#include "tiledcanvas.h"
+#include "graphics/algorithms/line.h"
+#include "graphics/algorithms/bezier.h"
+
+namespace Sine::Graphics {
+    TiledCanvas::TiledCanvas(int width, int height, int _tileSize) : Canvas(width, height) {
+        if (_tileSize < 1) {
+            throw std::invalid_argument("Tile size must be positive.");
+        }
+
+        tileSize = _tileSize;
+        tilesX = (width + tileSize - 1) / tileSize;
+        tilesY = (height + tileSize - 1) / tileSize;
+
+        bins.resize(tilesX * tilesY);
+    }
+
+    void TiledCanvas::submit(const Command &command, float x1, float y1, float x2, float y2) {
+        if (!std::isfinite(x1) || !std::isfinite(y1) || !std::isfinite(x2) || !std::isfinite(y2)) {
+            return; // Canvas draws nothing for degenerate input either
+        }
+
+        // Cull primitives that lie entirely outside the canvas
+        if (x2 < 0 || y2 < 0 || x1 >= width || y1 >= height) {
+            return;
+        }
+
+        markDirty(static_cast<int>(std::floor(x1)), static_cast<int>(std::floor(y1)),
+                  static_cast<int>(std::floor(x2)) + 1, static_cast<int>(std::floor(y2)) + 1);
+
+        Command c = command;
+
+        c.t_x1 = std::max(static_cast<int>(std::floor(x1)), 0) / tileSize;
+        c.t_y1 = std::max(static_cast<int>(std::floor(y1)), 0) / tileSize;
+        c.t_x2 = std::min(static_cast<int>(std::floor(x2)), width - 1) / tileSize;
+        c.t_y2 = std::min(static_cast<int>(std::floor(y2)), height - 1) / tileSize;
+
+        int index = commands.size();
+        commands.push_back(c);
+
+        for (int t_y = c.t_y1; t_y <= c.t_y2; t_y++) {
+            for (int t_x = c.t_x1; t_x <= c.t_x2; t_x++) {
+                bins[t_y * tilesX + t_x].push_back(index);
+            }
+        }
+    }
+
+    template<typename Func>
+    void TiledCanvas::emit(const Command &c, int r_x1, int r_y1, int r_x2, int r_y2, Func f) const {
+        const float *a = c.args;
+        const RGBA &color = c.color;
+
+        auto plot = [&](int x, int y) {
+            if (x >= r_x1 && x < r_x2 && y >= r_y1 && y < r_y2) {
+                f(x, y, color);
+            }
+        };
+
+        auto plotAntialiased = [&](int x, int y, uint8_t v) {
+            if (x >= r_x1 && x < r_x2 && y >= r_y1 && y < r_y2) {
+                f(x, y, RGBA(color.r, color.g, color.b, 255 - v));
+            }
+        };
+
+        switch (c.type) {
+            case CommandType::LINE_ALIASED:
+                Algorithms::drawBresenham(a[0], a[1], a[2], a[3], plot);
+                break;
+            case CommandType::LINE_ANTIALIASED:
+                Algorithms::drawXiaolin(a[0], a[1], a[2], a[3], plotAntialiased);
+                break;
+            case CommandType::THICK_LINE_ALIASED:
+                Algorithms::drawBresenhamThick(a[0], a[1], a[2], a[3], a[4], plot);
+                break;
+            case CommandType::THICK_LINE_ANTIALIASED:
+                Algorithms::drawXiaolinThick(a[0], a[1], a[2], a[3], a[4], plotAntialiased);
+                break;
+            case CommandType::QUADRATIC_BEZIER_ALIASED:
+                Algorithms::drawQuadraticBezier(a[0], a[1], a[2], a[3], a[4], a[5], plot);
+                break;
+            case CommandType::QUADRATIC_BEZIER_ANTIALIASED:
+                Algorithms::drawQuadraticBezierAntialiased(a[0], a[1], a[2], a[3], a[4], a[5], plotAntialiased);
+                break;
+            case CommandType::CIRCLE_ALIASED:
+                Algorithms::drawCircle(a[0], a[1], static_cast<int>(a[2]), plot);
+                break;
+            case CommandType::CIRCLE_ANTIALIASED:
+                Algorithms::drawCircleAntialiased(a[0], a[1], a[2], plotAntialiased);
+                break;
+            case CommandType::THICK_CIRCLE_ALIASED:
+                Algorithms::drawCircle(a[0], a[1], static_cast<int>(a[2]),
+                                       Algorithms::thickenForwardAliasedDraw(plot, a[3]));
+                break;
+            case CommandType::FILLED_CIRCLE:
+                Algorithms::drawFilledCircle(a[0], a[1], static_cast<int>(a[2]), plot);
+                break;
+            case CommandType::RECT: {
+                int x1 = a[0], y1 = a[1], x2 = a[2], y2 = a[3];
+
+                for (int i = std::max(std::min(x1, x2), r_x1); i < std::min(std::max(x1, x2), r_x2); i++) {
+                    for (int j = std::max(std::min(y1, y2), r_y1); j < std::min(std::max(y1, y2), r_y2); j++) {
+                        f(i, j, color);
+                    }
+                }
+                break;
+            }
+            case CommandType::POLYGON:
+                Algorithms::drawMaskedFilledPolygon(polygons[c.polygon], r_x1, r_y1, r_x2, r_y2,
+                                                    [&](int x, int y) {
+                                                        f(x, y, color);
+                                                    });
+                break;
+        }
+    }
+
+    void TiledCanvas::prerasterize(const Command &c, std::vector<Fragment> &fragments,
+                                   std::vector<int> &offsets) const {
+        int spanX = c.t_x2 - c.t_x1 + 1;
+        int spanY = c.t_y2 - c.t_y1 + 1;
+
+        std::vector<Fragment> raw;
+        std::vector<int> tiles;
+
+        emit(c, 0, 0, width, height, [&](int x, int y, const RGBA &color) {
+            int t_x = x / tileSize - c.t_x1;
+            int t_y = y / tileSize - c.t_y1;
+
+            if (t_x >= 0 && t_x < spanX && t_y >= 0 && t_y < spanY) {
+                raw.push_back({x, y, color});
+                tiles.push_back(t_y * spanX + t_x);
+            }
+        });
+
+        // Stable counting sort by tile, so each tile sees its fragments in rasterization order
+        offsets.assign(spanX * spanY + 1, 0);
+
+        for (int t : tiles) {
+            offsets[t + 1]++;
+        }
+
+        for (size_t i = 1; i < offsets.size(); i++) {
+            offsets[i] += offsets[i - 1];
+        }
+
+        fragments.resize(raw.size());
+        std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+
+        for (size_t i = 0; i < raw.size(); i++) {
+            fragments[cursor[tiles[i]]++] = raw[i];
+        }
+    }
+
+    void TiledCanvas::flush() {
+        flush(Parallel::threadCount());
+    }
+
+    void TiledCanvas::flush(unsigned int threads) {
+        if (commands.empty()) return;
+
+        // Primitives spanning several tiles are rasterized once up front instead of once per tile; rectangles and
+        // polygons clip cheaply, so they are always rasterized per tile
+        std::vector<int> shared;
+
+        for (size_t i = 0; i < commands.size(); i++) {
+            const Command &c = commands[i];
+
+            if ((c.t_x1 != c.t_x2 || c.t_y1 != c.t_y2) && c.type != CommandType::RECT &&
+                c.type != CommandType::POLYGON) {
+                shared.push_back(i);
+            }
+        }
+
+        std::vector<std::vector<Fragment>> fragments(commands.size());
+        std::vector<std::vector<int>> offsets(commands.size());
+
+        Parallel::parallelFor(0, shared.size(), [&](int k) {
+            int i = shared[k];
+            prerasterize(commands[i], fragments[i], offsets[i]);
+        }, threads);
+
+        std::vector<int> busyTiles;
+
+        for (int i = 0; i < tilesX * tilesY; i++) {
+            if (!bins[i].empty()) {
+                busyTiles.push_back(i);
+            }
+        }
+
+        Parallel::parallelFor(0, busyTiles.size(), [&](int k) {
+            int tile = busyTiles[k];
+            int t_x = tile % tilesX;
+            int t_y = tile / tilesX;
+
+            int r_x1 = t_x * tileSize;
+            int r_y1 = t_y * tileSize;
+            int r_x2 = std::min(r_x1 + tileSize, width);
+            int r_y2 = std::min(r_y1 + tileSize, height);
+
+            // Tiles never overlap, so no two threads write the same pixel
+            auto blend = [this](int x, int y, const RGBA &color) {
+                RGBA &p = getPixelUnsafe(x, y);
+                p = ColorUtils::merge(color, p);
+            };
+
+            for (int index : bins[tile]) {
+                const Command &c = commands[index];
+
+                if (offsets[index].empty()) {
+                    emit(c, r_x1, r_y1, r_x2, r_y2, blend);
+                } else {
+                    int local = (t_y - c.t_y1) * (c.t_x2 - c.t_x1 + 1) + (t_x - c.t_x1);
+
+                    for (int f = offsets[index][local]; f < offsets[index][local + 1]; f++) {
+                        const Fragment &frag = fragments[index][f];
+                        blend(frag.x, frag.y, frag.color);
+                    }
+                }
+            }
+        }, threads);
+
+        resetBins();
+    }
+
+    void TiledCanvas::discard() {
+        resetBins();
+    }
+
+    void TiledCanvas::resetBins() {
+        commands.clear();
+        polygons.clear();
+
+        for (auto &bin : bins) {
+            bin.clear();
+        }
+    }
+
+    size_t TiledCanvas::pendingCount() const {
+        return commands.size();
+    }
+
+    int TiledCanvas::getTileSize() const {
+        return tileSize;
+    }
+
+    // Lines are trimmed exactly like the masked Canvas rasterizers do, and binned by the trimmed segment
+
+    void TiledCanvas::drawLineAliased(float x1, float y1, float x2, float y2, const RGBA &color) {
+        auto line = Algorithms::trimLine(static_cast<int>(x1), static_cast<int>(y1), static_cast<int>(x2),
+                                         static_cast<int>(y2), 0, 0, width, height);
+        if (Algorithms::rejectLine(line)) return;
+
+        auto[n_x1, n_y1, n_x2, n_y2] = line;
+
+        submit({CommandType::LINE_ALIASED, color, {n_x1, n_y1, n_x2, n_y2}},
+               std::min(n_x1, n_x2) - 1, std::min(n_y1, n_y2) - 1, std::max(n_x1, n_x2) + 1,
+               std::max(n_y1, n_y2) + 1);
+    }
+
+    void TiledCanvas::drawLineAntialiased(float x1, float y1, float x2, float y2, const RGBA &color) {
+        auto line = Algorithms::trimLine(static_cast<int>(x1), static_cast<int>(y1), static_cast<int>(x2),
+                                         static_cast<int>(y2), -1, -1, width + 1, height + 1);
+        if (Algorithms::rejectLine(line)) return;
+
+        auto[n_x1, n_y1, n_x2, n_y2] = line;
+
+        submit({CommandType::LINE_ANTIALIASED, color, {n_x1, n_y1, n_x2, n_y2}},
+               std::min(n_x1, n_x2) - 2, std::min(n_y1, n_y2) - 2, std::max(n_x1, n_x2) + 2,
+               std::max(n_y1, n_y2) + 2);
+    }
+
+    void TiledCanvas::drawThickLineAliased(float x1, float y1, float x2, float y2, float thickness,
+                                           const RGBA &color) {
+        auto line = Algorithms::trimLine(static_cast<int>(x1), static_cast<int>(y1), static_cast<int>(x2),
+                                         static_cast<int>(y2), -thickness, -thickness, width + thickness,
+                                         height + thickness);
+        if (Algorithms::rejectLine(line)) return;
+
+        auto[n_x1, n_y1, n_x2, n_y2] = line;
+        float margin = thickness + 2;
+
+        submit({CommandType::THICK_LINE_ALIASED, color, {n_x1, n_y1, n_x2, n_y2, thickness}},
+               std::min(n_x1, n_x2) - margin, std::min(n_y1, n_y2) - margin,
+               std::max(n_x1, n_x2) + margin, std::max(n_y1, n_y2) + margin);
+    }
+
+    void TiledCanvas::drawThickLineAntialiased(float x1, float y1, float x2, float y2, float thickness,
+                                               const RGBA &color) {
+        auto line = Algorithms::trimLine(static_cast<int>(x1), static_cast<int>(y1), static_cast<int>(x2),
+                                         static_cast<int>(y2), -thickness, -thickness, width + thickness,
+                                         height + thickness);
+        if (Algorithms::rejectLine(line)) return;
+
+        auto[n_x1, n_y1, n_x2, n_y2] = line;
+        float margin = thickness + 2;
+
+        submit({CommandType::THICK_LINE_ANTIALIASED, color, {n_x1, n_y1, n_x2, n_y2, thickness}},
+               std::min(n_x1, n_x2) - margin, std::min(n_y1, n_y2) - margin,
+               std::max(n_x1, n_x2) + margin, std::max(n_y1, n_y2) + margin);
+    }
+
+    // Curves are binned by the pixels the rasterizer actually plots, which can lie outside the control hull
+
+    void TiledCanvas::drawQuadraticBezierAliased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                                 const RGBA &color) {
+        auto[b_x1, b_y1, b_x2, b_y2] = Algorithms::quadraticBezierExtent(x1, y1, x2, y2, x3, y3, false);
+        if (b_x1 > b_x2) return;
+
+        submit({CommandType::QUADRATIC_BEZIER_ALIASED, color, {x1, y1, x2, y2, x3, y3}}, b_x1, b_y1, b_x2, b_y2);
+    }
+
+    void TiledCanvas::drawQuadraticBezierAntialiased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                                     const RGBA &color) {
+        auto[b_x1, b_y1, b_x2, b_y2] = Algorithms::quadraticBezierExtent(x1, y1, x2, y2, x3, y3, true);
+        if (b_x1 > b_x2) return;
+
+        submit({CommandType::QUADRATIC_BEZIER_ANTIALIASED, color, {x1, y1, x2, y2, x3, y3}}, b_x1, b_y1, b_x2, b_y2);
+    }
+
+    void TiledCanvas::drawCircleAliased(float x1, float y1, int r, const RGBA &color) {
+        float margin = std::abs(r) + 1;
+
+        submit({CommandType::CIRCLE_ALIASED, color, {x1, y1, static_cast<float>(r)}},
+               x1 - margin, y1 - margin, x1 + margin, y1 + margin);
+    }
+
+    void TiledCanvas::drawCircleAntialiased(float x1, float y1, float r, const RGBA &color) {
+        float margin = std::abs(r) + 2;
+
+        submit({CommandType::CIRCLE_ANTIALIASED, color, {x1, y1, r}},
+               x1 - margin, y1 - margin, x1 + margin, y1 + margin);
+    }
+
+    void TiledCanvas::drawThickCircleAliased(float x1, float y1, int r, float thickness, const RGBA &color) {
+        float margin = std::abs(r) + std::abs(thickness) + 2;
+
+        submit({CommandType::THICK_CIRCLE_ALIASED, color, {x1, y1, static_cast<float>(r), thickness}},
+               x1 - margin, y1 - margin, x1 + margin, y1 + margin);
+    }
+
+    void TiledCanvas::drawFilledCircle(float x1, float y1, int r, const RGBA &color) {
+        float margin = std::abs(r) + 1;
+
+        submit({CommandType::FILLED_CIRCLE, color, {x1, y1, static_cast<float>(r)}},
+               x1 - margin, y1 - margin, x1 + margin, y1 + margin);
+    }
+
+    void TiledCanvas::fillRect(int x1, int y1, int x2, int y2, const RGBA &color) {
+        if (x1 == x2 || y1 == y2) return;
+
+        // The rectangle is half-open, so the last column and row are not covered
+        submit({CommandType::RECT, color,
+                {static_cast<float>(x1), static_cast<float>(y1), static_cast<float>(x2), static_cast<float>(y2)}},
+               std::min(x1, x2), std::min(y1, y2), std::max(x1, x2) - 1, std::max(y1, y2) - 1);
+    }
+
+    void TiledCanvas::fillPolygon(const std::vector<std::pair<float, float>> &points, const RGBA &color) {
+        if (points.size() < 3) return;
+
+        float x1 = points[0].first, y1 = points[0].second;
+        float x2 = x1, y2 = y1;
+
+        for (const auto &p : points) {
+            x1 = std::min(x1, p.first);
+            y1 = std::min(y1, p.second);
+            x2 = std::max(x2, p.first);
+            y2 = std::max(y2, p.second);
+        }
+
+        size_t pending = commands.size();
+
+        submit({CommandType::POLYGON, color, {}, polygons.size()}, x1 - 1, y1 - 1, x2 + 1, y2 + 1);
+
+        if (commands.size() != pending) { // Only keep the vertices if the polygon was not culled
+            polygons.push_back(points);
+        }
+    }
+
+    void TiledCanvas::fill(Color color) {
+        discard();
+        Canvas::fill(color);
+    }
+
+    void TiledCanvas::fuzz() {
+        flush();
+        Canvas::fuzz();
+    }
+}
@@ -0,0 +1,176 @@
+#ifndef VISUALIZATION_TILEDCANVAS_H
+#define VISUALIZATION_TILEDCANVAS_H
+
+#include "canvas.h"
+#include "parallel.h"
+
+namespace Sine::Graphics {
+    /**
+     * Canvas which defers drawing: primitives are binned into square screen tiles and rasterized in parallel on flush().
+     *
+     * Every tile is owned by exactly one thread while flushing and primitives are replayed in submission order within
+     * each tile, so the output is identical to drawing on a plain Canvas. Pixel reads (getPixel, export, mixImage, filters,
+     * ...) do not flush automatically; call flush() first.
+     */
+    class TiledCanvas : public Canvas {
+    public:
+        /**
+         * Kind of a deferred primitive.
+         */
+        enum class CommandType : uint8_t {
+            LINE_ALIASED,
+            LINE_ANTIALIASED,
+            THICK_LINE_ALIASED,
+            THICK_LINE_ANTIALIASED,
+            QUADRATIC_BEZIER_ALIASED,
+            QUADRATIC_BEZIER_ANTIALIASED,
+            CIRCLE_ALIASED,
+            CIRCLE_ANTIALIASED,
+            THICK_CIRCLE_ALIASED,
+            FILLED_CIRCLE,
+            RECT,
+            POLYGON
+        };
+
+    private:
+        /**
+         * A deferred primitive; args holds the parameters of the corresponding Canvas call in order, with lines
+         * already trimmed to the canvas.
+         */
+        struct Command {
+            CommandType type;
+            RGBA color;
+            float args[6];
+            size_t polygon = 0; ///< Index into polygons of a POLYGON command, kept exact unlike a float argument
+
+            /*
+             * Range of tiles the command was binned into, inclusive.
+             */
+            int t_x1 = 0, t_y1 = 0, t_x2 = 0, t_y2 = 0;
+        };
+
+        /**
+         * A pixel produced by pre-rasterizing a command, with the color to merge into it.
+         */
+        struct Fragment {
+            int x;
+            int y;
+            RGBA color;
+        };
+
+        std::vector<Command> commands;
+
+        /*
+         * Vertex lists of POLYGON commands, indexed by Command::polygon.
+         */
+        std::vector<std::vector<std::pair<float, float>>> polygons;
+
+        /*
+         * Indices into commands for every tile, in submission order.
+         */
+        std::vector<std::vector<int>> bins;
+
+        int tileSize;
+        int tilesX;
+        int tilesY;
+
+        /**
+         * Bins a command into every tile its bounding box (x1, y1) -- (x2, y2) touches, and marks that box dirty.
+         */
+        void submit(const Command &command, float x1, float y1, float x2, float y2);
+
+        /**
+         * Runs the rasterizer of a command, calling f(x, y, color) for every pixel in [x1, x2) x [y1, y2).
+         */
+        template<typename Func>
+        void emit(const Command &command, int x1, int y1, int x2, int y2, Func f) const;
+
+        /**
+         * Rasterizes a command once, bucketing the fragments by tile in the order they were produced.
+         * @param command Command to rasterize.
+         * @param fragments Output fragments.
+         * @param offsets Output offsets into fragments, one per tile of the command plus one.
+         */
+        void prerasterize(const Command &command, std::vector<Fragment> &fragments, std::vector<int> &offsets) const;
+
+        void resetBins();
+
+    public:
+        /**
+         * Constructor initializing blank TiledCanvas with dimensions width x height.
+         * @param width Canvas width.
+         * @param height Canvas height.
+         * @param tileSize Side length of a tile in pixels.
+         */
+        TiledCanvas(int width, int height, int tileSize = 64);
+
+        /**
+         * Rasterizes all pending primitives, distributing tiles across the default number of threads.
+         */
+        void flush() override;
+
+        /**
+         * Rasterizes all pending primitives, distributing tiles across threads.
+         * @param threads Maximum number of threads to use.
+         */
+        void flush(unsigned int threads);
+
+        /**
+         * Drops all pending primitives without drawing them.
+         */
+        void discard();
+
+        /**
+         * Number of primitives waiting for flush().
+         * @return Pending primitive count.
+         */
+        size_t pendingCount() const;
+
+        /**
+         * Getter for tile size.
+         * @return Side length of a tile in pixels.
+         */
+        int getTileSize() const;
+
+        void drawLineAliased(float x1, float y1, float x2, float y2, const RGBA &color = Colors::BLACK) override;
+
+        void drawLineAntialiased(float x1, float y1, float x2, float y2, const RGBA &color = Colors::BLACK) override;
+
+        void drawThickLineAliased(float x1, float y1, float x2, float y2, float thickness,
+                                  const RGBA &color = Colors::BLACK) override;
+
+        void drawThickLineAntialiased(float x1, float y1, float x2, float y2, float thickness,
+                                      const RGBA &color = Colors::BLACK) override;
+
+        void drawQuadraticBezierAliased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                        const RGBA &color = Colors::BLACK) override;
+
+        void drawQuadraticBezierAntialiased(float x1, float y1, float x2, float y2, float x3, float y3,
+                                            const RGBA &color = Colors::BLACK) override;
+
+        void drawCircleAliased(float x1, float y1, int r, const RGBA &color = Colors::BLACK) override;
+
+        void drawCircleAntialiased(float x1, float y1, float r, const RGBA &color = Colors::BLACK) override;
+
+        void drawThickCircleAliased(float x1, float y1, int r, float thickness, const RGBA &color) override;
+
+        void drawFilledCircle(float x1, float y1, int r, const RGBA &color = Colors::BLACK) override;
+
+        void fillRect(int x1, int y1, int x2, int y2, const RGBA &color) override;
+
+        void fillPolygon(const std::vector<std::pair<float, float>> &points, const RGBA &color) override;
+
+        /**
+         * Fills the entire canvas, dropping pending primitives since they would be overwritten anyway.
+         * @param color Color fill.
+         */
+        void fill(Color color) override;
+
+        /**
+         * Flushes, then blurs.
+         */
+        void fuzz() override;
+    };
+}
+
+#endif //VISUALIZATION_TILEDCANVAS_H
@@ -0,0 +1,243 @@
+#include "fft.h"
+#include "mathutils.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace Sine {
+    namespace Math {
+        namespace {
+            /**
+             * Returns a shared plan from a cache, building it on first use.
+             */
+            template<typename Plan>
+            std::shared_ptr<const Plan> cachedPlan(int n) {
+                static std::mutex mutex;
+                static std::map<int, std::shared_ptr<const Plan>> plans;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                std::shared_ptr<const Plan> &plan = plans[n];
+
+                if (!plan) plan = std::make_shared<const Plan>(n);
+
+                return plan;
+            }
+        }
+
+        FFT::FFT(int _n) : n(_n) {
+            if (n < 1) {
+                throw std::invalid_argument("FFT length must be positive.");
+            }
+
+            int rest = n;
+
+            while (rest % 4 == 0) {
+                factors.push_back(4);
+                rest /= 4;
+            }
+
+            for (int p = 2; rest > 1; p++) {
+                while (rest % p == 0) {
+                    factors.push_back(p);
+                    rest /= p;
+                }
+
+                if (p * p > rest && rest > 1) {
+                    factors.push_back(rest);
+                    break;
+                }
+            }
+
+            twiddles.resize(n);
+
+            for (int i = 0; i < n; i++) {
+                double angle = -2 * MathUtils::PI * i / n;
+                twiddles[i] = Complex(std::cos(angle), std::sin(angle));
+            }
+        }
+
+        std::shared_ptr<const FFT> FFT::cached(int n) {
+            return cachedPlan<FFT>(n);
+        }
+
+        int FFT::size() const {
+            return n;
+        }
+
+        void FFT::transform(const Complex *in, Complex *out, int stride, size_t factor, bool inverse) const {
+            int p = factors[factor];
+            int length = n / stride;
+            int m = length / p;
+
+            // Decimation in time: transform the p interleaved subsequences, then combine them
+            if (m == 1) {
+                for (int q = 0; q < p; q++) {
+                    out[q] = in[q * stride];
+                }
+            } else {
+                for (int q = 0; q < p; q++) {
+                    transform(in + q * stride, out + q * m, stride * p, factor + 1, inverse);
+                }
+            }
+
+            auto twiddle = [&](long long e) {
+                const Complex &w = twiddles[e % length * stride];
+                return inverse ? std::conj(w) : w;
+            };
+
+            if (p == 2) {
+                for (int k = 0; k < m; k++) {
+                    Complex a = out[k];
+                    Complex b = out[k + m] * twiddle(k);
+
+                    out[k] = a + b;
+                    out[k + m] = a - b;
+                }
+            } else if (p == 4) {
+                Complex rotation = inverse ? Complex(0, 1) : Complex(0, -1);
+
+                for (int k = 0; k < m; k++) {
+                    Complex a0 = out[k];
+                    Complex a1 = out[k + m] * twiddle(k);
+                    Complex a2 = out[k + 2 * m] * twiddle(2LL * k);
+                    Complex a3 = out[k + 3 * m] * twiddle(3LL * k);
+
+                    Complex t0 = a0 + a2;
+                    Complex t1 = a0 - a2;
+                    Complex t2 = a1 + a3;
+                    Complex t3 = (a1 - a3) * rotation;
+
+                    out[k] = t0 + t2;
+                    out[k + m] = t1 + t3;
+                    out[k + 2 * m] = t0 - t2;
+                    out[k + 3 * m] = t1 - t3;
+                }
+            } else {
+                std::vector<Complex> tmp(p);
+
+                for (int k = 0; k < m; k++) {
+                    for (int q = 0; q < p; q++) {
+                        tmp[q] = out[q * m + k];
+                    }
+
+                    for (int j = 0; j < p; j++) {
+                        long long index = j * m + k;
+                        Complex sum = tmp[0];
+
+                        for (int q = 1; q < p; q++) {
+                            sum += tmp[q] * twiddle(q * index);
+                        }
+
+                        out[j * m + k] = sum;
+                    }
+                }
+            }
+        }
+
+        void FFT::forward(const Complex *in, Complex *out) const {
+            if (n == 1) {
+                out[0] = in[0];
+                return;
+            }
+
+            transform(in, out, 1, 0, false);
+        }
+
+        void FFT::inverse(const Complex *in, Complex *out) const {
+            if (n == 1) {
+                out[0] = in[0];
+                return;
+            }
+
+            transform(in, out, 1, 0, true);
+
+            float scale = 1.0f / n;
+            for (int i = 0; i < n; i++) {
+                out[i] *= scale;
+            }
+        }
+
+        RealFFT::RealFFT(int _n) : n(_n) {
+            if (n < 2 || n % 2 != 0) {
+                throw std::invalid_argument("Real FFT length must be even and positive.");
+            }
+
+            half = FFT::cached(n / 2);
+            twiddles.resize(n / 2 + 1);
+
+            for (int k = 0; k <= n / 2; k++) {
+                double angle = -2 * MathUtils::PI * k / n;
+                twiddles[k] = Complex(std::cos(angle), std::sin(angle));
+            }
+        }
+
+        std::shared_ptr<const RealFFT> RealFFT::cached(int n) {
+            return cachedPlan<RealFFT>(n);
+        }
+
+        int RealFFT::size() const {
+            return n;
+        }
+
+        void RealFFT::forward(const float *in, Complex *out) const {
+            int h = n / 2;
+            std::vector<Complex> z(h);
+            std::vector<Complex> spectrum(h);
+
+            for (int k = 0; k < h; k++) {
+                z[k] = Complex(in[2 * k], in[2 * k + 1]);
+            }
+
+            half->forward(z.data(), spectrum.data());
+
+            // Split into the transforms of the even and odd samples, then combine them
+            for (int k = 0; k <= h; k++) {
+                Complex a = spectrum[k % h];
+                Complex b = std::conj(spectrum[(h - k) % h]);
+
+                Complex even = (a + b) * 0.5f;
+                Complex odd = (a - b) * Complex(0, -0.5f);
+
+                out[k] = even + twiddles[k] * odd;
+            }
+        }
+
+        void RealFFT::inverse(const Complex *in, float *out) const {
+            int h = n / 2;
+            std::vector<Complex> spectrum(h);
+            std::vector<Complex> z(h);
+
+            for (int k = 0; k < h; k++) {
+                Complex a = in[k];
+                Complex b = std::conj(in[h - k]);
+
+                Complex even = (a + b) * 0.5f;
+                Complex odd = (a - b) * 0.5f * std::conj(twiddles[k]);
+
+                spectrum[k] = even + Complex(0, 1) * odd;
+            }
+
+            half->inverse(spectrum.data(), z.data());
+
+            for (int k = 0; k < h; k++) {
+                out[2 * k] = z[k].real();
+                out[2 * k + 1] = z[k].imag();
+            }
+        }
+
+        int nextFastFFTSize(int n) {
+            for (int m = std::max(n, 2);; m++) {
+                if (m % 2 != 0) continue;
+
+                int rest = m;
+                for (int p : {2, 3, 5}) {
+                    while (rest % p == 0) rest /= p;
+                }
+
+                if (rest == 1) return m;
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef VISUALIZATION_FFT_H
+#define VISUALIZATION_FFT_H
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace Sine {
+    namespace Math {
+        /**
+         * Mixed-radix complex fast Fourier transform of a fixed length.
+         *
+         * The length is factored into radices 4, 2, 3 and 5, with any remaining prime factors handled by a generic
+         * O(p^2) butterfly, so lengths of the form 2^a 3^b 5^c are fastest. Plans hold only the factorization and
+         * twiddle factors and may be shared between threads.
+         */
+        class FFT {
+        public:
+            using Complex = std::complex<float>;
+
+        private:
+            int n;
+            std::vector<int> factors;
+            std::vector<Complex> twiddles;
+
+            void transform(const Complex *in, Complex *out, int stride, size_t factor, bool inverse) const;
+
+        public:
+            /**
+             * Constructor.
+             * @param n Transform length, at least 1.
+             */
+            explicit FFT(int n);
+
+            /**
+             * Returns a plan of the given length, shared with earlier callers asking for the same length.
+             * @param n Transform length.
+             * @return Shared plan.
+             */
+            static std::shared_ptr<const FFT> cached(int n);
+
+            /**
+             * Getter for length.
+             * @return Transform length.
+             */
+            int size() const;
+
+            /**
+             * Forward transform, X[k] = sum x[j] e^(-2 pi i jk / n).
+             * @param in Input of n values.
+             * @param out Output of n values, which must not overlap the input.
+             */
+            void forward(const Complex *in, Complex *out) const;
+
+            /**
+             * Inverse transform, scaled by 1 / n so it undoes forward.
+             * @param in Input of n values.
+             * @param out Output of n values, which must not overlap the input.
+             */
+            void inverse(const Complex *in, Complex *out) const;
+        };
+
+        /**
+         * Fast Fourier transform of real data of a fixed, even length, computed as a complex transform of half the
+         * length. Only the n / 2 + 1 non-redundant outputs are produced.
+         */
+        class RealFFT {
+        public:
+            using Complex = FFT::Complex;
+
+        private:
+            int n;
+            std::shared_ptr<const FFT> half;
+            std::vector<Complex> twiddles;
+
+        public:
+            /**
+             * Constructor.
+             * @param n Transform length, even and at least 2.
+             */
+            explicit RealFFT(int n);
+
+            /**
+             * Returns a plan of the given length, shared with earlier callers asking for the same length.
+             * @param n Transform length.
+             * @return Shared plan.
+             */
+            static std::shared_ptr<const RealFFT> cached(int n);
+
+            /**
+             * Getter for length.
+             * @return Transform length.
+             */
+            int size() const;
+
+            /**
+             * Forward transform.
+             * @param in Input of n real values.
+             * @param out Output of n / 2 + 1 values.
+             */
+            void forward(const float *in, Complex *out) const;
+
+            /**
+             * Inverse transform, scaled by 1 / n so it undoes forward.
+             * @param in Input of n / 2 + 1 values.
+             * @param out Output of n real values.
+             */
+            void inverse(const Complex *in, float *out) const;
+        };
+
+        /**
+         * Smallest even length at least n with no prime factors above 5, which FFT handles fastest.
+         * @param n Minimum length.
+         * @return Transform length.
+         */
+        int nextFastFFTSize(int n);
+    }
+}
+
+#endif //VISUALIZATION_FFT_H
@@ -20,7 +20,14 @@ namespace Sine::Math {
     }
 
     void Polygon::fillDraw(Graphics::Canvas &c, Graphics::Pen &pen) {
+        std::vector<std::pair<float, float>> vertices;
+        vertices.reserve(points.size());
 
+        for (const Vec2d &a : points) {
+            vertices.emplace_back(a.x, a.y);
+        }
+
+        c.fillPolygon(vertices, pen.fillcolor);
     }
 
 }
\ No newline at end of file